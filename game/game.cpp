@@ -8,23 +8,102 @@
 #include <CLI/App.hpp>
 #include <CLI/Config.hpp>
 #include <CLI/Formatter.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
 #include <rglike/rglike.hpp>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/spdlog.h>
 
 auto main(int argc, char** argv) -> int {
     std::string log_filename = "log.txt";
+    uint64_t seed = std::random_device{}();
+    bool generate_only = false;
+    bool headless = false;
+    std::string record_path;
+    std::string replay_path;
+    rglike::GenerationOptions generation{};
+    rglike::SimulationOptions simulation{};
 
     CLI::App app{"A small roguelike."};
 
     app.add_option("-l,--log", log_filename, "The file to use for logging");
+    app.add_option("-s,--seed", seed, "The seed to generate levels from");
+    app.add_flag(
+        "--generate-only", generate_only, "Generate a level, report how long it took, and exit"
+    );
+    app.add_option("--width", generation.width, "Level width for --generate-only");
+    app.add_option("--height", generation.height, "Level height for --generate-only");
+    app.add_option("--threads", generation.threads, "Worker threads for --generate-only");
+    app.add_flag(
+        "--headless", headless,
+        "Simulate turns without a terminal, report how long they took, and exit"
+    );
+    app.add_option("--turns", simulation.turns, "Player turns to simulate with --headless");
+    app.add_option("--actors", simulation.actors, "Monsters to spawn with --headless");
+    app.add_option("--record", record_path, "Record the game's input to a replay file");
+    app.add_option(
+        "--replay", replay_path,
+        "Play back a recorded game without a terminal, check it ends the same way, and exit"
+    );
 
     CLI11_PARSE(app, argc, argv);
 
     auto logger = spdlog::basic_logger_mt("basic_logger", log_filename);
     spdlog::set_default_logger(logger);
 
+    if (generate_only) {
+        generation.seed = seed;
+        auto report = rglike::GenerateLevel(generation);
+        std::cout << "Generated " << report.width << "x" << report.height << " level from seed "
+                  << seed << " on " << report.workers << " worker(s) in " << report.milliseconds
+                  << " ms\n"
+                  << "  floor tiles: " << report.floor_tiles << "\n"
+                  << "  checksum:    " << std::hex << report.checksum << std::dec << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    if (headless) {
+        simulation.seed = seed;
+        auto report = rglike::RunSimulation(simulation);
+        std::cout << "Simulated " << report.turns << " turns (" << report.actor_turns
+                  << " monster turns) from seed " << seed << " in " << report.seconds << " s\n"
+                  << "  turns/s: " << report.TurnsPerSecond() << "\n";
+        for (const auto& system : report.systems) {
+            std::cout << "  " << system.name << ": " << report.MicrosecondsPerTurn(system)
+                      << " us/turn\n";
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (!replay_path.empty()) {
+        auto report = rglike::RunReplay(replay_path);
+        if (!report) {
+            std::cerr << "Could not read replay " << replay_path << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Replayed " << report->events << " events (" << report->actor_turns
+                  << " monster turns) from seed " << report->seed << " in " << report->seconds
+                  << " s\n"
+                  << "  events/s: " << report->EventsPerSecond() << "\n"
+                  << std::hex << std::setfill('0') << "  final state:    " << std::setw(16)
+                  << report->final_hash << "\n";
+        if (report->expected_hash) {
+            std::cout << "  recorded state: " << std::setw(16) << *report->expected_hash << "\n";
+        } else {
+            std::cout << "  recorded state: none (the session did not end cleanly)\n";
+        }
+        std::cout << std::dec;
+        if (!report->Matches()) {
+            std::cerr << "Replay diverged from the recorded game\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     rglike::Game game{};
+    game.SetSeed(seed);
+    game.SetRecordPath(record_path);
     game.Initialize();
     game.Run();
 
@@ -8,79 +8,158 @@
 
 #include "../target/fluency_ffi.hpp"
 
+#include <list>
+#include <memory>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
 
 // TODO: Smart pointers?
 
 namespace fluency {
+    /// @brief Arguments for a message. Values are kept on this side of the FFI until a message
+    /// is actually formatted with them, so a cache hit never crosses into Rust.
     class FluencyArgs {
     private:
-        ffi::FluencyArgs* m_args = nullptr;
+        /// @brief A string that Fluent should read as a number if it can.
+        struct TryNumber {
+            std::string text;
+        };
+
+        using Value = std::variant<
+            uint8_t, uint16_t, uint32_t, uint64_t, int8_t, int16_t, int32_t, int64_t, float, double,
+            std::string, TryNumber>;
+
+        std::vector<std::pair<std::string, Value>> m_values;
+        /// @brief Built from m_values the first time it's needed.
+        mutable ffi::FluencyArgs* m_args = nullptr;
+
+        static void apply(ffi::FluencyArgs* args, const std::string& key, const Value& value) {
+            std::visit(
+                [&](const auto& v) {
+                    using T = std::decay_t<decltype(v)>;
+                    if constexpr (std::is_same_v<T, uint8_t>) {
+                        ffi::set_arg_u8(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, uint16_t>) {
+                        ffi::set_arg_u16(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, uint32_t>) {
+                        ffi::set_arg_u32(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, uint64_t>) {
+                        ffi::set_arg_u64(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, int8_t>) {
+                        ffi::set_arg_i8(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, int16_t>) {
+                        ffi::set_arg_i16(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, int32_t>) {
+                        ffi::set_arg_i32(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, int64_t>) {
+                        ffi::set_arg_i64(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, float>) {
+                        ffi::set_arg_f32(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, double>) {
+                        ffi::set_arg_f64(args, key.c_str(), v);
+                    } else if constexpr (std::is_same_v<T, std::string>) {
+                        ffi::set_arg_string(args, key.c_str(), v.c_str());
+                    } else {
+                        ffi::set_arg_try_number(args, key.c_str(), v.text.c_str());
+                    }
+                },
+                value
+            );
+        }
+
+        template<class T> void add(std::string_view key, T&& value) {
+            using V = std::decay_t<T>;
+            auto& [k, v] = m_values.emplace_back(
+                std::string(key), Value(std::in_place_type<V>, std::forward<T>(value))
+            );
+            if (m_args != nullptr) { apply(m_args, k, v); }
+        }
+
+        [[nodiscard]] auto get() const -> const ffi::FluencyArgs* {
+            if (m_args == nullptr) {
+                ffi::create_args_with_capacity(&m_args, m_values.size());
+                for (const auto& [key, value] : m_values) { apply(m_args, key, value); }
+            }
+            return m_args;
+        }
+
+        /// @brief Appends a byte string that is equal for two argument lists exactly when they
+        /// set the same keys, in the same order, to the same typed values.
+        void append_signature(std::string& out) const {
+            for (const auto& [key, value] : m_values) {
+                out.append(key);
+                out.push_back('\0');
+                out.push_back(static_cast<char>(value.index()));
+                std::visit(
+                    [&](const auto& v) {
+                        using T = std::decay_t<decltype(v)>;
+                        if constexpr (std::is_same_v<T, std::string>) {
+                            out.append(v);
+                            out.push_back('\0');
+                        } else if constexpr (std::is_same_v<T, TryNumber>) {
+                            out.append(v.text);
+                            out.push_back('\0');
+                        } else {
+                            out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+                        }
+                    },
+                    value
+                );
+            }
+        }
 
     public:
-        FluencyArgs() { ffi::create_args(&m_args); }
+        FluencyArgs() = default;
 
         FluencyArgs(const FluencyArgs&) = delete; // copy constructor
 
         FluencyArgs(FluencyArgs&& other) noexcept
-            : m_args(std::exchange(other.m_args, nullptr)) { } // move constructor
+            : m_values(std::move(other.m_values))
+            , m_args(std::exchange(other.m_args, nullptr)) { } // move constructor
 
         auto operator=(const FluencyArgs&) -> FluencyArgs& = delete; // copy assignment
 
         auto operator=(FluencyArgs&& other) noexcept -> FluencyArgs& { // move assignment
+            std::swap(m_values, other.m_values);
             std::swap(m_args, other.m_args);
             return *this;
         }
 
         ~FluencyArgs() { ffi::destroy_args(m_args); }
 
-        inline void set(std::string_view key, uint8_t value) {
-            ffi::set_arg_u8(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, uint8_t value) { add(key, value); }
 
-        inline void set(std::string_view key, uint16_t value) {
-            ffi::set_arg_u16(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, uint16_t value) { add(key, value); }
 
-        inline void set(std::string_view key, uint32_t value) {
-            ffi::set_arg_u32(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, uint32_t value) { add(key, value); }
 
-        inline void set(std::string_view key, uint64_t value) {
-            ffi::set_arg_u64(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, uint64_t value) { add(key, value); }
 
-        inline void set(std::string_view key, int8_t value) {
-            ffi::set_arg_i8(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, int8_t value) { add(key, value); }
 
-        inline void set(std::string_view key, int16_t value) {
-            ffi::set_arg_i16(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, int16_t value) { add(key, value); }
 
-        inline void set(std::string_view key, int32_t value) {
-            ffi::set_arg_i32(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, int32_t value) { add(key, value); }
 
-        inline void set(std::string_view key, int64_t value) {
-            ffi::set_arg_i64(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, int64_t value) { add(key, value); }
 
-        inline void set(std::string_view key, float value) {
-            ffi::set_arg_f32(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, float value) { add(key, value); }
 
-        inline void set(std::string_view key, double value) {
-            ffi::set_arg_f64(m_args, key.data(), value);
-        }
+        inline void set(std::string_view key, double value) { add(key, value); }
 
         inline void set(std::string_view key, std::string_view value) {
-            ffi::set_arg_string(m_args, key.data(), value.data());
+            add(key, std::string(value));
         }
 
         inline void set_try_number(std::string_view key, std::string_view value) {
-            ffi::set_arg_try_number(m_args, key.data(), value.data());
+            add(key, TryNumber{std::string(value)});
         }
 
         friend class FluencyBundle;
@@ -129,9 +208,72 @@ namespace fluency {
         friend class FluencyBundle;
     };
 
+    /// @brief How many formatted strings a FluencyBundle remembers by default.
+    constexpr size_t DEFAULT_STRING_CACHE_SIZE = 256;
+
     class FluencyBundle {
     private:
+        /// @brief A formatted string, keyed by message id, attribute and arguments.
+        struct CachedString {
+            std::string key;
+            std::shared_ptr<const std::string> text;
+        };
+
         ffi::FluencyBundle* m_bundle = nullptr;
+        size_t m_cache_capacity = DEFAULT_STRING_CACHE_SIZE;
+        /// @brief Strings formatted by get_string, most recently used first.
+        std::list<CachedString> m_cache;
+        /// @brief Views into the keys in m_cache, whose nodes never move.
+        std::unordered_map<std::string_view, std::list<CachedString>::iterator> m_cache_index;
+        /// @brief Reused for building lookup keys, so a hit doesn't allocate.
+        std::string m_cache_key;
+
+        void evict_to(size_t size) {
+            while (m_cache.size() > size) {
+                m_cache_index.erase(m_cache.back().key);
+                m_cache.pop_back();
+            }
+        }
+
+        auto cached(
+            std::string_view id, std::string_view attribute, const FluencyArgs* args,
+            std::vector<std::string>& errors
+        ) -> std::shared_ptr<const std::string> {
+            m_cache_key.assign(id);
+            m_cache_key.push_back('\0');
+            m_cache_key.append(attribute);
+            m_cache_key.push_back('\0');
+            if (args != nullptr) { args->append_signature(m_cache_key); }
+
+            auto found = m_cache_index.find(m_cache_key);
+            if (found != m_cache_index.end()) {
+                m_cache.splice(m_cache.begin(), m_cache, found->second);
+                errors.clear();
+                return found->second->text;
+            }
+
+            std::string id_str(id);
+            if (!has_message(id_str)) { throw std::invalid_argument("Unknown message"); }
+            auto message = get_message(id_str);
+
+            std::string text{};
+            if (attribute.empty()) {
+                text = args != nullptr ? format(message, *args, errors) : format(message, errors);
+            } else {
+                auto attr = message.get_attribute(std::string(attribute));
+                text = args != nullptr ? format(attr, *args, errors) : format(attr, errors);
+            }
+            auto shared = std::make_shared<const std::string>(std::move(text));
+
+            // Strings that came with errors are formatted afresh each time, so every caller
+            // hears about the errors, and a hit never has any to report.
+            if (errors.empty() && m_cache_capacity > 0) {
+                evict_to(m_cache_capacity - 1);
+                m_cache.push_front(CachedString{m_cache_key, shared});
+                m_cache_index.emplace(m_cache.front().key, m_cache.begin());
+            }
+            return shared;
+        }
 
     public:
         explicit FluencyBundle(std::string_view locale) {
@@ -142,18 +284,27 @@ namespace fluency {
         FluencyBundle(const FluencyBundle&) = delete; // copy constructor
 
         FluencyBundle(FluencyBundle&& other) noexcept
-            : m_bundle(std::exchange(other.m_bundle, nullptr)) { } // move constructor
+            : m_bundle(std::exchange(other.m_bundle, nullptr))
+            , m_cache_capacity(other.m_cache_capacity)
+            , m_cache(std::move(other.m_cache))
+            , m_cache_index(std::move(other.m_cache_index)) { } // move constructor
 
         auto operator=(const FluencyBundle&) -> FluencyBundle& = delete; // copy assignment
 
         auto operator=(FluencyBundle&& other) noexcept -> FluencyBundle& { // move assignment
             std::swap(m_bundle, other.m_bundle);
+            std::swap(m_cache_capacity, other.m_cache_capacity);
+            std::swap(m_cache, other.m_cache);
+            std::swap(m_cache_index, other.m_cache_index);
             return *this;
         }
 
         ~FluencyBundle() { ffi::destroy_bundle(m_bundle); }
 
+        /// @brief Adds messages that aren't defined yet. Clears the string cache, since cached
+        /// strings may have referenced messages that were missing.
         auto add_resource(std::string_view string, std::vector<std::string>& errors) -> bool {
+            clear_cache();
             char** errors_c = nullptr;
             size_t error_length = 0;
             auto result = ffi::add_resource(m_bundle, string.data(), &errors_c, &error_length);
@@ -170,6 +321,7 @@ namespace fluency {
 
         auto add_resource_overriding(std::string_view string, std::vector<std::string>& errors)
             -> bool {
+            clear_cache();
             char** errors_c = nullptr;
             size_t error_length = 0;
             auto result =
@@ -185,7 +337,54 @@ namespace fluency {
             return true;
         }
 
-        void set_use_isolating(bool value) { ffi::set_use_isolating(m_bundle, value); }
+        void set_use_isolating(bool value) {
+            clear_cache();
+            ffi::set_use_isolating(m_bundle, value);
+        }
+
+        /// @brief Formats message `id`, or returns the string it formatted to last time if it is
+        /// still among the cache_capacity() most recently used. The strings handed out are
+        /// shared and never modified, and stay valid after they are evicted.
+        auto get_string(std::string_view id, std::vector<std::string>& errors)
+            -> std::shared_ptr<const std::string> {
+            return cached(id, {}, nullptr, errors);
+        }
+
+        auto get_string(
+            std::string_view id, const FluencyArgs& args, std::vector<std::string>& errors
+        ) -> std::shared_ptr<const std::string> {
+            return cached(id, {}, &args, errors);
+        }
+
+        /// @brief Like get_string, for one of the message's attributes.
+        auto get_attribute_string(
+            std::string_view id, std::string_view attribute, std::vector<std::string>& errors
+        ) -> std::shared_ptr<const std::string> {
+            return cached(id, attribute, nullptr, errors);
+        }
+
+        auto get_attribute_string(
+            std::string_view id, std::string_view attribute, const FluencyArgs& args,
+            std::vector<std::string>& errors
+        ) -> std::shared_ptr<const std::string> {
+            return cached(id, attribute, &args, errors);
+        }
+
+        /// @brief Changes how many strings are remembered, evicting the least recently used ones
+        /// if there are now too many. A capacity of zero turns caching off.
+        void set_cache_capacity(size_t capacity) {
+            m_cache_capacity = capacity;
+            evict_to(capacity);
+        }
+
+        void clear_cache() {
+            m_cache_index.clear();
+            m_cache.clear();
+        }
+
+        [[nodiscard]] auto cache_capacity() const -> size_t { return m_cache_capacity; }
+
+        [[nodiscard]] auto cache_size() const -> size_t { return m_cache.size(); }
 
         auto has_message(std::string_view id) -> bool {
             bool result = false;
@@ -230,7 +429,7 @@ namespace fluency {
             char** errors_c = nullptr;
             size_t error_length = 0;
             auto result = ffi::format_message(
-                m_bundle, message.m_message, args.m_args, &output, &errors_c, &error_length
+                m_bundle, message.m_message, args.get(), &output, &errors_c, &error_length
             );
             if (result != ffi::FluencyResult::Ok) {
                 throw std::invalid_argument("Message does not contain a value");
@@ -278,7 +477,7 @@ namespace fluency {
             char** errors_c = nullptr;
             size_t error_length = 0;
             auto result = ffi::format_attribute(
-                m_bundle, attribute.m_attribute, args.m_args, &output, &errors_c, &error_length
+                m_bundle, attribute.m_attribute, args.get(), &output, &errors_c, &error_length
             );
             if (result != ffi::FluencyResult::Ok) { throw std::invalid_argument("???"); }
 
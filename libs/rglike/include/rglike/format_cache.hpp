@@ -0,0 +1,77 @@
+/**
+ * @file format_cache.hpp
+ * @author Alic Szecsei
+ * @date 8/2/2023
+ */
+
+#pragma once
+
+#include "rglike/formatting.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace rglike {
+    namespace formatting {
+        /// @brief How often a FormatCache found what it was asked for.
+        struct FormatCacheStats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            /// @brief Entries dropped to make room for new ones.
+            uint64_t evictions = 0;
+
+            [[nodiscard]] auto hit_rate() const -> double {
+                auto total = hits + misses;
+                return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+            }
+        };
+
+        /// @brief How many distinct strings a FormatCache remembers unless told otherwise.
+        constexpr size_t DEFAULT_FORMAT_CACHE_SIZE = 256;
+
+        /// @brief Remembers the most recently formatted strings, so formatting one again is a
+        /// single hash lookup. The Texts it hands out are shared and never modified, and stay
+        /// valid after they are evicted. Not thread-safe; give each thread its own.
+        class FormatCache {
+        private:
+            struct Entry {
+                uint64_t hash;
+                std::string markup;
+                std::shared_ptr<const Text> text;
+            };
+
+            size_t m_capacity;
+            /// @brief Most recently used first.
+            std::list<Entry> m_entries;
+            std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+            FormatCacheStats m_stats{};
+
+            void evict_to(size_t size);
+
+        public:
+            explicit FormatCache(size_t capacity = DEFAULT_FORMAT_CACHE_SIZE)
+                : m_capacity(capacity) { }
+
+            /// @brief format_text(markup), from the cache if it has been seen recently.
+            auto format(std::string_view markup) -> std::shared_ptr<const Text>;
+
+            /// @brief Changes how many strings are remembered, evicting the least recently used
+            /// ones if there are now too many. A capacity of zero turns caching off.
+            void set_capacity(size_t capacity);
+
+            void clear();
+
+            [[nodiscard]] auto capacity() const -> size_t { return m_capacity; }
+
+            [[nodiscard]] auto size() const -> size_t { return m_entries.size(); }
+
+            [[nodiscard]] auto stats() const -> const FormatCacheStats& { return m_stats; }
+
+            void reset_stats() { m_stats = {}; }
+        };
+    } // namespace formatting
+} // namespace rglike
@@ -6,9 +6,14 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <deque>
 #include <ftxui/screen/color.hpp>
 #include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
 
 namespace rglike {
     namespace formatting {
@@ -21,6 +26,32 @@ namespace rglike {
             bool blinking = false;
         };
 
+        /// @brief Marks a Style color as the terminal's default.
+        constexpr uint8_t DEFAULT_COLOR = 0xFF;
+
+        /// @brief A Format that can be built at compile time. Colors are indices into ftxui's
+        /// 16-color palette, or DEFAULT_COLOR.
+        struct Style {
+            uint8_t color = DEFAULT_COLOR;
+            uint8_t bg_color = DEFAULT_COLOR;
+            bool bold = false;
+            bool dim = false;
+            bool underlined = false;
+            bool blinking = false;
+
+            constexpr auto operator==(const Style& other) const -> bool {
+                return color == other.color && bg_color == other.bg_color && bold == other.bold &&
+                       dim == other.dim && underlined == other.underlined &&
+                       blinking == other.blinking;
+            }
+
+            constexpr auto operator!=(const Style& other) const -> bool {
+                return !(*this == other);
+            }
+
+            [[nodiscard]] auto to_format() const -> Format;
+        };
+
         struct Fragment {
             Format format;
             std::string text;
@@ -54,13 +85,278 @@ namespace rglike {
                 m_fragments.emplace_back(args...);
             }
 
-            auto plain_text() -> std::string {
+            [[nodiscard]] auto empty() const -> bool { return m_fragments.empty(); }
+
+            [[nodiscard]] auto size() const -> size_t { return m_fragments.size(); }
+
+            auto back() -> Fragment& { return m_fragments.back(); }
+
+            [[nodiscard]] auto begin() const { return m_fragments.begin(); }
+
+            [[nodiscard]] auto end() const { return m_fragments.end(); }
+
+            [[nodiscard]] auto plain_text() const -> std::string {
                 std::string result{};
                 for (const auto& frag : m_fragments) { result += frag.text; }
                 return result;
             }
         };
+
+        enum class MarkupError : uint8_t {
+            None,
+            /// @brief A `]` that doesn't close a tag; write `]]` for a literal one.
+            StrayBracket,
+            /// @brief A tag whose name doesn't start with a letter; write `[[` for a literal `[`.
+            BadTagName,
+            /// @brief A tag opened with `[` but never closed with `]`.
+            UnterminatedTag,
+            /// @brief A closing tag that doesn't match the innermost open one.
+            TagMismatch,
+            /// @brief The text ends with tags still open.
+            UnclosedTag,
+            /// @brief More than MAX_MARKUP_DEPTH tags open at once.
+            TooDeep,
+        };
+
+        /// @brief How many tags can be open at once.
+        constexpr size_t MAX_MARKUP_DEPTH = 16;
+
+        struct MarkupResult {
+            MarkupError error = MarkupError::None;
+            /// @brief Where in the text the error was found.
+            size_t position = 0;
+
+            constexpr explicit operator bool() const { return error == MarkupError::None; }
+        };
+
+        [[nodiscard]] auto markup_error_name(MarkupError error) -> const char*;
+
+        namespace detail {
+            constexpr auto is_alpha(char c) -> bool {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            }
+
+            constexpr auto is_name_char(char c) -> bool {
+                return is_alpha(c) || (c >= '0' && c <= '9') || c == '_';
+            }
+
+            constexpr auto is_space(char c) -> bool {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+            }
+
+            /// @brief The palette index a one-letter color code names: lowercase for the dark
+            /// half of the palette, uppercase for the light half.
+            constexpr auto color_code(std::string_view code) -> uint8_t {
+                constexpr std::array<std::pair<char, uint8_t>, 16> codes{{
+                    {'k', 0}, {'r', 1}, {'g', 2},  {'y', 3},  {'b', 4},  {'m', 5},
+                    {'c', 6}, {'w', 7}, {'K', 8},  {'R', 9},  {'G', 10}, {'Y', 11},
+                    {'B', 12}, {'M', 13}, {'C', 14}, {'W', 15},
+                }};
+                if (code.size() != 1) { return DEFAULT_COLOR; }
+                for (const auto& [letter, index] : codes) {
+                    if (letter == code[0]) { return index; }
+                }
+                return DEFAULT_COLOR;
+            }
+
+            /// @brief The style inside a `[name=value]` tag opened in `style`. Unknown tags and
+            /// colors leave it unchanged.
+            constexpr auto apply_tag(Style style, std::string_view name, std::string_view value)
+                -> Style {
+                if (name == "color" || name == "bg") {
+                    auto color = color_code(value);
+                    if (color == DEFAULT_COLOR) { return style; }
+                    (name == "color" ? style.color : style.bg_color) = color;
+                } else if (name == "b") {
+                    style.bold = true;
+                } else if (name == "u") {
+                    style.underlined = true;
+                } else if (name == "d") {
+                    style.dim = true;
+                } else if (name == "blink") {
+                    style.blinking = true;
+                }
+                return style;
+            }
+
+            constexpr auto skip_space(std::string_view text, size_t pos) -> size_t {
+                while (pos < text.size() && is_space(text[pos])) { ++pos; }
+                return pos;
+            }
+
+            constexpr auto name_end(std::string_view text, size_t pos) -> size_t {
+                if (pos >= text.size() || !is_alpha(text[pos])) { return pos; }
+                while (pos < text.size() && is_name_char(text[pos])) { ++pos; }
+                return pos;
+            }
+        } // namespace detail
+
+        /// @brief Parses markup such as `Hit [color=r][b]hard[/b][/color]!` in a single pass,
+        /// calling `visit(style, text)` for every run of text in order. Nothing is allocated;
+        /// each run is a view into `text`. `[[` and `]]` are literal brackets.
+        ///
+        /// Usable at compile time as long as `visit` is.
+        template<class Visitor>
+        constexpr auto parse_markup(std::string_view text, Visitor&& visit) -> MarkupResult {
+            std::array<Style, MAX_MARKUP_DEPTH + 1> styles{};
+            std::array<std::string_view, MAX_MARKUP_DEPTH + 1> names{};
+            size_t depth = 0;
+
+            size_t pos = 0;
+            while (pos < text.size()) {
+                auto c = text[pos];
+                auto next = pos + 1 < text.size() ? text[pos + 1] : '\0';
+
+                if ((c == '[' || c == ']') && next == c) {
+                    visit(styles[depth], text.substr(pos, 1));
+                    pos += 2;
+                } else if (c == ']') {
+                    return {MarkupError::StrayBracket, pos};
+                } else if (c == '[' && next == '/') {
+                    auto start = detail::skip_space(text, pos + 2);
+                    auto end = detail::name_end(text, start);
+                    auto close = detail::skip_space(text, end);
+                    if (close >= text.size() || text[close] != ']') {
+                        return {MarkupError::UnterminatedTag, pos};
+                    }
+                    if (depth == 0 || text.substr(start, end - start) != names[depth]) {
+                        return {MarkupError::TagMismatch, pos};
+                    }
+                    --depth;
+                    pos = close + 1;
+                } else if (c == '[') {
+                    auto start = detail::skip_space(text, pos + 1);
+                    auto end = detail::name_end(text, start);
+                    if (end == start) { return {MarkupError::BadTagName, pos}; }
+
+                    std::string_view value{};
+                    auto close = detail::skip_space(text, end);
+                    if (close < text.size() && text[close] == '=') {
+                        auto value_start = detail::skip_space(text, close + 1);
+                        close = text.find_first_of("[]", value_start);
+                        if (close == std::string_view::npos) { close = text.size(); }
+                        auto value_end = close;
+                        while (value_end > value_start && detail::is_space(text[value_end - 1])) {
+                            --value_end;
+                        }
+                        value = text.substr(value_start, value_end - value_start);
+                    }
+                    if (close >= text.size() || text[close] != ']') {
+                        return {MarkupError::UnterminatedTag, pos};
+                    }
+                    if (depth == MAX_MARKUP_DEPTH) { return {MarkupError::TooDeep, pos}; }
+
+                    auto name = text.substr(start, end - start);
+                    styles[depth + 1] = detail::apply_tag(styles[depth], name, value);
+                    names[depth + 1] = name;
+                    ++depth;
+                    pos = close + 1;
+                } else {
+                    auto end = text.find_first_of("[]", pos);
+                    if (end == std::string_view::npos) { end = text.size(); }
+                    visit(styles[depth], text.substr(pos, end - pos));
+                    pos = end;
+                }
+            }
+
+            if (depth != 0) { return {MarkupError::UnclosedTag, text.size()}; }
+            return {};
+        }
+
+        namespace detail {
+            struct MarkupSize {
+                size_t fragments = 0;
+                size_t chars = 0;
+                MarkupResult result;
+            };
+
+            /// @brief How many fragments and characters format_text would give `text`.
+            constexpr auto measure_markup(std::string_view text) -> MarkupSize {
+                MarkupSize size{};
+                Style last{};
+                size.result = parse_markup(text, [&](const Style& style, std::string_view run) {
+                    if (run.empty()) { return; }
+                    if (size.chars == 0 || style != last) { ++size.fragments; }
+                    size.chars += run.size();
+                    last = style;
+                });
+                return size;
+            }
+        } // namespace detail
+
+        /// @brief Markup parsed at compile time into a fixed table of fragments; see
+        /// RGLIKE_MARKUP. Turning it into a Text only copies the fragments out.
+        template<size_t Fragments, size_t Chars> class CompiledMarkup {
+        private:
+            std::array<Style, Fragments> m_styles{};
+            /// @brief Where each fragment starts in m_text, plus where the last one ends.
+            std::array<size_t, Fragments + 1> m_offsets{};
+            std::array<char, Chars + 1> m_text{};
+
+        public:
+            /// @brief Only meant for markup that measure_markup has already checked.
+            constexpr explicit CompiledMarkup(std::string_view markup) {
+                size_t fragment = 0;
+                size_t chars = 0;
+                (void)parse_markup(markup, [&](const Style& style, std::string_view run) {
+                    if (run.empty()) { return; }
+                    if (chars == 0 || style != m_styles[fragment - 1]) {
+                        m_styles[fragment] = style;
+                        m_offsets[fragment] = chars;
+                        ++fragment;
+                    }
+                    for (auto c : run) { m_text[chars++] = c; }
+                });
+                m_offsets[Fragments] = chars;
+            }
+
+            [[nodiscard]] constexpr auto size() const -> size_t { return Fragments; }
+
+            [[nodiscard]] constexpr auto style(size_t index) const -> const Style& {
+                return m_styles[index];
+            }
+
+            [[nodiscard]] constexpr auto text(size_t index) const -> std::string_view {
+                return {m_text.data() + m_offsets[index], m_offsets[index + 1] - m_offsets[index]};
+            }
+
+            [[nodiscard]] constexpr auto plain_text() const -> std::string_view {
+                return {m_text.data(), Chars};
+            }
+
+            [[nodiscard]] auto to_text() const -> Text {
+                Text output{};
+                for (size_t i = 0; i < Fragments; ++i) {
+                    output.emplace_back(m_styles[i].to_format(), text(i));
+                }
+                return output;
+            }
+
+            /// @brief Implicit, so a literal can go wherever a format_text result could.
+            operator Text() const { return to_text(); }
+        };
+
+        /// @brief Compiles the markup returned by `source`, a captureless lambda, failing the build
+        /// if it is malformed. Use RGLIKE_MARKUP rather than calling this directly.
+        template<class Source> constexpr auto compile_markup(Source source) {
+            constexpr std::string_view markup = source();
+            constexpr auto size = detail::measure_markup(markup);
+            static_assert(size.result.error != MarkupError::StrayBracket, "unescaped ']'");
+            static_assert(size.result.error != MarkupError::BadTagName, "bad tag name");
+            static_assert(size.result.error != MarkupError::UnterminatedTag, "tag missing ']'");
+            static_assert(size.result.error != MarkupError::TagMismatch, "tag mismatch");
+            static_assert(size.result.error != MarkupError::UnclosedTag, "tag never closed");
+            static_assert(size.result.error != MarkupError::TooDeep, "tags nested too deeply");
+            return CompiledMarkup<size.fragments, size.chars>(markup);
+        }
     } // namespace formatting
 
+    /// @brief Parses markup into styled fragments, merging neighbouring runs of the same style.
+    /// Malformed markup is reported and gives an empty Text.
     auto format_text(const std::string_view& text) -> formatting::Text;
-} // namespace rglike
\ No newline at end of file
+} // namespace rglike
+
+/// @brief Markup checked and parsed at compile time, as a formatting::CompiledMarkup. Malformed
+/// markup, such as an unclosed tag, is a compile error.
+#define RGLIKE_MARKUP(markup)                                                                    \
+    ::rglike::formatting::compile_markup([] { return std::string_view(markup); })
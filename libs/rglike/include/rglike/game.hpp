@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string>
 
 namespace rglike {
     class Scene;
@@ -16,8 +18,20 @@ namespace rglike {
     private:
         std::unique_ptr<Scene> m_current_scene{nullptr};
         std::unique_ptr<Scene> m_next_scene{nullptr};
+        uint64_t m_seed = 0;
+        std::string m_record_path;
 
     public:
+        /// @brief Sets the seed new levels are generated from.
+        inline void SetSeed(uint64_t seed) { m_seed = seed; }
+
+        [[nodiscard]] inline auto Seed() const -> uint64_t { return m_seed; }
+
+        /// @brief Records the input of each game played to a replay file at `path`, if not empty.
+        inline void SetRecordPath(std::string path) { m_record_path = std::move(path); }
+
+        [[nodiscard]] inline auto RecordPath() const -> const std::string& { return m_record_path; }
+
         void Initialize();
         void Run();
 
@@ -0,0 +1,33 @@
+/**
+ * @file generation.hpp
+ * @author Alic Szecsei
+ * @date 6/29/2023
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rglike {
+    struct GenerationOptions {
+        uint64_t seed = 0;
+        /// @brief Level size in tiles; zero uses the default level size.
+        int width = 0;
+        int height = 0;
+        /// @brief Background worker threads; negative uses one per spare hardware thread.
+        int threads = -1;
+    };
+
+    struct GenerationReport {
+        int width = 0;
+        int height = 0;
+        size_t workers = 0;
+        size_t floor_tiles = 0;
+        uint64_t checksum = 0;
+        double milliseconds = 0.0;
+    };
+
+    /// @brief Generates a level without starting the game, timing how long it takes.
+    auto GenerateLevel(const GenerationOptions& options) -> GenerationReport;
+} // namespace rglike
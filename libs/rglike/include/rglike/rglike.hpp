@@ -7,4 +7,6 @@
 #pragma once
 
 #include "rglike/game.hpp"
-#include "rglike/scene.hpp"
\ No newline at end of file
+#include "rglike/generation.hpp"
+#include "rglike/scene.hpp"
+#include "rglike/simulation.hpp"
\ No newline at end of file
@@ -17,6 +17,9 @@ namespace rglike {
     private:
         Game* owner = nullptr;
 
+    protected:
+        [[nodiscard]] inline auto Owner() const -> Game* { return owner; }
+
     public:
         explicit Scene(Game* owner)
             : owner(owner) { }
@@ -0,0 +1,74 @@
+/**
+ * @file simulation.hpp
+ * @author Alic Szecsei
+ * @date 7/10/2023
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rglike {
+    struct SimulationOptions {
+        uint64_t seed = 0;
+        /// @brief Player turns to simulate.
+        size_t turns = 1000;
+        /// @brief Monsters to scatter across the level before starting.
+        size_t actors = 1000;
+    };
+
+    /// @brief Time spent in one part of the turn loop.
+    struct SystemTiming {
+        std::string name;
+        double microseconds = 0.0;
+    };
+
+    struct SimulationReport {
+        size_t turns = 0;
+        /// @brief Turns taken by monsters, across every player turn.
+        size_t actor_turns = 0;
+        double seconds = 0.0;
+        std::vector<SystemTiming> systems;
+
+        [[nodiscard]] inline auto TurnsPerSecond() const -> double {
+            return seconds > 0.0 ? static_cast<double>(turns) / seconds : 0.0;
+        }
+
+        /// @brief The average time `system` took per player turn.
+        [[nodiscard]] inline auto MicrosecondsPerTurn(const SystemTiming& system) const -> double {
+            return turns > 0 ? system.microseconds / static_cast<double>(turns) : 0.0;
+        }
+    };
+
+    /// @brief Runs the world without a terminal: the player wanders at random while monsters
+    /// take their turns, timing each part of the loop.
+    auto RunSimulation(const SimulationOptions& options) -> SimulationReport;
+
+    struct ReplayReport {
+        uint64_t seed = 0;
+        size_t events = 0;
+        /// @brief Turns taken by monsters over the whole replay.
+        size_t actor_turns = 0;
+        double seconds = 0.0;
+        /// @brief The world's state when the recording ended, if it ended cleanly.
+        std::optional<uint64_t> expected_hash;
+        uint64_t final_hash = 0;
+
+        [[nodiscard]] inline auto EventsPerSecond() const -> double {
+            return seconds > 0.0 ? static_cast<double>(events) / seconds : 0.0;
+        }
+
+        /// @brief Whether the replay ended in the recorded state. True if nothing was recorded.
+        [[nodiscard]] inline auto Matches() const -> bool {
+            return !expected_hash || *expected_hash == final_hash;
+        }
+    };
+
+    /// @brief Replays a recorded session without a terminal, as fast as the world can step.
+    /// @return The outcome, or nothing if the replay could not be read.
+    auto RunReplay(const std::string& path) -> std::optional<ReplayReport>;
+} // namespace rglike
@@ -0,0 +1,249 @@
+/**
+ * @file chunk_streamer.cpp
+ * @author Alic Szecsei
+ * @date 7/2/2023
+ */
+
+#include "chunk_streamer.hpp"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace rglike {
+    ChunkStreamer::ChunkStreamer(
+        TileMap& map, const std::string& region_path, uint64_t fingerprint, ChunkSource source,
+        int resident_radius, int prefetch_margin
+    )
+        : m_map(map)
+        , m_region(region_path, map.ChunksWide(), map.ChunksHigh(), fingerprint)
+        , m_source(std::move(source))
+        , m_resident_radius(resident_radius)
+        , m_prefetch_margin(prefetch_margin)
+        , m_states(static_cast<size_t>(map.ChunksWide()) * map.ChunksHigh(), ChunkState::Unloaded) {
+        for (int chunk_y = 0; chunk_y < map.ChunksHigh(); ++chunk_y) {
+            for (int chunk_x = 0; chunk_x < map.ChunksWide(); ++chunk_x) {
+                if (!map.IsResident(chunk_x, chunk_y)) { continue; }
+                auto index = static_cast<size_t>(chunk_y) * map.ChunksWide() + chunk_x;
+                m_states[index] = ChunkState::Resident;
+                m_resident.push_back(index);
+            }
+        }
+        m_worker = std::thread(&ChunkStreamer::WorkerLoop, this);
+    }
+
+    ChunkStreamer::~ChunkStreamer() {
+        StoreAll();
+        {
+            std::lock_guard lock{m_mutex};
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        m_worker.join();
+    }
+
+    void ChunkStreamer::WorkerLoop() {
+        const auto chunks_wide = static_cast<size_t>(m_map.ChunksWide());
+        while (true) {
+            Request request{};
+            {
+                std::unique_lock lock{m_mutex};
+                m_wake.wait(lock, [&] { return m_stopping || !m_requests.empty(); });
+                if (m_requests.empty()) { return; }
+                request = std::move(m_requests.front());
+                m_requests.pop_front();
+                ++m_busy;
+            }
+
+            std::unique_ptr<TileChunk> loaded{};
+            bool stored = false;
+            try {
+                if (request.chunk != nullptr) {
+                    m_region.Write(request.index, *request.chunk);
+                    stored = true;
+                    ++m_page_outs;
+                } else {
+                    loaded = std::make_unique<TileChunk>();
+                    if (!m_region.Read(request.index, *loaded)) {
+                        auto chunk_x = static_cast<int>(request.index % chunks_wide);
+                        auto chunk_y = static_cast<int>(request.index / chunks_wide);
+                        m_source(chunk_x, chunk_y, *loaded);
+                        ++m_generated;
+                    }
+                }
+            } catch (const std::exception& e) {
+                spdlog::error("Streaming chunk {} failed: {}", request.index, e.what());
+                loaded = nullptr;
+            }
+
+            std::lock_guard lock{m_mutex};
+            if (request.chunk == nullptr) {
+                m_loaded.push_back(Loaded{request.index, std::move(loaded), false});
+            } else if (!stored) {
+                ++m_failed_stores;
+                // The map no longer holds the only copy of this chunk's edits, so hand it back.
+                if (request.released) {
+                    m_loaded.push_back(Loaded{request.index, std::move(request.chunk), true});
+                }
+            }
+            --m_busy;
+            if (m_requests.empty() && m_busy == 0) { m_idle.notify_all(); }
+        }
+    }
+
+    auto ChunkStreamer::ChunkRange(Vec2 focus, int radius) const -> Rect {
+        auto tiles = Rect::Around(focus, radius);
+        auto min = Vec2{tiles.min.X() >> CHUNK_SHIFT, tiles.min.Y() >> CHUNK_SHIFT};
+        auto max = Vec2{
+            ((tiles.max.X() - 1) >> CHUNK_SHIFT) + 1,
+            ((tiles.max.Y() - 1) >> CHUNK_SHIFT) + 1,
+        };
+        return Rect{min, max}.Intersect(
+            Rect{Vec2::Zero(), Vec2{m_map.ChunksWide(), m_map.ChunksHigh()}}
+        );
+    }
+
+    void ChunkStreamer::RequestRange(const Rect& range, Vec2 focus) {
+        auto focus_chunk = Vec2{focus.X() >> CHUNK_SHIFT, focus.Y() >> CHUNK_SHIFT};
+        std::vector<std::pair<int, size_t>> wanted{};
+        for (int chunk_y = range.min.Y(); chunk_y < range.max.Y(); ++chunk_y) {
+            for (int chunk_x = range.min.X(); chunk_x < range.max.X(); ++chunk_x) {
+                auto index = static_cast<size_t>(chunk_y) * m_map.ChunksWide() + chunk_x;
+                if (m_states[index] != ChunkState::Unloaded) { continue; }
+                auto offset = Vec2{chunk_x, chunk_y} - focus_chunk;
+                wanted.emplace_back(offset.X() * offset.X() + offset.Y() * offset.Y(), index);
+            }
+        }
+        if (wanted.empty()) { return; }
+
+        std::sort(wanted.begin(), wanted.end());
+        {
+            std::lock_guard lock{m_mutex};
+            for (const auto& [distance, index] : wanted) {
+                m_states[index] = ChunkState::Loading;
+                m_requests.push_back(Request{index, nullptr});
+            }
+        }
+        m_wake.notify_one();
+    }
+
+    void ChunkStreamer::EvictOutside(const Rect& range) {
+        const auto chunks_wide = static_cast<size_t>(m_map.ChunksWide());
+        std::vector<Request> stores{};
+        for (size_t i = 0; i < m_resident.size();) {
+            auto index = m_resident[i];
+            auto chunk_x = static_cast<int>(index % chunks_wide);
+            auto chunk_y = static_cast<int>(index / chunks_wide);
+            if (range.Contains(Vec2{chunk_x, chunk_y})) {
+                ++i;
+                continue;
+            }
+
+            stores.push_back(Request{index, m_map.ReleaseChunk(chunk_x, chunk_y), true});
+            m_states[index] = ChunkState::Unloaded;
+            m_resident[i] = m_resident.back();
+            m_resident.pop_back();
+        }
+        if (stores.empty()) { return; }
+
+        {
+            std::lock_guard lock{m_mutex};
+            for (auto& store : stores) { m_requests.push_back(std::move(store)); }
+        }
+        m_wake.notify_one();
+    }
+
+    void ChunkStreamer::InstallLoaded() {
+        std::vector<Loaded> loaded{};
+        {
+            std::lock_guard lock{m_mutex};
+            loaded.swap(m_loaded);
+        }
+
+        const auto chunks_wide = static_cast<size_t>(m_map.ChunksWide());
+        for (auto& [index, chunk, unstored] : loaded) {
+            // An unstored chunk can race a load of the same chunk, which read back stale tiles.
+            // The unstored one always arrives first, so the load is the one to drop.
+            if (m_states[index] == ChunkState::Resident) { continue; }
+            if (chunk == nullptr) {
+                m_states[index] = ChunkState::Failed;
+                continue;
+            }
+
+            auto chunk_x = static_cast<int>(index % chunks_wide);
+            auto chunk_y = static_cast<int>(index / chunks_wide);
+            m_map.InstallChunk(chunk_x, chunk_y, std::move(chunk));
+            m_states[index] = ChunkState::Resident;
+            m_resident.push_back(index);
+            if (!unstored) { ++m_stats.page_ins; }
+        }
+    }
+
+    void ChunkStreamer::Update(Vec2 focus) {
+        InstallLoaded();
+
+        auto required = ChunkRange(focus, m_resident_radius);
+        for (int chunk_y = required.min.Y(); chunk_y < required.max.Y(); ++chunk_y) {
+            for (int chunk_x = required.min.X(); chunk_x < required.max.X(); ++chunk_x) {
+                if (m_required.Contains(Vec2{chunk_x, chunk_y})) { continue; }
+                if (m_map.IsResident(chunk_x, chunk_y)) {
+                    ++m_stats.prefetch_hits;
+                } else {
+                    ++m_stats.prefetch_misses;
+                }
+            }
+        }
+        m_required = required;
+
+        RequestRange(ChunkRange(focus, m_resident_radius + m_prefetch_margin), focus);
+        EvictOutside(ChunkRange(focus, m_resident_radius + 2 * m_prefetch_margin));
+    }
+
+    void ChunkStreamer::Prime(Vec2 focus) {
+        // Give chunks that failed to load another chance.
+        std::replace(m_states.begin(), m_states.end(), ChunkState::Failed, ChunkState::Unloaded);
+        EvictOutside(ChunkRange(focus, m_resident_radius + 2 * m_prefetch_margin));
+        RequestRange(ChunkRange(focus, m_resident_radius + m_prefetch_margin), focus);
+        WaitIdle();
+        m_required = ChunkRange(focus, m_resident_radius);
+    }
+
+    void ChunkStreamer::WaitIdle() {
+        {
+            std::unique_lock lock{m_mutex};
+            m_idle.wait(lock, [&] { return m_requests.empty() && m_busy == 0; });
+        }
+        InstallLoaded();
+    }
+
+    auto ChunkStreamer::StoreAll() -> bool {
+        // Evictions still in flight may hand chunks back, and those need storing too.
+        WaitIdle();
+
+        const auto chunks_wide = static_cast<size_t>(m_map.ChunksWide());
+        uint64_t failed_before = 0;
+        {
+            std::lock_guard lock{m_mutex};
+            failed_before = m_failed_stores;
+            for (auto index : m_resident) {
+                const auto& chunk = m_map.Chunk(
+                    static_cast<int>(index % chunks_wide), static_cast<int>(index / chunks_wide)
+                );
+                m_requests.push_back(Request{index, std::make_unique<TileChunk>(chunk)});
+            }
+        }
+        m_wake.notify_one();
+        WaitIdle();
+        m_region.Flush();
+
+        std::lock_guard lock{m_mutex};
+        return m_failed_stores == failed_before;
+    }
+
+    auto ChunkStreamer::Stats() const -> StreamingStats {
+        auto stats = m_stats;
+        stats.resident_chunks = m_map.ResidentChunks();
+        stats.generated = m_generated;
+        stats.page_outs = m_page_outs;
+        return stats;
+    }
+} // namespace rglike
@@ -0,0 +1,146 @@
+/**
+ * @file chunk_streamer.hpp
+ * @author Alic Szecsei
+ * @date 7/2/2023
+ */
+
+#pragma once
+
+#include "math.hpp"
+#include "region_file.hpp"
+#include "tile_map.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rglike {
+    /// @brief Fills in a chunk that has never been stored, e.g. by generating it.
+    using ChunkSource = std::function<void(int chunk_x, int chunk_y, TileChunk& chunk)>;
+
+    struct StreamingStats {
+        size_t resident_chunks = 0;
+        /// @brief Chunks brought into memory, whether read back or generated.
+        uint64_t page_ins = 0;
+        /// @brief Of the page-ins, how many came from the ChunkSource rather than the file.
+        uint64_t generated = 0;
+        uint64_t page_outs = 0;
+        /// @brief Chunks that were already resident by the time the player came within range.
+        uint64_t prefetch_hits = 0;
+        /// @brief Chunks the player came within range of before they were loaded.
+        uint64_t prefetch_misses = 0;
+
+        [[nodiscard]] inline auto PrefetchHitRate() const -> double {
+            auto total = prefetch_hits + prefetch_misses;
+            return total == 0 ? 1.0 : static_cast<double>(prefetch_hits) / total;
+        }
+    };
+
+    /// @brief Keeps only the chunks of a TileMap near a focus point in memory.
+    ///
+    /// Chunks within the resident radius of the focus must be loaded. Chunks up to a margin
+    /// further out are prefetched, and chunks more than twice the margin beyond the radius
+    /// are evicted to a RegionFile. All file access and chunk generation happens on a
+    /// background I/O thread. Update() only queues work and installs finished chunks, so it
+    /// never waits on the disk. A chunk the player reaches before it arrives reads as solid
+    /// wall until it does, and is counted as a prefetch miss.
+    ///
+    /// An evicted chunk that can't be written out is put back in the map, and its store is tried
+    /// again the next time it's evicted. A chunk that can't be loaded is not asked for again
+    /// until the next Prime().
+    class ChunkStreamer {
+    private:
+        enum class ChunkState : uint8_t { Unloaded, Loading, Resident, Failed };
+
+        struct Request {
+            size_t index = 0;
+            /// @brief The chunk to write out; null for a load.
+            std::unique_ptr<TileChunk> chunk;
+            /// @brief Whether `chunk` was taken out of the map, rather than copied.
+            bool released = false;
+        };
+
+        struct Loaded {
+            size_t index = 0;
+            /// @brief Null if the load failed.
+            std::unique_ptr<TileChunk> chunk;
+            /// @brief Whether this is an evicted chunk coming back because it couldn't be stored.
+            bool unstored = false;
+        };
+
+        TileMap& m_map;
+        RegionFile m_region;
+        ChunkSource m_source;
+        int m_resident_radius;
+        int m_prefetch_margin;
+
+        std::vector<ChunkState> m_states;
+        std::vector<size_t> m_resident;
+        /// @brief The chunk-coordinate rectangle that had to be resident at the last Update.
+        Rect m_required{};
+        StreamingStats m_stats{};
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::deque<Request> m_requests;
+        std::vector<Loaded> m_loaded;
+        size_t m_busy = 0;
+        /// @brief Stores that have failed, ever.
+        uint64_t m_failed_stores = 0;
+        bool m_stopping = false;
+        std::atomic<uint64_t> m_generated{0};
+        std::atomic<uint64_t> m_page_outs{0};
+        std::thread m_worker;
+
+        void WorkerLoop();
+
+        /// @brief The chunks overlapped by tiles within `radius` of `focus`.
+        [[nodiscard]] auto ChunkRange(Vec2 focus, int radius) const -> Rect;
+
+        /// @brief Queues loads for every unloaded chunk in `range`, nearest to `focus` first.
+        void RequestRange(const Rect& range, Vec2 focus);
+        void EvictOutside(const Rect& range);
+        void InstallLoaded();
+
+    public:
+        /// @param fingerprint Identifies the level `source` generates; see RegionFile.
+        /// @param resident_radius Tiles around the focus that must be in memory.
+        /// @param prefetch_margin How far beyond that to start loading chunks ahead of time.
+        ChunkStreamer(
+            TileMap& map, const std::string& region_path, uint64_t fingerprint, ChunkSource source,
+            int resident_radius, int prefetch_margin
+        );
+        ~ChunkStreamer();
+
+        ChunkStreamer(const ChunkStreamer&) = delete;
+        auto operator=(const ChunkStreamer&) -> ChunkStreamer& = delete;
+        ChunkStreamer(ChunkStreamer&&) = delete;
+        auto operator=(ChunkStreamer&&) -> ChunkStreamer& = delete;
+
+        /// @brief Installs finished loads, then queues prefetches and evictions around `focus`.
+        /// Never blocks on I/O.
+        void Update(Vec2 focus);
+
+        /// @brief Loads everything around `focus` and waits for it, for when the focus jumps,
+        /// e.g. on level start or teleport. Does not count towards the prefetch statistics.
+        void Prime(Vec2 focus);
+
+        /// @brief Blocks until all queued loads and stores are finished, then installs the loads.
+        void WaitIdle();
+
+        /// @brief Writes every resident chunk to the region file and waits for it, so the file
+        /// holds the whole map as it stands.
+        /// @return False if any chunk couldn't be written.
+        auto StoreAll() -> bool;
+
+        [[nodiscard]] auto Stats() const -> StreamingStats;
+    };
+} // namespace rglike
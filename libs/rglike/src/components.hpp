@@ -0,0 +1,50 @@
+/**
+ * @file components.hpp
+ * @author Alic Szecsei
+ * @date 6/24/2023
+ */
+
+#pragma once
+
+#include "constants.hpp"
+#include "math.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace rglike {
+    /// @brief Where an entity stands on the map.
+    struct Position {
+        Vec2 pos{0, 0};
+    };
+
+    /// @brief Which faction an entity belongs to, by faction ID.
+    struct FactionMember {
+        std::string faction;
+    };
+
+    /// @brief A faction ID interned to a small integer by FactionMatrix.
+    using FactionId = uint16_t;
+
+    /// @brief The interned form of an entity's FactionMember, kept up to date by FactionMatrix
+    /// while it is connected. Not saved.
+    struct FactionIndex {
+        FactionId id = 0;
+    };
+
+    /// @brief Casts colored light from the entity's Position, fading out to nothing just past
+    /// `radius` tiles. Defaults to a torch.
+    struct LightSource {
+        uint8_t red = 255;
+        uint8_t green = 160;
+        uint8_t blue = 64;
+        int radius = 6;
+    };
+
+    /// @brief Something that takes turns. It gains `speed` energy every tick and acts once it has
+    /// at least ACTION_COST. Change `speed` through TurnScheduler::SetSpeed.
+    struct Actor {
+        int speed = NORMAL_SPEED;
+        int energy = 0;
+    };
+} // namespace rglike
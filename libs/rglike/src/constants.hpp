@@ -10,6 +10,35 @@ namespace rglike {
     constexpr int LEFT_SIDEBAR_WIDTH = 30;
     constexpr int RIGHT_SIDEBAR_WIDTH = 30;
     constexpr int LOG_HEIGHT = 8;
+    constexpr int CAMERA_SCROLL_MARGIN = 8;
 
-    constexpr int MAX_LOG_LINES = 50;
+    constexpr int MAX_LOG_LINES = 2000;
+    /// @brief How many distinct colors the game log can draw with.
+    constexpr int MAX_LOG_COLORS = 256;
+    /// @brief How many finished log entries can wait for the UI thread. Must be a power of two.
+    constexpr int LOG_QUEUE_CAPACITY = 1024;
+
+    constexpr int DEFAULT_MAP_WIDTH = 256;
+    constexpr int DEFAULT_MAP_HEIGHT = 256;
+    constexpr int PLAYER_SIGHT_RADIUS = 16;
+    /// @brief How far monsters notice each other, and the player.
+    constexpr int MONSTER_SIGHT_RADIUS = 12;
+    constexpr int DIJKSTRA_FIELD_RADIUS = 48;
+
+    /// @brief How many particles can be on screen at once.
+    constexpr int MAX_PARTICLES = 1024;
+    /// @brief Milliseconds between successive particles of a line effect appearing.
+    constexpr int PARTICLE_LINE_STEP_MS = 25;
+
+    /// @brief Energy an actor spends on an ordinary action, and needs before it can act at all.
+    constexpr int ACTION_COST = 100;
+    /// @brief Energy an average actor gains per tick.
+    constexpr int NORMAL_SPEED = 10;
+    /// @brief Ticks that pass for every action the player takes.
+    constexpr int TICKS_PER_TURN = ACTION_COST / NORMAL_SPEED;
+
+    /// @brief Tiles around the player kept in memory on streamed levels.
+    constexpr int STREAMING_RESIDENT_RADIUS = 96;
+    /// @brief How far beyond the resident radius chunks are loaded ahead of the player.
+    constexpr int STREAMING_PREFETCH_MARGIN = 64;
 } // namespace rglike
@@ -0,0 +1,167 @@
+/**
+ * @file dijkstra_map.cpp
+ * @author Alic Szecsei
+ * @date 6/24/2023
+ */
+
+#include "dijkstra_map.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace rglike {
+    namespace {
+        auto OpenCompare = [](const auto& a, const auto& b) {
+            return a.value > b.value;
+        };
+    } // namespace
+
+    void DijkstraMap::Reset(const TileMap& map, Rect window) {
+        m_window = window.Intersect(Rect{Vec2::Zero(), Vec2{map.Width(), map.Height()}});
+        if (m_window.Empty()) { m_window = Rect{}; }
+
+        auto area = static_cast<size_t>(std::max(0, m_window.Width())) *
+                    static_cast<size_t>(std::max(0, m_window.Height()));
+        m_values.assign(area, UNREACHABLE);
+        m_flow.assign(area, NO_FLOW);
+        m_open.clear();
+    }
+
+    void DijkstraMap::Relax(const TileMap& map) {
+        m_lowered.clear();
+        std::make_heap(m_open.begin(), m_open.end(), OpenCompare);
+
+        while (!m_open.empty()) {
+            std::pop_heap(m_open.begin(), m_open.end(), OpenCompare);
+            auto entry = m_open.back();
+            m_open.pop_back();
+            if (entry.value != m_values[entry.index]) { continue; }
+
+            Vec2 pos = Position(entry.index);
+            for (const auto& dir : NEIGHBOR_OFFSETS) {
+                Vec2 next = pos + dir;
+                if (!m_window.Contains(next) || !map.CanStep(pos, dir)) { continue; }
+
+                auto value = entry.value + DIJKSTRA_STEP * std::max(1, map.MoveCost(next));
+                auto next_index = Index(next);
+                if (value < m_values[next_index]) {
+                    m_values[next_index] = value;
+                    m_lowered.push_back(next_index);
+                    m_open.push_back(OpenEntry{value, next_index});
+                    std::push_heap(m_open.begin(), m_open.end(), OpenCompare);
+                }
+            }
+        }
+    }
+
+    void DijkstraMap::Scan(const TileMap& map) {
+        // Seed the open list with every tile that already has a value.
+        for (uint32_t i = 0; i < m_values.size(); ++i) {
+            if (m_values[i] != UNREACHABLE) { m_open.push_back(OpenEntry{m_values[i], i}); }
+        }
+        Relax(map);
+    }
+
+    void DijkstraMap::ComputeFlowAt(const TileMap& map, uint32_t index) {
+        if (m_values[index] == UNREACHABLE) {
+            m_flow[index] = NO_FLOW;
+            return;
+        }
+
+        Vec2 pos = Position(index);
+        auto best = m_values[index];
+        auto best_dir = NO_FLOW;
+        for (uint8_t d = 0; d < NEIGHBOR_OFFSETS.size(); ++d) {
+            Vec2 next = pos + NEIGHBOR_OFFSETS[d];
+            if (!m_window.Contains(next) || !map.CanStep(pos, NEIGHBOR_OFFSETS[d])) { continue; }
+            auto value = m_values[Index(next)];
+            if (value < best) {
+                best = value;
+                best_dir = d;
+            }
+        }
+        m_flow[index] = best_dir;
+    }
+
+    void DijkstraMap::ComputeFlow(const TileMap& map) {
+        for (uint32_t i = 0; i < m_values.size(); ++i) { ComputeFlowAt(map, i); }
+    }
+
+    auto DijkstraMap::MoveGoal(const TileMap& map, Vec2 goal) -> bool {
+        auto back = m_goal - goal;
+        if (std::abs(back.X()) > 1 || std::abs(back.Y()) > 1 || !map.CanStep(goal, back)) {
+            return false;
+        }
+        auto needed = Rect::Around(goal, m_radius)
+                          .Intersect(Rect{Vec2::Zero(), Vec2{map.Width(), map.Height()}});
+        bool covered = needed.min.X() >= m_window.min.X() && needed.min.Y() >= m_window.min.Y() &&
+                       needed.max.X() <= m_window.max.X() && needed.max.Y() <= m_window.max.Y();
+        if (!covered || !m_window.Contains(goal) || !m_window.Contains(m_goal)) { return false; }
+
+        // Going by way of the old goal, every tile is one step further away than it was. Those
+        // costs are all consistent with each other, so only tiles the new goal beats them on get
+        // relaxed. Every other tile moves by the same amount and keeps its flow.
+        auto detour = DIJKSTRA_STEP * std::max(1, map.MoveCost(m_goal));
+        for (auto& value : m_values) {
+            if (value != UNREACHABLE) { value += detour; }
+        }
+
+        m_goal = goal;
+        auto index = Index(goal);
+        m_values[index] = 0;
+        m_open.clear();
+        m_open.push_back(OpenEntry{0, index});
+        Relax(map);
+        m_lowered.push_back(index);
+
+        for (auto lowered : m_lowered) {
+            Vec2 pos = Position(lowered);
+            ComputeFlowAt(map, lowered);
+            for (const auto& dir : NEIGHBOR_OFFSETS) {
+                if (m_window.Contains(pos + dir)) { ComputeFlowAt(map, Index(pos + dir)); }
+            }
+        }
+        return true;
+    }
+
+    auto DijkstraMap::BuildApproach(const TileMap& map, Vec2 goal, int radius) -> bool {
+        bool unchanged = m_revision != 0 && radius == m_radius &&
+                         map.Revision() == m_map_revision &&
+                         !map.ResidencyChangedIn(m_residency_revision, m_window);
+        m_residency_revision = map.ResidencyRevision();
+        if (unchanged && goal == m_goal) { return false; }
+
+        if (unchanged && MoveGoal(map, goal)) {
+            ++m_revision;
+            return true;
+        }
+
+        m_goal = goal;
+        m_radius = radius;
+        m_map_revision = map.Revision();
+        Reset(map, Rect::Around(goal, radius + DIJKSTRA_WINDOW_SLACK));
+        if (m_window.Contains(goal)) { m_values[Index(goal)] = 0; }
+
+        Scan(map);
+        ComputeFlow(map);
+        ++m_revision;
+        return true;
+    }
+
+    auto DijkstraMap::BuildFlee(const TileMap& map, const DijkstraMap& approach) -> bool {
+        if (m_revision != 0 && approach.Revision() == m_source_revision) { return false; }
+
+        m_source_revision = approach.Revision();
+        m_map_revision = map.Revision();
+        Reset(map, approach.Window());
+        for (size_t i = 0; i < m_values.size(); ++i) {
+            auto value = approach.m_values[i];
+            if (value != UNREACHABLE) { m_values[i] = value * FLEE_COEFFICIENT_TENTHS / 10; }
+        }
+
+        Scan(map);
+        ComputeFlow(map);
+        ++m_revision;
+        return true;
+    }
+} // namespace rglike
@@ -0,0 +1,115 @@
+/**
+ * @file dijkstra_map.hpp
+ * @author Alic Szecsei
+ * @date 6/24/2023
+ */
+
+#pragma once
+
+#include "math.hpp"
+#include "tile_map.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace rglike {
+    /// @brief Field value of one step onto ordinary ground. Fields are fixed-point so the flee
+    /// coefficient can scale them without floating point.
+    constexpr int32_t DIJKSTRA_STEP = 10;
+    /// @brief The classic "multiply by -1.2 and rescan" factor for flee maps, in tenths.
+    constexpr int32_t FLEE_COEFFICIENT_TENTHS = -12;
+    /// @brief How far past its radius an approach field's window reaches, so the goal can wander
+    /// that far before the window has to be moved and the field built from scratch.
+    constexpr int DIJKSTRA_WINDOW_SLACK = 4;
+
+    /// @brief A Dijkstra map (flow field) over a square window of the tile map.
+    ///
+    /// Every tile in the window holds its cost-distance to the nearest goal, and the downhill
+    /// direction is precomputed, so any number of entities can read their next step in O(1).
+    /// Diagonal steps cost the same as orthogonal ones and never cut corners.
+    ///
+    /// When the goal takes a single step, the approach field is updated rather than rebuilt: the
+    /// old values plus the cost of that step are all still reachable costs, so only the tiles the
+    /// new goal is closer to need rescanning, and only they and their neighbors get a new flow
+    /// direction.
+    class DijkstraMap {
+    public:
+        static constexpr int32_t UNREACHABLE = std::numeric_limits<int32_t>::max();
+
+    private:
+        /// @brief Flow value for tiles with no downhill neighbor.
+        static constexpr uint8_t NO_FLOW = 0xFF;
+
+        struct OpenEntry {
+            int32_t value;
+            uint32_t index;
+        };
+
+        Rect m_window{};
+        std::vector<int32_t> m_values;
+        std::vector<uint8_t> m_flow;
+        std::vector<OpenEntry> m_open;
+        /// @brief Tiles whose value dropped during the last Relax().
+        std::vector<uint32_t> m_lowered;
+
+        Vec2 m_goal{0, 0};
+        int m_radius = -1;
+        uint64_t m_map_revision = 0;
+        uint64_t m_residency_revision = 0;
+        uint64_t m_source_revision = 0;
+        uint64_t m_revision = 0;
+
+        [[nodiscard]] inline auto Index(Vec2 pos) const -> uint32_t {
+            auto local = pos - m_window.min;
+            return static_cast<uint32_t>(local.Y() * m_window.Width() + local.X());
+        }
+
+        [[nodiscard]] inline auto Position(uint32_t index) const -> Vec2 {
+            auto width = static_cast<uint32_t>(m_window.Width());
+            return m_window.min +
+                   Vec2{static_cast<int>(index % width), static_cast<int>(index / width)};
+        }
+
+        void Reset(const TileMap& map, Rect window);
+        /// @brief Runs Dijkstra from whatever is on the open list.
+        void Relax(const TileMap& map);
+        void Scan(const TileMap& map);
+        void ComputeFlowAt(const TileMap& map, uint32_t index);
+        void ComputeFlow(const TileMap& map);
+        /// @brief Moves the goal by one step without rebuilding, if the window still covers it.
+        /// @return False if a full rebuild is needed instead.
+        auto MoveGoal(const TileMap& map, Vec2 goal) -> bool;
+
+    public:
+        /// @brief Makes this a distance-to-`goal` field covering at least `radius` tiles around
+        /// it. Does nothing if neither the goal nor the map has changed since the last build, and
+        /// only updates the field if the goal took one step. Chunks paged in or out only count as
+        /// a change if they overlap the field.
+        /// @return Whether the field changed.
+        auto BuildApproach(const TileMap& map, Vec2 goal, int radius) -> bool;
+
+        /// @brief Makes this a flee field from `approach`: every reachable value is multiplied
+        /// by -1.2 and the field is rescanned, so that fleeing entities head for distant exits
+        /// instead of into corners. Does nothing if `approach` has not changed.
+        /// @return Whether the field was rebuilt.
+        auto BuildFlee(const TileMap& map, const DijkstraMap& approach) -> bool;
+
+        [[nodiscard]] inline auto Value(Vec2 pos) const -> int32_t {
+            return m_window.Contains(pos) ? m_values[Index(pos)] : UNREACHABLE;
+        }
+
+        /// @brief The direction an entity standing on `pos` should step in, or zero if it is
+        /// already at a local minimum or outside the field.
+        [[nodiscard]] inline auto NextStep(Vec2 pos) const -> Vec2 {
+            if (!m_window.Contains(pos)) { return Vec2::Zero(); }
+            auto flow = m_flow[Index(pos)];
+            return flow == NO_FLOW ? Vec2::Zero() : NEIGHBOR_OFFSETS[flow];
+        }
+
+        [[nodiscard]] inline auto Window() const -> const Rect& { return m_window; }
+
+        /// @brief Bumped every time the field is rebuilt.
+        [[nodiscard]] inline auto Revision() const -> uint64_t { return m_revision; }
+    };
+} // namespace rglike
@@ -0,0 +1,436 @@
+/**
+ * @file dungeon.cpp
+ * @author Alic Szecsei
+ * @date 6/29/2023
+ */
+
+#include "dungeon.hpp"
+
+#include "constants.hpp"
+#include "random.hpp"
+#include "rglike/generation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <vector>
+
+namespace rglike {
+    namespace {
+        /// @brief Rooms are not split below this many tiles on a side.
+        constexpr int MIN_ROOM_LEAF = 8;
+        constexpr int CAVE_WALL_PERCENT = 45;
+        constexpr int CAVE_ITERATIONS = 4;
+        constexpr int TUNNEL_FLOOR_PERCENT = 35;
+        /// @brief How often a corridor heads straight for its target rather than wandering.
+        constexpr int CORRIDOR_BIAS_PERCENT = 70;
+
+        constexpr uint64_t SALT_CHUNK = 0x6368756e6b;
+        constexpr uint64_t SALT_STYLE = 0x7374796c65;
+        constexpr uint64_t SALT_VERTICAL_DOOR = 0x76646f6f72;
+        constexpr uint64_t SALT_HORIZONTAL_DOOR = 0x68646f6f72;
+
+        constexpr auto Hash(uint64_t seed, uint64_t salt, int x, int y) -> uint64_t {
+            return Mix(Mix(seed ^ Mix(salt)) ^ PackVec2(Vec2{x, y}));
+        }
+
+        /// @brief The part of chunk (`chunk_x`, `chunk_y`) that lies inside the level.
+        auto ChunkExtent(const DungeonSettings& settings, int chunk_x, int chunk_y) -> Vec2 {
+            return Vec2{
+                std::clamp(settings.width - (chunk_x << CHUNK_SHIFT), 0, CHUNK_SIZE),
+                std::clamp(settings.height - (chunk_y << CHUNK_SHIFT), 0, CHUNK_SIZE),
+            };
+        }
+
+        /// @brief Whether a chunk has any room inside its wall ring. Chunks that do not are left
+        /// solid and get no doorways.
+        auto HasInterior(const DungeonSettings& settings, int chunk_x, int chunk_y) -> bool {
+            if (chunk_x < 0 || chunk_y < 0) { return false; }
+            auto extent = ChunkExtent(settings, chunk_x, chunk_y);
+            return extent.X() >= 3 && extent.Y() >= 3;
+        }
+
+        /// @brief The local row of the doorway between a chunk and the one to its right.
+        auto VerticalDoor(uint64_t seed, int chunk_x, int chunk_y, int height) -> int {
+            return Rng{Hash(seed, SALT_VERTICAL_DOOR, chunk_x, chunk_y)}.Range(1, height - 2);
+        }
+
+        /// @brief The local column of the doorway between a chunk and the one below it.
+        auto HorizontalDoor(uint64_t seed, int chunk_x, int chunk_y, int width) -> int {
+            return Rng{Hash(seed, SALT_HORIZONTAL_DOOR, chunk_x, chunk_y)}.Range(1, width - 2);
+        }
+
+        /// @brief Scratch floor plan for a single chunk. Everything outside the interior stays
+        /// wall apart from doorways, so each chunk is sealed off except where it agreed to be.
+        class ChunkPlan {
+        private:
+            int m_width;
+            int m_height;
+            std::bitset<CHUNK_AREA> m_floor{};
+            size_t m_floor_count = 0;
+
+            static auto Index(Vec2 pos) -> size_t {
+                return static_cast<size_t>(TileChunk::Index(pos.X(), pos.Y()));
+            }
+
+        public:
+            ChunkPlan(int width, int height)
+                : m_width(width)
+                , m_height(height) { }
+
+            [[nodiscard]] auto Width() const -> int { return m_width; }
+
+            [[nodiscard]] auto Height() const -> int { return m_height; }
+
+            [[nodiscard]] auto Interior() const -> Rect {
+                return Rect{Vec2{1, 1}, Vec2{m_width - 1, m_height - 1}};
+            }
+
+            [[nodiscard]] auto IsFloor(Vec2 pos) const -> bool { return m_floor[Index(pos)]; }
+
+            void Set(Vec2 pos, bool floor) {
+                auto idx = Index(pos);
+                if (m_floor[idx] != floor) {
+                    m_floor_count = floor ? m_floor_count + 1 : m_floor_count - 1;
+                    m_floor[idx] = floor;
+                }
+            }
+
+            void Carve(Vec2 pos) { Set(pos, true); }
+
+            [[nodiscard]] auto FloorCount() const -> size_t { return m_floor_count; }
+
+            /// @brief Walls off any floor not orthogonally connected to `start`. Diagonal steps
+            /// need both orthogonal neighbors open, so this is exactly what can be walked to.
+            void KeepReachable(Vec2 start) {
+                std::bitset<CHUNK_AREA> seen{};
+                std::vector<Vec2> stack{start};
+                seen[Index(start)] = true;
+                while (!stack.empty()) {
+                    auto pos = stack.back();
+                    stack.pop_back();
+                    for (int dir = 0; dir < 4; ++dir) {
+                        auto next = pos + NEIGHBOR_OFFSETS[dir];
+                        if (next.X() < 0 || next.Y() < 0 || next.X() >= m_width ||
+                            next.Y() >= m_height) {
+                            continue;
+                        }
+                        auto idx = Index(next);
+                        if (seen[idx] || !m_floor[idx]) { continue; }
+                        seen[idx] = true;
+                        stack.push_back(next);
+                    }
+                }
+                m_floor &= seen;
+                m_floor_count = m_floor.count();
+            }
+        };
+
+        /// @brief Digs a corridor from `from` to `to` that mostly heads for its target but wanders
+        /// now and again. Both ends must be inside the interior.
+        void CarveCorridor(ChunkPlan& plan, Rng& rng, Vec2 from, Vec2 to) {
+            auto interior = plan.Interior();
+            auto pos = from;
+            int wander_budget = 2 * (plan.Width() + plan.Height());
+            plan.Carve(pos);
+            while (pos != to) {
+                Vec2 step{0, 0};
+                if (wander_budget > 0 && !rng.Percent(CORRIDOR_BIAS_PERCENT)) {
+                    --wander_budget;
+                    step = NEIGHBOR_OFFSETS[rng.Range(0, 3)];
+                } else {
+                    auto delta = to - pos;
+                    bool horizontal = delta.Y() == 0 || (delta.X() != 0 && rng.Percent(50));
+                    step = horizontal ? Vec2{delta.X() > 0 ? 1 : -1, 0}
+                                      : Vec2{0, delta.Y() > 0 ? 1 : -1};
+                }
+
+                auto next = pos + step;
+                if (!interior.Contains(next)) { continue; }
+                pos = next;
+                plan.Carve(pos);
+            }
+        }
+
+        /// @brief An L-shaped corridor, for joining rooms.
+        void CarveElbow(ChunkPlan& plan, Rng& rng, Vec2 from, Vec2 to) {
+            auto corner = rng.Percent(50) ? Vec2{to.X(), from.Y()} : Vec2{from.X(), to.Y()};
+            for (auto [a, b] : {std::pair{from, corner}, std::pair{corner, to}}) {
+                auto min = Vec2{std::min(a.X(), b.X()), std::min(a.Y(), b.Y())};
+                auto max = Vec2{std::max(a.X(), b.X()), std::max(a.Y(), b.Y())};
+                for (int y = min.Y(); y <= max.Y(); ++y) {
+                    for (int x = min.X(); x <= max.X(); ++x) { plan.Carve(Vec2{x, y}); }
+                }
+            }
+        }
+
+        /// @brief Recursively partitions `area` and places a room in every leaf, joining siblings
+        /// as the recursion unwinds.
+        /// @return The center of one room in `area`, for the caller to connect to.
+        auto CarveRooms(ChunkPlan& plan, Rng& rng, const Rect& area) -> Vec2 {
+            bool split_x = area.Width() >= 2 * MIN_ROOM_LEAF;
+            bool split_y = area.Height() >= 2 * MIN_ROOM_LEAF;
+            if (split_x && split_y) {
+                split_x = area.Width() == area.Height() ? rng.Percent(50)
+                                                        : area.Width() > area.Height();
+                split_y = !split_x;
+            }
+
+            if (split_x || split_y) {
+                Rect first = area;
+                Rect second = area;
+                if (split_x) {
+                    int cut = rng.Range(area.min.X() + MIN_ROOM_LEAF, area.max.X() - MIN_ROOM_LEAF);
+                    first.max = Vec2{cut, area.max.Y()};
+                    second.min = Vec2{cut, area.min.Y()};
+                } else {
+                    int cut = rng.Range(area.min.Y() + MIN_ROOM_LEAF, area.max.Y() - MIN_ROOM_LEAF);
+                    first.max = Vec2{area.max.X(), cut};
+                    second.min = Vec2{area.min.X(), cut};
+                }
+                auto a = CarveRooms(plan, rng, first);
+                auto b = CarveRooms(plan, rng, second);
+                CarveElbow(plan, rng, a, b);
+                return rng.Percent(50) ? a : b;
+            }
+
+            // Leave a one-tile margin on the far sides so neighboring rooms rarely merge.
+            auto room_size = [&](int leaf) {
+                int largest = std::max(1, leaf - 1);
+                return rng.Range(std::max(1, largest / 2), largest);
+            };
+            int width = room_size(area.Width());
+            int height = room_size(area.Height());
+            auto min = area.min + Vec2{
+                                      rng.Range(0, area.Width() - width),
+                                      rng.Range(0, area.Height() - height),
+                                  };
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) { plan.Carve(min + Vec2{x, y}); }
+            }
+            return min + Vec2{width / 2, height / 2};
+        }
+
+        void CarveCaves(ChunkPlan& plan, Rng& rng) {
+            auto interior = plan.Interior();
+
+            // One byte per tile, 1 for wall, so neighbor counts are plain sums. Tiles outside the
+            // interior stay wall throughout.
+            std::array<uint8_t, CHUNK_AREA> walls{};
+            walls.fill(1);
+            for (int y = interior.min.Y(); y < interior.max.Y(); ++y) {
+                for (int x = interior.min.X(); x < interior.max.X(); ++x) {
+                    walls[TileChunk::Index(x, y)] = rng.Percent(CAVE_WALL_PERCENT) ? 1 : 0;
+                }
+            }
+
+            // Each pass reads from the previous one, so results do not depend on scan order.
+            std::array<uint8_t, CHUNK_SIZE> column_sums{};
+            for (int pass = 0; pass < CAVE_ITERATIONS; ++pass) {
+                auto next = walls;
+                for (int y = interior.min.Y(); y < interior.max.Y(); ++y) {
+                    const auto* above = &walls[TileChunk::Index(0, y - 1)];
+                    const auto* row = &walls[TileChunk::Index(0, y)];
+                    const auto* below = &walls[TileChunk::Index(0, y + 1)];
+                    for (int x = 0; x < CHUNK_SIZE; ++x) {
+                        column_sums[x] = static_cast<uint8_t>(above[x] + row[x] + below[x]);
+                    }
+                    for (int x = interior.min.X(); x < interior.max.X(); ++x) {
+                        int neighbors =
+                            column_sums[x - 1] + column_sums[x] + column_sums[x + 1] - row[x];
+                        if (neighbors > 4) { next[TileChunk::Index(x, y)] = 1; }
+                        if (neighbors < 4) { next[TileChunk::Index(x, y)] = 0; }
+                    }
+                }
+                walls = next;
+            }
+
+            for (int y = interior.min.Y(); y < interior.max.Y(); ++y) {
+                for (int x = interior.min.X(); x < interior.max.X(); ++x) {
+                    plan.Set(Vec2{x, y}, walls[TileChunk::Index(x, y)] == 0);
+                }
+            }
+        }
+
+        void CarveTunnels(ChunkPlan& plan, Rng& rng, Vec2 start) {
+            auto interior = plan.Interior();
+            auto area = static_cast<size_t>(interior.Width() * interior.Height());
+            auto target = area * TUNNEL_FLOOR_PERCENT / 100;
+            auto pos = start;
+            plan.Carve(pos);
+            for (size_t steps = 0; plan.FloorCount() < target && steps < area * 8; ++steps) {
+                auto next = pos + NEIGHBOR_OFFSETS[rng.Range(0, 3)];
+                if (!interior.Contains(next)) { continue; }
+                pos = next;
+                plan.Carve(pos);
+            }
+        }
+
+        void WriteChunk(const ChunkPlan& plan, const DungeonSettings& settings, TileChunk& chunk) {
+            for (int y = 0; y < CHUNK_SIZE; ++y) {
+                ChunkRowBits passable = 0;
+                ChunkRowBits opaque = 0;
+                for (int x = 0; x < CHUNK_SIZE; ++x) {
+                    bool inside = x < plan.Width() && y < plan.Height();
+                    const auto& tile =
+                        inside && plan.IsFloor(Vec2{x, y}) ? settings.floor : settings.wall;
+                    auto idx = TileChunk::Index(x, y);
+                    chunk.glyphs[idx] = tile.glyph;
+                    chunk.fg[idx] = tile.fg;
+                    chunk.bg[idx] = tile.bg;
+                    chunk.cost[idx] = tile.cost;
+                    passable |= tile.passable ? ChunkRowBits{1} << x : 0;
+                    opaque |= tile.opaque ? ChunkRowBits{1} << x : 0;
+                }
+                chunk.passable[y] = passable;
+                chunk.opaque[y] = opaque;
+            }
+        }
+    } // namespace
+
+    auto ChunkStyleAt(uint64_t seed, int chunk_x, int chunk_y) -> ChunkStyle {
+        return static_cast<ChunkStyle>(Rng{Hash(seed, SALT_STYLE, chunk_x, chunk_y)}.Range(0, 2));
+    }
+
+    void GenerateDungeonChunk(
+        const DungeonSettings& settings, int chunk_x, int chunk_y, TileChunk& chunk
+    ) {
+        auto extent = ChunkExtent(settings, chunk_x, chunk_y);
+        ChunkPlan plan{extent.X(), extent.Y()};
+        if (!HasInterior(settings, chunk_x, chunk_y)) {
+            WriteChunk(plan, settings, chunk);
+            return;
+        }
+
+        Rng rng{Hash(settings.seed, SALT_CHUNK, chunk_x, chunk_y)};
+        Vec2 center{plan.Width() / 2, plan.Height() / 2};
+        switch (ChunkStyleAt(settings.seed, chunk_x, chunk_y)) {
+        case ChunkStyle::Rooms:
+            CarveElbow(plan, rng, center, CarveRooms(plan, rng, plan.Interior()));
+            break;
+        case ChunkStyle::Caves:
+            CarveCaves(plan, rng);
+            break;
+        case ChunkStyle::Tunnels:
+            CarveTunnels(plan, rng, center);
+            break;
+        }
+        plan.Carve(center);
+
+        // Doorways, each with the tile just inside it, joined up to the center.
+        std::vector<std::pair<Vec2, Vec2>> doors{};
+        int w = plan.Width();
+        int h = plan.Height();
+        if (HasInterior(settings, chunk_x - 1, chunk_y)) {
+            int row = VerticalDoor(settings.seed, chunk_x - 1, chunk_y, h);
+            doors.emplace_back(Vec2{0, row}, Vec2{1, row});
+        }
+        if (HasInterior(settings, chunk_x + 1, chunk_y)) {
+            int row = VerticalDoor(settings.seed, chunk_x, chunk_y, h);
+            doors.emplace_back(Vec2{w - 1, row}, Vec2{w - 2, row});
+        }
+        if (HasInterior(settings, chunk_x, chunk_y - 1)) {
+            int column = HorizontalDoor(settings.seed, chunk_x, chunk_y - 1, w);
+            doors.emplace_back(Vec2{column, 0}, Vec2{column, 1});
+        }
+        if (HasInterior(settings, chunk_x, chunk_y + 1)) {
+            int column = HorizontalDoor(settings.seed, chunk_x, chunk_y, w);
+            doors.emplace_back(Vec2{column, h - 1}, Vec2{column, h - 2});
+        }
+        for (const auto& [door, inside] : doors) {
+            plan.Carve(door);
+            CarveCorridor(plan, rng, inside, center);
+        }
+
+        plan.KeepReachable(center);
+        WriteChunk(plan, settings, chunk);
+    }
+    auto GenerateDungeon(TileMap& map, const DungeonSettings& settings, ThreadPool* pool) -> Vec2 {
+        map.Resize(settings.width, settings.height, settings.wall);
+
+        auto chunks_wide = map.ChunksWide();
+        auto chunk_count = static_cast<size_t>(chunks_wide) * map.ChunksHigh();
+        auto generate = [&](size_t begin, size_t end, size_t /*worker*/) {
+            for (size_t i = begin; i < end; ++i) {
+                int chunk_x = static_cast<int>(i) % chunks_wide;
+                int chunk_y = static_cast<int>(i) / chunks_wide;
+                GenerateDungeonChunk(settings, chunk_x, chunk_y, map.Chunk(chunk_x, chunk_y));
+            }
+        };
+        if (pool != nullptr) {
+            pool->ParallelFor(chunk_count, 16, generate);
+        } else {
+            generate(0, chunk_count, 0);
+        }
+        map.Invalidate();
+        return DungeonSpawn(settings);
+    }
+
+    auto DungeonSpawn(const DungeonSettings& settings) -> Vec2 {
+        if (!HasInterior(settings, 0, 0)) { return Vec2::Zero(); }
+        auto extent = ChunkExtent(settings, 0, 0);
+        return Vec2{extent.X() / 2, extent.Y() / 2};
+    }
+
+    auto DungeonFingerprint(const DungeonSettings& settings) -> uint64_t {
+        auto fingerprint = Mix(settings.seed) ^ PackVec2(Vec2{settings.width, settings.height});
+        for (const auto& tile : {settings.floor, settings.wall}) {
+            uint64_t packed = static_cast<uint64_t>(tile.glyph) << 32 | uint64_t{tile.cost} << 16 |
+                              uint64_t{tile.passable} << 8 | uint64_t{tile.opaque};
+            fingerprint = Mix(fingerprint ^ packed);
+        }
+        return fingerprint;
+    }
+
+    auto LayoutChecksum(const TileMap& map) -> uint64_t {
+        constexpr uint64_t FNV_OFFSET = 0xCBF29CE484222325;
+        constexpr uint64_t FNV_PRIME = 0x100000001B3;
+
+        uint64_t hash = FNV_OFFSET;
+        auto feed = [&](uint64_t word) {
+            for (int byte = 0; byte < 8; ++byte) {
+                hash = (hash ^ ((word >> (byte * 8)) & 0xFF)) * FNV_PRIME;
+            }
+        };
+        feed(PackVec2(Vec2{map.Width(), map.Height()}));
+        for (int chunk_y = 0; chunk_y < map.ChunksHigh(); ++chunk_y) {
+            for (int chunk_x = 0; chunk_x < map.ChunksWide(); ++chunk_x) {
+                for (auto row : map.Chunk(chunk_x, chunk_y).passable) { feed(row); }
+            }
+        }
+        return hash;
+    }
+
+    auto GenerateLevel(const GenerationOptions& options) -> GenerationReport {
+        DungeonSettings settings{};
+        settings.seed = options.seed;
+        settings.width = options.width > 0 ? options.width : DEFAULT_MAP_WIDTH;
+        settings.height = options.height > 0 ? options.height : DEFAULT_MAP_HEIGHT;
+
+        ThreadPool pool{
+            options.threads < 0 ? ThreadPool::DefaultThreadCount()
+                                : static_cast<size_t>(options.threads),
+        };
+
+        TileMap map{};
+        auto start = std::chrono::steady_clock::now();
+        GenerateDungeon(map, settings, &pool);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        GenerationReport report{};
+        report.width = map.Width();
+        report.height = map.Height();
+        report.workers = pool.WorkerCount();
+        report.checksum = LayoutChecksum(map);
+        report.milliseconds = std::chrono::duration<double, std::milli>(elapsed).count();
+        for (int chunk_y = 0; chunk_y < map.ChunksHigh(); ++chunk_y) {
+            for (int chunk_x = 0; chunk_x < map.ChunksWide(); ++chunk_x) {
+                for (auto row : map.Chunk(chunk_x, chunk_y).passable) {
+                    report.floor_tiles += std::bitset<CHUNK_SIZE>(row).count();
+                }
+            }
+        }
+        return report;
+    }
+} // namespace rglike
@@ -0,0 +1,65 @@
+/**
+ * @file dungeon.hpp
+ * @author Alic Szecsei
+ * @date 6/29/2023
+ */
+
+#pragma once
+
+#include "math.hpp"
+#include "thread_pool.hpp"
+#include "tile_map.hpp"
+
+#include <cstdint>
+
+namespace rglike {
+    /// @brief How the inside of a chunk is carved out.
+    enum class ChunkStyle : uint8_t {
+        /// @brief Rectangular rooms from a binary space partition, joined by corridors.
+        Rooms,
+        /// @brief Organic caves grown with a cellular automaton.
+        Caves,
+        /// @brief Winding tunnels dug by a drunkard's walk.
+        Tunnels,
+    };
+
+    struct DungeonSettings {
+        uint64_t seed = 0;
+        int width = 0;
+        int height = 0;
+        Tile floor{U'.', ftxui::Color::GrayDark, ftxui::Color::Default, true, false};
+        Tile wall{U'#', ftxui::Color::GrayLight, ftxui::Color::Default, false, true};
+    };
+
+    /// @brief The style chunk (`chunk_x`, `chunk_y`) is generated with for `seed`.
+    [[nodiscard]] auto ChunkStyleAt(uint64_t seed, int chunk_x, int chunk_y) -> ChunkStyle;
+
+    /// @brief Generates chunk (`chunk_x`, `chunk_y`) of the level described by `settings` into
+    /// `chunk`. It comes out identical to the same chunk of a full GenerateDungeon call, so
+    /// streamed levels can generate chunks on demand.
+    void GenerateDungeonChunk(
+        const DungeonSettings& settings, int chunk_x, int chunk_y, TileChunk& chunk
+    );
+
+    /// @brief Replaces `map` with a freshly generated dungeon.
+    ///
+    /// Every chunk is generated from nothing but the seed and its own coordinates, so chunks run
+    /// in parallel on `pool` and the result is byte-identical for a given seed whatever the
+    /// thread count. Neighboring chunks agree on where the doorways in their shared edge are,
+    /// and every floor tile in a chunk is reachable from its doorways, so the whole level is
+    /// connected.
+    ///
+    /// @return A floor tile to start the player on.
+    auto GenerateDungeon(TileMap& map, const DungeonSettings& settings, ThreadPool* pool = nullptr)
+        -> Vec2;
+
+    /// @brief The floor tile GenerateDungeon starts the player on.
+    [[nodiscard]] auto DungeonSpawn(const DungeonSettings& settings) -> Vec2;
+
+    /// @brief Identifies the level `settings` generate: equal fingerprints mean every chunk
+    /// generates identically, so a RegionFile holding that level's chunks can be reused.
+    [[nodiscard]] auto DungeonFingerprint(const DungeonSettings& settings) -> uint64_t;
+
+    /// @brief An FNV-1a hash of the map's walkable layout, for checking determinism.
+    [[nodiscard]] auto LayoutChecksum(const TileMap& map) -> uint64_t;
+} // namespace rglike
@@ -0,0 +1,132 @@
+/**
+ * @file factions.cpp
+ * @author Alic Szecsei
+ * @date 6/24/2023
+ */
+
+#include "factions.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace rglike {
+    void FactionTable::Define(FactionDefinition faction) {
+        auto id = faction.id;
+        m_factions.insert_or_assign(std::move(id), std::move(faction));
+    }
+
+    auto FactionTable::Contains(std::string_view id) const -> bool {
+        return m_factions.find(std::string(id)) != m_factions.end();
+    }
+
+    auto FactionTable::Ids() const -> std::vector<std::string> {
+        std::vector<std::string> ids{};
+        ids.reserve(m_factions.size());
+        for (const auto& [id, faction] : m_factions) { ids.push_back(id); }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    auto FactionTable::DefaultResponse(std::string_view from) const -> Response {
+        auto faction = m_factions.find(std::string(from));
+        if (faction == m_factions.end()) { return Response::Ignore; }
+
+        const auto& responses = faction->second.responses;
+        auto fallback = responses.find(std::string(FACTION_DEFAULT));
+        return fallback != responses.end() ? fallback->second : Response::Ignore;
+    }
+
+    auto FactionTable::ResponseTo(std::string_view from, std::string_view to) const -> Response {
+        auto faction = m_factions.find(std::string(from));
+        if (faction == m_factions.end()) { return Response::Ignore; }
+
+        const auto& responses = faction->second.responses;
+        auto specific = responses.find(std::string(to));
+        if (specific != responses.end()) { return specific->second; }
+
+        if (from == to) {
+            auto self = responses.find(std::string(FACTION_SELF));
+            if (self != responses.end()) { return self->second; }
+        }
+
+        return DefaultResponse(from);
+    }
+
+    void FactionMatrix::Compile(const FactionTable& table) {
+        auto ids = table.Ids();
+        if (ids.size() >= std::numeric_limits<FactionId>::max()) {
+            throw std::runtime_error("Too many factions to intern");
+        }
+
+        m_ids.clear();
+        for (size_t i = 0; i < ids.size(); ++i) {
+            m_ids.emplace(ids[i], static_cast<FactionId>(i));
+        }
+
+        m_size = ids.size() + 1;
+        m_responses.assign(m_size * m_size, Response::Ignore);
+        for (size_t from = 0; from < ids.size(); ++from) {
+            auto* row = &m_responses[from * m_size];
+            for (size_t to = 0; to < ids.size(); ++to) {
+                row[to] = table.ResponseTo(ids[from], ids[to]);
+            }
+            row[Unknown()] = table.DefaultResponse(ids[from]);
+        }
+    }
+
+    auto FactionMatrix::Id(std::string_view faction) const -> FactionId {
+        auto it = m_ids.find(std::string(faction));
+        return it == m_ids.end() ? Unknown() : it->second;
+    }
+
+    void FactionMatrix::Connect(entt::registry& registry) {
+        registry.on_construct<FactionMember>().connect<&FactionMatrix::OnAssign>(*this);
+        registry.on_update<FactionMember>().connect<&FactionMatrix::OnAssign>(*this);
+        registry.on_destroy<FactionMember>().connect<&FactionMatrix::OnRemove>(*this);
+        Refresh(registry);
+    }
+
+    void FactionMatrix::Disconnect(entt::registry& registry) {
+        registry.on_construct<FactionMember>().disconnect<&FactionMatrix::OnAssign>(*this);
+        registry.on_update<FactionMember>().disconnect<&FactionMatrix::OnAssign>(*this);
+        registry.on_destroy<FactionMember>().disconnect<&FactionMatrix::OnRemove>(*this);
+    }
+
+    void FactionMatrix::Refresh(entt::registry& registry) {
+        for (auto entity : registry.view<FactionMember>()) { OnAssign(registry, entity); }
+    }
+
+    void FactionMatrix::OnAssign(entt::registry& registry, entt::entity entity) {
+        const auto& member = registry.get<FactionMember>(entity);
+        registry.emplace_or_replace<FactionIndex>(entity, FactionIndex{Id(member.faction)});
+    }
+
+    void FactionMatrix::OnRemove(entt::registry& registry, entt::entity entity) {
+        registry.remove<FactionIndex>(entity);
+    }
+
+    void DefineBaseFactions(FactionTable& table) {
+        const std::string default_key{FACTION_DEFAULT};
+        const std::string self_key{FACTION_SELF};
+        const std::string player{PLAYER_FACTION};
+
+        table.Define(FactionDefinition{player, "Player", {}});
+        table.Define(FactionDefinition{
+            "mindless",
+            "Mindless",
+            {{default_key, Response::Attack}},
+        });
+        table.Define(FactionDefinition{
+            "townsfolk",
+            "Townsfolk",
+            {{default_key, Response::Flee}, {self_key, Response::Ignore}, {player, Response::Ignore}},
+        });
+        table.Define(FactionDefinition{
+            "bandits",
+            "Bandits",
+            {{default_key, Response::Attack}, {self_key, Response::Ignore}},
+        });
+    }
+} // namespace rglike
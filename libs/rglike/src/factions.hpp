@@ -0,0 +1,110 @@
+/**
+ * @file factions.hpp
+ * @author Alic Szecsei
+ * @date 6/24/2023
+ */
+
+#pragma once
+
+#include "components.hpp"
+
+#include "entt/entt.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace rglike {
+    /// @brief How one faction reacts to another. Mirrors `rglike.Response` in the data scripts.
+    enum class Response : uint8_t {
+        Ignore,
+        Attack,
+        Flee,
+    };
+
+    /// @brief Response key matching any faction without a more specific entry.
+    constexpr std::string_view FACTION_DEFAULT = "Default";
+    /// @brief Response key matching members of the same faction.
+    constexpr std::string_view FACTION_SELF = "Self";
+    /// @brief The faction the player belongs to.
+    constexpr std::string_view PLAYER_FACTION = "player";
+
+    /// @brief The shape of `rglike.defineFaction` in the data scripts.
+    struct FactionDefinition {
+        std::string id;
+        std::string name;
+        std::unordered_map<std::string, Response> responses;
+    };
+
+    class FactionTable {
+    private:
+        std::unordered_map<std::string, FactionDefinition> m_factions;
+
+    public:
+        /// @brief Adds a faction, replacing any earlier faction with the same ID.
+        void Define(FactionDefinition faction);
+
+        [[nodiscard]] auto Contains(std::string_view id) const -> bool;
+
+        /// @brief Every faction ID, sorted.
+        [[nodiscard]] auto Ids() const -> std::vector<std::string>;
+
+        /// @brief How members of faction `from` react to factions it has no entry for.
+        [[nodiscard]] auto DefaultResponse(std::string_view from) const -> Response;
+
+        /// @brief How members of faction `from` react to members of faction `to`. Falls back to
+        /// the `Self` entry, then the `Default` entry, then Ignore.
+        [[nodiscard]] auto ResponseTo(std::string_view from, std::string_view to) const
+            -> Response;
+    };
+
+    /// @brief A FactionTable compiled into a dense table of responses, indexed by interned
+    /// faction IDs, so that comparing two entities' factions is an array lookup.
+    ///
+    /// IDs are handed out in sorted order, so they agree between runs. One extra ID stands for
+    /// every faction the table doesn't define: it ignores everyone, and everyone treats it by
+    /// their `Default` entry, as FactionTable::ResponseTo does.
+    ///
+    /// Connect() gives every FactionMember in a registry a matching FactionIndex and keeps it up
+    /// to date; Refresh() the registry after compiling a new table.
+    class FactionMatrix {
+    private:
+        std::unordered_map<std::string, FactionId> m_ids;
+        /// @brief Responses by `from * m_size + to`.
+        std::vector<Response> m_responses = std::vector<Response>(1, Response::Ignore);
+        size_t m_size = 1;
+
+        void OnAssign(entt::registry& registry, entt::entity entity);
+        void OnRemove(entt::registry& registry, entt::entity entity);
+
+    public:
+        void Compile(const FactionTable& table);
+
+        /// @brief How many IDs there are, including the one for undefined factions.
+        [[nodiscard]] inline auto Size() const -> size_t { return m_size; }
+
+        /// @brief The ID shared by every faction the table doesn't define.
+        [[nodiscard]] inline auto Unknown() const -> FactionId {
+            return static_cast<FactionId>(m_size - 1);
+        }
+
+        [[nodiscard]] auto Id(std::string_view faction) const -> FactionId;
+
+        /// @brief How members of faction `from` react to members of faction `to`.
+        [[nodiscard]] inline auto ResponseTo(FactionId from, FactionId to) const -> Response {
+            return m_responses[static_cast<size_t>(from) * m_size + to];
+        }
+
+        void Connect(entt::registry& registry);
+        void Disconnect(entt::registry& registry);
+
+        /// @brief Re-interns every FactionMember in `registry`.
+        void Refresh(entt::registry& registry);
+    };
+
+    /// @brief Defines the factions from `data/src/base/factions.ts`, until the script loader
+    /// can define them itself.
+    void DefineBaseFactions(FactionTable& table);
+} // namespace rglike
@@ -0,0 +1,77 @@
+/**
+ * @file format_cache.cpp
+ * @author Alic Szecsei
+ * @date 8/2/2023
+ */
+
+#include "rglike/format_cache.hpp"
+
+#include <cstring>
+
+namespace rglike {
+    using namespace formatting;
+
+    namespace {
+        /// @brief A hash for cache keys, eight bytes at a time. Collisions only cost a miss, since
+        /// the cache compares the strings too.
+        auto hash_markup(std::string_view markup) -> uint64_t {
+            constexpr uint64_t MULTIPLIER = 0x9E3779B97F4A7C15;
+            uint64_t hash = markup.size() * MULTIPLIER;
+            size_t pos = 0;
+            for (; pos + sizeof(uint64_t) <= markup.size(); pos += sizeof(uint64_t)) {
+                uint64_t word = 0;
+                std::memcpy(&word, markup.data() + pos, sizeof(word));
+                hash = (hash ^ word) * MULTIPLIER;
+                hash ^= hash >> 32;
+            }
+            uint64_t tail = 0;
+            if (pos < markup.size()) {
+                std::memcpy(&tail, markup.data() + pos, markup.size() - pos);
+            }
+            hash = (hash ^ tail) * MULTIPLIER;
+            return hash ^ (hash >> 29);
+        }
+    } // namespace
+
+    auto FormatCache::format(std::string_view markup) -> std::shared_ptr<const Text> {
+        auto hash = hash_markup(markup);
+        auto found = m_index.find(hash);
+        if (found != m_index.end() && found->second->markup == markup) {
+            ++m_stats.hits;
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+            return found->second->text;
+        }
+
+        ++m_stats.misses;
+        auto text = std::make_shared<const Text>(format_text(markup));
+        if (m_capacity == 0) { return text; }
+
+        // A different string with the same hash is simply replaced.
+        if (found != m_index.end()) {
+            m_entries.erase(found->second);
+            m_index.erase(found);
+        }
+        evict_to(m_capacity - 1);
+        m_entries.push_front(Entry{hash, std::string(markup), text});
+        m_index.emplace(hash, m_entries.begin());
+        return text;
+    }
+
+    void FormatCache::evict_to(size_t size) {
+        while (m_entries.size() > size) {
+            m_index.erase(m_entries.back().hash);
+            m_entries.pop_back();
+            ++m_stats.evictions;
+        }
+    }
+
+    void FormatCache::set_capacity(size_t capacity) {
+        m_capacity = capacity;
+        evict_to(capacity);
+    }
+
+    void FormatCache::clear() {
+        m_entries.clear();
+        m_index.clear();
+    }
+} // namespace rglike
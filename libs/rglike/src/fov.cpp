@@ -0,0 +1,89 @@
+/**
+ * @file fov.cpp
+ * @author Alic Szecsei
+ * @date 6/17/2023
+ */
+
+#include "fov.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace rglike {
+    void FieldOfView::ClearVisible(const Rect& area) {
+        auto clipped = area.Intersect(Rect{Vec2::Zero(), Vec2{m_width, m_height}});
+        if (clipped.Empty()) { return; }
+
+        for (int y = clipped.min.Y(); y < clipped.max.Y(); ++y) {
+            int x = clipped.min.X();
+            while (x < clipped.max.X()) {
+                // Clear the run of bits [x, run_end) that lives in one chunk row.
+                int run_end = std::min(clipped.max.X(), (x | CHUNK_MASK) + 1);
+                int lo = x & CHUNK_MASK;
+                int len = run_end - x;
+                ChunkRowBits mask = len == CHUNK_SIZE ? ~ChunkRowBits{0}
+                                                      : ((ChunkRowBits{1} << len) - 1) << lo;
+                ChunkAt(Vec2{x, y}).visible[y & CHUNK_MASK] &= ~mask;
+                x = run_end;
+            }
+        }
+    }
+
+    void FieldOfView::Cast(const TileMap& map) {
+        ShadowCast(
+            m_origin, m_radius, [&](Vec2 pos) { return map.IsOpaque(pos); },
+            [&](Vec2 pos) {
+                if (!InBounds(pos)) { return; }
+                auto& chunk = ChunkAt(pos);
+                auto bit = ChunkRowBits{1} << (pos.X() & CHUNK_MASK);
+                chunk.visible[pos.Y() & CHUNK_MASK] |= bit;
+                chunk.explored[pos.Y() & CHUNK_MASK] |= bit;
+            }
+        );
+
+        auto previous = m_bounds;
+        m_bounds = Rect::Around(m_origin, m_radius);
+        m_dirty = previous.Union(m_bounds);
+        m_map_revision = map.Revision();
+        m_residency_revision = map.ResidencyRevision();
+        ++m_revision;
+    }
+
+    void FieldOfView::Update(const TileMap& map, Vec2 origin, int radius) {
+        auto step = origin - m_origin;
+        bool stepped = m_radius == radius && map.Revision() == m_map_revision &&
+                       map.Width() == m_width && map.Height() == m_height &&
+                       std::abs(step.X()) <= 1 && std::abs(step.Y()) <= 1;
+        if (!stepped) {
+            Recompute(map, origin, radius);
+            return;
+        }
+        if (step == Vec2::Zero() && !map.ResidencyChangedIn(m_residency_revision, m_bounds)) {
+            m_residency_revision = map.ResidencyRevision();
+            return;
+        }
+
+        // Everything the viewer could see last time is inside the old bounds, so that is the only
+        // area that needs clearing. The cast itself still covers the whole radius.
+        ClearVisible(m_bounds);
+        m_origin = origin;
+        Cast(map);
+    }
+
+    void FieldOfView::Recompute(const TileMap& map, Vec2 origin, int radius) {
+        if (map.Width() != m_width || map.Height() != m_height) {
+            m_width = map.Width();
+            m_height = map.Height();
+            m_chunks_wide = map.ChunksWide();
+            m_chunks.assign(static_cast<size_t>(map.ChunksWide()) * map.ChunksHigh(), FovChunk{});
+        } else {
+            for (auto& chunk : m_chunks) { chunk.visible.fill(0); }
+        }
+
+        // Make the whole map dirty, since the viewer may have come from anywhere.
+        m_bounds = Rect{Vec2::Zero(), Vec2{m_width, m_height}};
+        m_origin = origin;
+        m_radius = radius;
+        Cast(map);
+    }
+} // namespace rglike
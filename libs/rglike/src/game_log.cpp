@@ -7,58 +7,156 @@
 
 #include "constants.hpp"
 
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
 namespace rglike {
+    void LogLine::Append(std::string_view text, LogStyle style) {
+        auto offset = static_cast<uint32_t>(m_text.size());
+        m_text.append(text);
+        m_fragments.push_back(GameLogFragment{offset, static_cast<uint32_t>(text.size()), style});
+    }
+
+    namespace {
+        /// @brief The line the calling thread is building, and the serial of the entry building it.
+        thread_local LogLine t_staging;
+        thread_local uint64_t t_serial = 0;
+
+        constexpr auto QUEUE_MASK = static_cast<size_t>(LOG_QUEUE_CAPACITY) - 1;
+        static_assert((LOG_QUEUE_CAPACITY & QUEUE_MASK) == 0, "must be a power of two");
+    } // namespace
+
     auto LogEntry::Color(ftxui::Color color) -> LogEntry& {
-        m_current_color = color;
+        m_style.color = m_log->PaletteIndex(color);
         return *this;
     }
 
     auto LogEntry::BgColor(ftxui::Color color) -> LogEntry& {
-        m_current_bg_color = color;
+        m_style.bg_color = m_log->PaletteIndex(color);
         return *this;
     }
 
     auto LogEntry::Bold(bool bold) -> LogEntry& {
-        m_current_bold = bold;
+        m_style.Set(LogStyle::BOLD, bold);
         return *this;
     }
 
     auto LogEntry::Dim(bool dim) -> LogEntry& {
-        m_current_dim = dim;
+        m_style.Set(LogStyle::DIM, dim);
         return *this;
     }
 
     auto LogEntry::Underline(bool underline) -> LogEntry& {
-        m_current_underlined = underline;
+        m_style.Set(LogStyle::UNDERLINED, underline);
         return *this;
     }
 
     auto LogEntry::Blink(bool blink) -> LogEntry& {
-        m_current_blinking = blink;
+        m_style.Set(LogStyle::BLINKING, blink);
         return *this;
     }
 
     auto LogEntry::Text(const std::string_view& text) -> LogEntry& {
-        m_fragments.emplace_back(
-            m_current_color, m_current_bg_color, m_current_bold, m_current_dim,
-            m_current_underlined, m_current_blinking, text
-        );
+        if (m_serial == t_serial) { t_staging.Append(text, m_style); }
         return *this;
     }
 
-    void LogEntry::Log() const { m_log->Log(*this); }
+    auto LogEntry::Log() const -> bool {
+        if (m_serial != t_serial) { return true; }
+        if (!m_log->Enqueue(t_staging)) { return false; }
+        // Invalidate the entry so logging it twice can't queue whatever is built next.
+        ++t_serial;
+        return true;
+    }
+
+    GameLog::GameLog()
+        : m_lines(MAX_LOG_LINES)
+        , m_queue(std::make_unique<QueuedLine[]>(LOG_QUEUE_CAPACITY)) {
+        for (size_t i = 0; i < static_cast<size_t>(LOG_QUEUE_CAPACITY); ++i) {
+            m_queue[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_palette[0] = ftxui::Color::Default;
+    }
 
     auto GameLog::GetInstance() -> GameLog& {
         static GameLog instance{};
         return instance;
     }
 
-    void GameLog::Log(const std::string_view& text) { Entry().Text(text).Log(); }
+    auto GameLog::PaletteIndex(ftxui::Color color) -> uint8_t {
+        auto size = m_palette_size.load(std::memory_order_acquire);
+        for (size_t i = 0; i < size; ++i) {
+            if (m_palette[i] == color) { return static_cast<uint8_t>(i); }
+        }
 
-    void GameLog::Log(const LogEntry& entry) {
-        if (m_log.size() == MAX_LOG_LINES) { m_log.pop_back(); }
-        m_log.push_front(entry.Fragments());
+        std::lock_guard lock{m_palette_mutex};
+        // Someone else may have added it since.
+        size = m_palette_size.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < size; ++i) {
+            if (m_palette[i] == color) { return static_cast<uint8_t>(i); }
+        }
+        if (size == m_palette.size()) {
+            spdlog::warn("Game log palette is full; drawing a new color as the default");
+            return 0;
+        }
+        m_palette[size] = color;
+        m_palette_size.store(size + 1, std::memory_order_release);
+        return static_cast<uint8_t>(size);
     }
 
-    auto GameLog::Entry() -> LogEntry { return LogEntry(this); }
+    auto GameLog::Log(const std::string_view& text) -> bool { return Entry().Text(text).Log(); }
+
+    auto GameLog::Enqueue(const LogLine& line) -> bool {
+        auto pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        QueuedLine* slot = nullptr;
+        while (true) {
+            slot = &m_queue[pos & QUEUE_MASK];
+            auto sequence = slot->sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (lag == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                // The UI thread hasn't taken the line that was here a lap ago.
+                return false;
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->line.Assign(line);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    auto GameLog::Drain() -> size_t {
+        size_t drained = 0;
+        while (true) {
+            auto& slot = m_queue[m_dequeue_pos & QUEUE_MASK];
+            if (slot.sequence.load(std::memory_order_acquire) != m_dequeue_pos + 1) { break; }
+
+            // Trade buffers with the ring slot being overwritten, so neither side loses capacity.
+            slot.line.Swap(m_lines[m_head]);
+            slot.sequence.store(m_dequeue_pos + LOG_QUEUE_CAPACITY, std::memory_order_release);
+            ++m_dequeue_pos;
+
+            m_head = (m_head + 1) % m_lines.size();
+            m_size = std::min(m_size + 1, m_lines.size());
+            ++m_logged;
+            ++drained;
+        }
+        return drained;
+    }
+
+    void GameLog::Clear() {
+        Drain();
+        m_head = 0;
+        m_size = 0;
+    }
+
+    auto GameLog::Entry() -> LogEntry {
+        t_staging.Clear();
+        return LogEntry(this, ++t_serial);
+    }
 } // namespace rglike
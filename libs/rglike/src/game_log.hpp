@@ -6,56 +6,98 @@
 
 #pragma once
 
+#include "constants.hpp"
 #include "ftxui/screen/color.hpp"
-#include <deque>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <utility>
+#include <string_view>
 #include <vector>
 
 namespace rglike {
-    struct GameLogFragment {
-        ftxui::Color color;
-        ftxui::Color bg_color;
-        bool bold;
-        bool dim;
-        bool underlined;
-        bool blinking;
-        std::string text;
-
-        GameLogFragment(
-            ftxui::Color color, ftxui::Color bg_color, bool bold, bool dim, bool underlined,
-            bool blinking, const std::string_view& text
-        )
-            : color(color)
-            , bg_color(bg_color)
-            , bold(bold)
-            , dim(dim)
-            , underlined(underlined)
-            , blinking(blinking)
-            , text(text) { }
+    /// @brief How a run of log text is drawn. Colors are indices into the log's palette.
+    struct LogStyle {
+        static constexpr uint8_t BOLD = 1 << 0;
+        static constexpr uint8_t DIM = 1 << 1;
+        static constexpr uint8_t UNDERLINED = 1 << 2;
+        static constexpr uint8_t BLINKING = 1 << 3;
+
+        uint8_t color = 0;
+        uint8_t bg_color = 0;
+        uint8_t flags = 0;
+
+        [[nodiscard]] inline auto Has(uint8_t flag) const -> bool { return (flags & flag) != 0; }
+
+        inline void Set(uint8_t flag, bool on) {
+            flags = on ? static_cast<uint8_t>(flags | flag) : static_cast<uint8_t>(flags & ~flag);
+        }
     };
 
-    class GameLog;
+    /// @brief A run of text in one style, stored as a range of its line's text.
+    struct GameLogFragment {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        LogStyle style;
+    };
 
-    class LogEntry {
+    /// @brief One line of the log. Its text and fragments are kept when the line is recycled, so
+    /// a full log can take new lines without allocating.
+    class LogLine {
     private:
-        ftxui::Color m_current_color = ftxui::Color::Default;
-        ftxui::Color m_current_bg_color = ftxui::Color::Default;
-        bool m_current_bold = false;
-        bool m_current_dim = false;
-        bool m_current_underlined = false;
-        bool m_current_blinking = false;
-
+        std::string m_text;
         std::vector<GameLogFragment> m_fragments;
-        GameLog* m_log;
 
-        explicit LogEntry(GameLog* log)
-            : m_log(log) { }
+        void Clear() {
+            m_text.clear();
+            m_fragments.clear();
+        }
+
+        void Append(std::string_view text, LogStyle style);
+
+        /// @brief Copies `other` into the buffers this line already has.
+        void Assign(const LogLine& other) {
+            m_text.assign(other.m_text);
+            m_fragments.assign(other.m_fragments.begin(), other.m_fragments.end());
+        }
+
+        void Swap(LogLine& other) {
+            m_text.swap(other.m_text);
+            m_fragments.swap(other.m_fragments);
+        }
 
-        [[nodiscard]] inline auto Fragments() const -> std::vector<GameLogFragment> {
+        friend class GameLog;
+        friend class LogEntry;
+
+    public:
+        [[nodiscard]] inline auto Fragments() const -> const std::vector<GameLogFragment>& {
             return m_fragments;
         }
 
+        [[nodiscard]] inline auto Text(const GameLogFragment& fragment) const -> std::string_view {
+            return std::string_view(m_text).substr(fragment.offset, fragment.length);
+        }
+
+        /// @brief The whole line without styling.
+        [[nodiscard]] inline auto Text() const -> std::string_view { return m_text; }
+    };
+
+    class GameLog;
+
+    /// @brief Builds a line in a buffer belonging to the calling thread. Each thread can only build
+    /// one entry at a time; starting another discards whatever the first had written.
+    class LogEntry {
+    private:
+        LogStyle m_style;
+        uint64_t m_serial;
+        GameLog* m_log;
+
+        LogEntry(GameLog* log, uint64_t serial)
+            : m_serial(serial)
+            , m_log(log) { }
+
     public:
         [[nodiscard]] auto Color(ftxui::Color color) -> LogEntry&;
         [[nodiscard]] auto BgColor(ftxui::Color color) -> LogEntry&;
@@ -64,19 +106,51 @@ namespace rglike {
         [[nodiscard]] auto Underline(bool underline) -> LogEntry&;
         [[nodiscard]] auto Blink(bool blink) -> LogEntry&;
         [[nodiscard]] auto Text(const std::string_view& text) -> LogEntry&;
-        void Log() const;
+        /// @brief Queues the line for the log.
+        /// @return False if the queue was full; the entry is left as it was, to be retried.
+        auto Log() const -> bool;
 
         friend class GameLog;
     };
 
+    /// @brief The last MAX_LOG_LINES lines logged, in a ring buffer of recycled lines.
+    ///
+    /// Any thread can log. Finished entries go into a bounded lock-free queue, and the UI thread
+    /// moves them into the ring with Drain(), once per frame. Entries from one thread keep the
+    /// order they were logged in. Everything that reads lines, and Drain() and Clear(), belongs to
+    /// the UI thread.
     class GameLog {
     private:
-        GameLog() = default;
+        /// @brief A slot in the queue. `sequence` says whose turn it is: the producer that claimed
+        /// position `p` may write once it equals `p`, and the UI thread may take it once it equals
+        /// `p + 1`.
+        struct QueuedLine {
+            std::atomic<size_t> sequence{0};
+            LogLine line;
+        };
+
+        GameLog();
         ~GameLog() = default;
 
-        std::deque<std::vector<GameLogFragment>> m_log;
+        /// @brief Every line slot; the one at m_head is where the next line goes.
+        std::vector<LogLine> m_lines;
+        size_t m_head = 0;
+        size_t m_size = 0;
+        /// @brief Lines drained since startup, never reset.
+        uint64_t m_logged = 0;
+
+        std::unique_ptr<QueuedLine[]> m_queue;
+        alignas(64) std::atomic<size_t> m_enqueue_pos{0};
+        alignas(64) size_t m_dequeue_pos = 0;
+
+        /// @brief Colors used so far. Index 0 is always the default color. Looking one up only
+        /// reads the first m_palette_size entries; adding one takes m_palette_mutex.
+        std::array<ftxui::Color, MAX_LOG_COLORS> m_palette{};
+        std::atomic<size_t> m_palette_size{1};
+        std::mutex m_palette_mutex;
 
-        void Log(const LogEntry& entry);
+        [[nodiscard]] auto PaletteIndex(ftxui::Color color) -> uint8_t;
+        auto Enqueue(const LogLine& line) -> bool;
 
     public:
         static auto GetInstance() -> GameLog&;
@@ -86,16 +160,36 @@ namespace rglike {
         GameLog(GameLog&&) = delete;
         auto operator=(GameLog&&) -> GameLog& = delete;
 
+        /// @brief Starts building a line on the calling thread.
         auto Entry() -> LogEntry;
-        void Log(const std::string_view& text);
+        auto Log(const std::string_view& text) -> bool;
+
+        /// @brief Moves every queued line into the log.
+        /// @return How many lines were moved; they are now the newest, at indices below it.
+        auto Drain() -> size_t;
+
+        /// @brief Forgets every line, including any still queued.
+        void Clear();
 
-        [[nodiscard]] inline auto Size() const -> size_t { return m_log.size(); }
+        [[nodiscard]] inline auto Size() const -> size_t { return m_size; }
+
+        [[nodiscard]] inline auto Capacity() const -> size_t { return m_lines.size(); }
+
+        /// @brief The `index`th most recent line; 0 is the newest.
+        [[nodiscard]] inline auto Line(size_t index) const -> const LogLine& {
+            return m_lines[(m_head + m_lines.size() - 1 - index) % m_lines.size()];
+        }
+
+        /// @brief A number identifying the `index`th most recent line for as long as it is kept,
+        /// and never reused; for caching things derived from a line.
+        [[nodiscard]] inline auto LineId(size_t index) const -> uint64_t {
+            return m_logged - 1 - index;
+        }
 
-        [[nodiscard]] inline auto Entries() const
-            -> const std::deque<std::vector<GameLogFragment>>& {
-            return m_log;
+        [[nodiscard]] inline auto Color(uint8_t index) const -> ftxui::Color {
+            return m_palette[index];
         }
 
         friend class LogEntry;
     };
-} // namespace rglike
\ No newline at end of file
+} // namespace rglike
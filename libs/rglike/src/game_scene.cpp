@@ -19,7 +19,12 @@
 #include <ftxui/dom/elements.hpp>
 
 namespace rglike {
-    void GameScene::Initialize() { m_world.Initialize(); }
+    void GameScene::Initialize() {
+        m_world.Initialize(Owner()->Seed());
+        if (!Owner()->RecordPath().empty()) {
+            m_recorder.Start(Owner()->RecordPath(), Owner()->Seed());
+        }
+    }
 
     void GameScene::Render() {
         int left_size = LEFT_SIDEBAR_WIDTH;
@@ -47,7 +52,7 @@ namespace rglike {
             return ftxui::text("right") | ftxui::center;
         });
 
-        auto world = ui::WorldViewer(m_world);
+        auto world = ui::WorldViewer(m_world, &m_recorder);
 
         auto container = world;
         container = ftxui::ResizableSplitLeft(left, container, &left_size);
@@ -78,5 +83,6 @@ namespace rglike {
             return false;
         });
         screen.Loop(component);
+        m_recorder.Finish(m_world.StateHash());
     }
 } // namespace rglike
\ No newline at end of file
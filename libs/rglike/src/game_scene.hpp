@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "replay.hpp"
 #include "rglike/rglike.hpp"
 #include "world.hpp"
 
@@ -13,6 +14,7 @@ namespace rglike {
     class GameScene : public Scene {
     private:
         World m_world;
+        ReplayRecorder m_recorder;
 
     public:
         explicit GameScene(Game* game)
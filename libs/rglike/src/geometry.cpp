@@ -0,0 +1,481 @@
+/**
+ * @file geometry.cpp
+ * @author Alic Szecsei
+ * @date 7/14/2023
+ */
+
+#include "geometry.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RGLIKE_GEOMETRY_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only let a function use instructions beyond the compiler's baseline if it asks
+// for them. That keeps the AVX2 code confined to functions that are only called once the CPU has
+// been checked.
+#if defined(RGLIKE_GEOMETRY_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RGLIKE_TARGET_SSE2 __attribute__((target("sse2")))
+#define RGLIKE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RGLIKE_TARGET_SSE2
+#define RGLIKE_TARGET_AVX2
+#endif
+
+namespace rglike {
+    namespace {
+        constexpr double PI = 3.14159265358979323846;
+
+        auto DetectSimdLevel() -> SimdLevel {
+#if defined(RGLIKE_GEOMETRY_X86) && defined(_MSC_VER)
+            std::array<int, 4> info{};
+            __cpuid(info.data(), 0);
+            auto max_leaf = info[0];
+            __cpuid(info.data(), 1);
+            bool sse2 = (info[3] & (1 << 26)) != 0;
+            bool os_saves_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+            if (max_leaf >= 7 && os_saves_avx && (_xgetbv(0) & 6) == 6) {
+                __cpuidex(info.data(), 7, 0);
+                if ((info[1] & (1 << 5)) != 0) { return SimdLevel::Avx2; }
+            }
+            return sse2 ? SimdLevel::Sse2 : SimdLevel::Scalar;
+#elif defined(RGLIKE_GEOMETRY_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) { return SimdLevel::Avx2; }
+            if (__builtin_cpu_supports("sse2")) { return SimdLevel::Sse2; }
+            return SimdLevel::Scalar;
+#else
+            return SimdLevel::Scalar;
+#endif
+        }
+
+        /// @brief `requested`, or the best level the CPU has if it can't do that.
+        auto Usable(SimdLevel requested) -> SimdLevel {
+            return std::min(requested, BestSimdLevel());
+        }
+
+        /// @brief The inputs shared by every batched kernel.
+        struct Batch {
+            const int32_t* xs;
+            const int32_t* ys;
+            size_t count;
+        };
+
+        // Each kernel comes in up to three flavours. The vector ones handle as many whole
+        // registers as they can and return where they stopped; the scalar one finishes off.
+
+        namespace scalar {
+            void Chebyshev(const Batch& batch, size_t begin, Vec2 from, int32_t* out) {
+                for (auto i = begin; i < batch.count; ++i) {
+                    out[i] = std::max(
+                        std::abs(batch.xs[i] - from.X()), std::abs(batch.ys[i] - from.Y())
+                    );
+                }
+            }
+
+            void Manhattan(const Batch& batch, size_t begin, Vec2 from, int32_t* out) {
+                for (auto i = begin; i < batch.count; ++i) {
+                    out[i] = std::abs(batch.xs[i] - from.X()) + std::abs(batch.ys[i] - from.Y());
+                }
+            }
+
+            auto SelectInRect(
+                const Batch& batch, size_t begin, const Rect& bounds, uint32_t* out, size_t found
+            ) -> size_t {
+                for (auto i = begin; i < batch.count; ++i) {
+                    if (bounds.Contains(Vec2{batch.xs[i], batch.ys[i]})) {
+                        out[found++] = static_cast<uint32_t>(i);
+                    }
+                }
+                return found;
+            }
+
+            void Pack(const Batch& batch, size_t begin, uint64_t* out) {
+                for (auto i = begin; i < batch.count; ++i) {
+                    out[i] = PackVec2(Vec2{batch.xs[i], batch.ys[i]});
+                }
+            }
+        } // namespace scalar
+
+#ifdef RGLIKE_GEOMETRY_X86
+        namespace sse2 {
+            constexpr size_t WIDTH = 4;
+
+            /// @brief SSE2 has no absolute value instruction for integers.
+            RGLIKE_TARGET_SSE2 inline auto Abs(__m128i value) -> __m128i {
+                auto sign = _mm_srai_epi32(value, 31);
+                return _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+            }
+
+            /// @brief ...nor a maximum.
+            RGLIKE_TARGET_SSE2 inline auto Max(__m128i a, __m128i b) -> __m128i {
+                auto greater = _mm_cmpgt_epi32(a, b);
+                return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+            }
+
+            RGLIKE_TARGET_SSE2 inline auto Load(const int32_t* data) -> __m128i {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            }
+
+            RGLIKE_TARGET_SSE2 auto Chebyshev(const Batch& batch, Vec2 from, int32_t* out)
+                -> size_t {
+                auto from_x = _mm_set1_epi32(from.X());
+                auto from_y = _mm_set1_epi32(from.Y());
+                size_t i = 0;
+                for (; i + WIDTH <= batch.count; i += WIDTH) {
+                    auto dx = Abs(_mm_sub_epi32(Load(batch.xs + i), from_x));
+                    auto dy = Abs(_mm_sub_epi32(Load(batch.ys + i), from_y));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), Max(dx, dy));
+                }
+                return i;
+            }
+
+            RGLIKE_TARGET_SSE2 auto Manhattan(const Batch& batch, Vec2 from, int32_t* out)
+                -> size_t {
+                auto from_x = _mm_set1_epi32(from.X());
+                auto from_y = _mm_set1_epi32(from.Y());
+                size_t i = 0;
+                for (; i + WIDTH <= batch.count; i += WIDTH) {
+                    auto dx = Abs(_mm_sub_epi32(Load(batch.xs + i), from_x));
+                    auto dy = Abs(_mm_sub_epi32(Load(batch.ys + i), from_y));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi32(dx, dy));
+                }
+                return i;
+            }
+
+            RGLIKE_TARGET_SSE2 auto
+            SelectInRect(const Batch& batch, const Rect& bounds, uint32_t* out, size_t& found)
+                -> size_t {
+                auto min_x = _mm_set1_epi32(bounds.min.X());
+                auto min_y = _mm_set1_epi32(bounds.min.Y());
+                auto max_x = _mm_set1_epi32(bounds.max.X());
+                auto max_y = _mm_set1_epi32(bounds.max.Y());
+                size_t i = 0;
+                for (; i + WIDTH <= batch.count; i += WIDTH) {
+                    auto x = Load(batch.xs + i);
+                    auto y = Load(batch.ys + i);
+                    auto inside = _mm_and_si128(
+                        _mm_andnot_si128(_mm_cmplt_epi32(x, min_x), _mm_cmplt_epi32(x, max_x)),
+                        _mm_andnot_si128(_mm_cmplt_epi32(y, min_y), _mm_cmplt_epi32(y, max_y))
+                    );
+                    auto mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+                    for (size_t lane = 0; mask != 0; ++lane, mask >>= 1) {
+                        if ((mask & 1) != 0) { out[found++] = static_cast<uint32_t>(i + lane); }
+                    }
+                }
+                return i;
+            }
+
+            RGLIKE_TARGET_SSE2 auto Pack(const Batch& batch, uint64_t* out) -> size_t {
+                size_t i = 0;
+                for (; i + WIDTH <= batch.count; i += WIDTH) {
+                    // Interleaving y with x puts each x in the high half of its 64-bit lane.
+                    auto x = Load(batch.xs + i);
+                    auto y = Load(batch.ys + i);
+                    auto* dest = reinterpret_cast<__m128i*>(out + i);
+                    _mm_storeu_si128(dest, _mm_unpacklo_epi32(y, x));
+                    _mm_storeu_si128(dest + 1, _mm_unpackhi_epi32(y, x));
+                }
+                return i;
+            }
+        } // namespace sse2
+
+        namespace avx2 {
+            constexpr size_t WIDTH = 8;
+
+            RGLIKE_TARGET_AVX2 inline auto Load(const int32_t* data) -> __m256i {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            }
+
+            RGLIKE_TARGET_AVX2 auto Chebyshev(const Batch& batch, Vec2 from, int32_t* out)
+                -> size_t {
+                auto from_x = _mm256_set1_epi32(from.X());
+                auto from_y = _mm256_set1_epi32(from.Y());
+                size_t i = 0;
+                for (; i + WIDTH <= batch.count; i += WIDTH) {
+                    auto dx = _mm256_abs_epi32(_mm256_sub_epi32(Load(batch.xs + i), from_x));
+                    auto dy = _mm256_abs_epi32(_mm256_sub_epi32(Load(batch.ys + i), from_y));
+                    _mm256_storeu_si256(
+                        reinterpret_cast<__m256i*>(out + i), _mm256_max_epi32(dx, dy)
+                    );
+                }
+                return i;
+            }
+
+            RGLIKE_TARGET_AVX2 auto Manhattan(const Batch& batch, Vec2 from, int32_t* out)
+                -> size_t {
+                auto from_x = _mm256_set1_epi32(from.X());
+                auto from_y = _mm256_set1_epi32(from.Y());
+                size_t i = 0;
+                for (; i + WIDTH <= batch.count; i += WIDTH) {
+                    auto dx = _mm256_abs_epi32(_mm256_sub_epi32(Load(batch.xs + i), from_x));
+                    auto dy = _mm256_abs_epi32(_mm256_sub_epi32(Load(batch.ys + i), from_y));
+                    _mm256_storeu_si256(
+                        reinterpret_cast<__m256i*>(out + i), _mm256_add_epi32(dx, dy)
+                    );
+                }
+                return i;
+            }
+
+            RGLIKE_TARGET_AVX2 auto
+            SelectInRect(const Batch& batch, const Rect& bounds, uint32_t* out, size_t& found)
+                -> size_t {
+                // AVX2 only compares for greater-than, so `min <= x < max` is written as
+                // `!(min > x) && max > x`.
+                auto min_x = _mm256_set1_epi32(bounds.min.X());
+                auto min_y = _mm256_set1_epi32(bounds.min.Y());
+                auto max_x = _mm256_set1_epi32(bounds.max.X());
+                auto max_y = _mm256_set1_epi32(bounds.max.Y());
+                size_t i = 0;
+                for (; i + WIDTH <= batch.count; i += WIDTH) {
+                    auto x = Load(batch.xs + i);
+                    auto y = Load(batch.ys + i);
+                    auto inside_x = _mm256_andnot_si256(
+                        _mm256_cmpgt_epi32(min_x, x), _mm256_cmpgt_epi32(max_x, x)
+                    );
+                    auto inside_y = _mm256_andnot_si256(
+                        _mm256_cmpgt_epi32(min_y, y), _mm256_cmpgt_epi32(max_y, y)
+                    );
+                    auto inside = _mm256_and_si256(inside_x, inside_y);
+                    auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(inside));
+                    for (size_t lane = 0; mask != 0; ++lane, mask >>= 1) {
+                        if ((mask & 1) != 0) { out[found++] = static_cast<uint32_t>(i + lane); }
+                    }
+                }
+                return i;
+            }
+
+            RGLIKE_TARGET_AVX2 auto Pack(const Batch& batch, uint64_t* out) -> size_t {
+                size_t i = 0;
+                for (; i + WIDTH <= batch.count; i += WIDTH) {
+                    // Unpacking works within each 128-bit half, so the halves need putting back
+                    // in order afterwards.
+                    auto x = Load(batch.xs + i);
+                    auto y = Load(batch.ys + i);
+                    auto low = _mm256_unpacklo_epi32(y, x);
+                    auto high = _mm256_unpackhi_epi32(y, x);
+                    auto* dest = reinterpret_cast<__m256i*>(out + i);
+                    _mm256_storeu_si256(dest, _mm256_permute2x128_si256(low, high, 0x20));
+                    _mm256_storeu_si256(dest + 1, _mm256_permute2x128_si256(low, high, 0x31));
+                }
+                return i;
+            }
+        } // namespace avx2
+#endif
+
+        auto MakeBatch(const PositionBuffer& positions) -> Batch {
+            return Batch{positions.xs.data(), positions.ys.data(), positions.Size()};
+        }
+
+        /// @brief Half the width of the circle's row `dy` tiles from its center.
+        auto CircleHalfWidth(int radius, int dy) -> int {
+            auto limit = static_cast<int64_t>(radius) * radius + radius -
+                         static_cast<int64_t>(dy) * dy;
+            if (limit < 0) { return -1; }
+            auto half = static_cast<int64_t>(std::sqrt(static_cast<double>(limit)));
+            while (half * half > limit) { --half; }
+            while ((half + 1) * (half + 1) <= limit) { ++half; }
+            return static_cast<int>(half);
+        }
+    } // namespace
+
+    auto BestSimdLevel() -> SimdLevel {
+        static const SimdLevel level = DetectSimdLevel();
+        return level;
+    }
+
+    auto SimdLevelName(SimdLevel level) -> const char* {
+        switch (level) {
+        case SimdLevel::Scalar:
+            return "scalar";
+        case SimdLevel::Sse2:
+            return "sse2";
+        case SimdLevel::Avx2:
+            return "avx2";
+        }
+        return "unknown";
+    }
+
+    void TraceLine(const Vec2& from, const Vec2& to, LineKind kind, PositionBuffer& out) {
+        auto x = from.X();
+        auto y = from.Y();
+        auto step_x = to.X() > x ? 1 : -1;
+        auto step_y = to.Y() > y ? 1 : -1;
+        auto dx = static_cast<int64_t>(std::abs(to.X() - x));
+        auto dy = static_cast<int64_t>(std::abs(to.Y() - y));
+        out.Push(from);
+
+        if (kind == LineKind::Bresenham) {
+            auto error = dx - dy;
+            while (x != to.X() || y != to.Y()) {
+                auto doubled = error * 2;
+                if (doubled > -dy) {
+                    error -= dy;
+                    x += step_x;
+                }
+                if (doubled < dx) {
+                    error += dx;
+                    y += step_y;
+                }
+                out.Push(Vec2{x, y});
+            }
+            return;
+        }
+
+        // Supercover: step along whichever axis the segment crosses into next, comparing where
+        // it leaves the current tile horizontally and vertically.
+        for (int64_t ix = 0, iy = 0; ix < dx || iy < dy;) {
+            auto decision = (1 + 2 * ix) * dy - (1 + 2 * iy) * dx;
+            if (decision == 0) {
+                // Straight through a corner, touching both tiles beside it.
+                out.Push(Vec2{x + step_x, y});
+                out.Push(Vec2{x, y + step_y});
+                x += step_x;
+                y += step_y;
+                ++ix;
+                ++iy;
+            } else if (decision < 0) {
+                x += step_x;
+                ++ix;
+            } else {
+                y += step_y;
+                ++iy;
+            }
+            out.Push(Vec2{x, y});
+        }
+    }
+
+    void TraceLines(
+        const std::vector<Vec2>& from, const std::vector<Vec2>& to, LineKind kind,
+        PositionBuffer& out, std::vector<uint32_t>& offsets
+    ) {
+        auto count = std::min(from.size(), to.size());
+        offsets.clear();
+        offsets.reserve(count + 1);
+        for (size_t i = 0; i < count; ++i) {
+            offsets.push_back(static_cast<uint32_t>(out.Size()));
+            TraceLine(from[i], to[i], kind, out);
+        }
+        offsets.push_back(static_cast<uint32_t>(out.Size()));
+    }
+
+    void RasterizeCircle(const Vec2& center, int radius, PositionBuffer& out) {
+        for (int dy = -radius; dy <= radius; ++dy) {
+            auto half = CircleHalfWidth(radius, dy);
+            for (int dx = -half; dx <= half; ++dx) { out.Push(center + Vec2{dx, dy}); }
+        }
+    }
+
+    void RasterizeCone(
+        const Vec2& origin, const Vec2& toward, int radius, double half_angle, PositionBuffer& out
+    ) {
+        auto direction = toward - origin;
+        auto direction_length = direction.Length();
+        auto min_cos = std::cos(std::min(half_angle, 180.0) * PI / 180.0);
+
+        for (int dy = -radius; dy <= radius; ++dy) {
+            auto half = CircleHalfWidth(radius, dy);
+            for (int dx = -half; dx <= half; ++dx) {
+                if (dx == 0 && dy == 0) { continue; }
+                Vec2 offset{dx, dy};
+                auto dot = static_cast<double>(dx * direction.X() + dy * direction.Y());
+                if (direction_length > 0.0 && dot < min_cos * offset.Length() * direction_length) {
+                    continue;
+                }
+                out.Push(origin + offset);
+            }
+        }
+    }
+
+    void ChebyshevDistances(
+        const PositionBuffer& positions, const Vec2& from, int32_t* out, SimdLevel level
+    ) {
+        auto batch = MakeBatch(positions);
+        size_t done = 0;
+        switch (Usable(level)) {
+#ifdef RGLIKE_GEOMETRY_X86
+        case SimdLevel::Avx2:
+            done = avx2::Chebyshev(batch, from, out);
+            break;
+        case SimdLevel::Sse2:
+            done = sse2::Chebyshev(batch, from, out);
+            break;
+#endif
+        default:
+            break;
+        }
+        scalar::Chebyshev(batch, done, from, out);
+    }
+
+    void ManhattanDistances(
+        const PositionBuffer& positions, const Vec2& from, int32_t* out, SimdLevel level
+    ) {
+        auto batch = MakeBatch(positions);
+        size_t done = 0;
+        switch (Usable(level)) {
+#ifdef RGLIKE_GEOMETRY_X86
+        case SimdLevel::Avx2:
+            done = avx2::Manhattan(batch, from, out);
+            break;
+        case SimdLevel::Sse2:
+            done = sse2::Manhattan(batch, from, out);
+            break;
+#endif
+        default:
+            break;
+        }
+        scalar::Manhattan(batch, done, from, out);
+    }
+
+    void SelectInRect(
+        const PositionBuffer& positions, const Rect& bounds, std::vector<uint32_t>& indices,
+        SimdLevel level
+    ) {
+        auto batch = MakeBatch(positions);
+        indices.resize(batch.count);
+        size_t found = 0;
+        size_t done = 0;
+        if (!bounds.Empty()) {
+            switch (Usable(level)) {
+#ifdef RGLIKE_GEOMETRY_X86
+            case SimdLevel::Avx2:
+                done = avx2::SelectInRect(batch, bounds, indices.data(), found);
+                break;
+            case SimdLevel::Sse2:
+                done = sse2::SelectInRect(batch, bounds, indices.data(), found);
+                break;
+#endif
+            default:
+                break;
+            }
+            found = scalar::SelectInRect(batch, done, bounds, indices.data(), found);
+        }
+        indices.resize(found);
+    }
+
+    void PackPositions(const PositionBuffer& positions, uint64_t* out, SimdLevel level) {
+        auto batch = MakeBatch(positions);
+        size_t done = 0;
+        switch (Usable(level)) {
+#ifdef RGLIKE_GEOMETRY_X86
+        case SimdLevel::Avx2:
+            done = avx2::Pack(batch, out);
+            break;
+        case SimdLevel::Sse2:
+            done = sse2::Pack(batch, out);
+            break;
+#endif
+        default:
+            break;
+        }
+        scalar::Pack(batch, done, out);
+    }
+} // namespace rglike
@@ -0,0 +1,100 @@
+/**
+ * @file geometry.hpp
+ * @author Alic Szecsei
+ * @date 7/14/2023
+ */
+
+#pragma once
+
+#include "math.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rglike {
+    /// @brief The instruction sets the batched kernels below can use.
+    enum class SimdLevel { Scalar, Sse2, Avx2 };
+
+    /// @brief The best level this CPU supports, detected once on first use.
+    auto BestSimdLevel() -> SimdLevel;
+
+    auto SimdLevelName(SimdLevel level) -> const char*;
+
+    /// @brief Positions stored as separate x and y arrays, so kernels can work on many at once.
+    struct PositionBuffer {
+        std::vector<int32_t> xs;
+        std::vector<int32_t> ys;
+
+        [[nodiscard]] inline auto Size() const -> size_t { return xs.size(); }
+
+        [[nodiscard]] inline auto At(size_t i) const -> Vec2 { return Vec2{xs[i], ys[i]}; }
+
+        inline void Push(const Vec2& pos) {
+            xs.push_back(pos.X());
+            ys.push_back(pos.Y());
+        }
+
+        inline void Reserve(size_t count) {
+            xs.reserve(count);
+            ys.reserve(count);
+        }
+
+        inline void Clear() {
+            xs.clear();
+            ys.clear();
+        }
+    };
+
+    /// @brief Which tiles count as being on a line.
+    enum class LineKind {
+        /// @brief One tile per step along the major axis.
+        Bresenham,
+        /// @brief Every tile the segment passes through, including both at a diagonal corner.
+        Supercover,
+    };
+
+    /// @brief Appends the tiles from `from` to `to`, both included, to `out`.
+    void TraceLine(const Vec2& from, const Vec2& to, LineKind kind, PositionBuffer& out);
+
+    /// @brief Traces every segment `from[i]` to `to[i]` into `out`, one after another. Segment `i`
+    /// occupies [`offsets[i]`, `offsets[i + 1]`).
+    void TraceLines(
+        const std::vector<Vec2>& from, const std::vector<Vec2>& to, LineKind kind,
+        PositionBuffer& out, std::vector<uint32_t>& offsets
+    );
+
+    /// @brief Appends every tile within `radius` of `center`, row by row. Tiles up to half a
+    /// tile beyond the radius count, which gives rounder small circles.
+    void RasterizeCircle(const Vec2& center, int radius, PositionBuffer& out);
+
+    /// @brief Appends every tile within `radius` of `origin` and within `half_angle` degrees of
+    /// the direction towards `toward`. The origin itself is not included.
+    void RasterizeCone(
+        const Vec2& origin, const Vec2& toward, int radius, double half_angle, PositionBuffer& out
+    );
+
+    /// @brief Writes the Chebyshev (king's move) distance from `from` to every position in
+    /// `positions` to `out`, which must have room for them all.
+    void ChebyshevDistances(
+        const PositionBuffer& positions, const Vec2& from, int32_t* out,
+        SimdLevel level = BestSimdLevel()
+    );
+
+    /// @brief Writes the Manhattan distance from `from` to every position to `out`.
+    void ManhattanDistances(
+        const PositionBuffer& positions, const Vec2& from, int32_t* out,
+        SimdLevel level = BestSimdLevel()
+    );
+
+    /// @brief Replaces `indices` with the indices of the positions inside `bounds`, in order.
+    void SelectInRect(
+        const PositionBuffer& positions, const Rect& bounds, std::vector<uint32_t>& indices,
+        SimdLevel level = BestSimdLevel()
+    );
+
+    /// @brief Writes PackVec2 of every position to `out`.
+    void PackPositions(
+        const PositionBuffer& positions, uint64_t* out, SimdLevel level = BestSimdLevel()
+    );
+} // namespace rglike
@@ -0,0 +1,27 @@
+/**
+ * @file input.cpp
+ * @author Alic Szecsei
+ * @date 7/17/2023
+ */
+
+#include "input.hpp"
+
+namespace rglike {
+    auto ApplyInput(World& world, const ftxui::Event& event) -> bool {
+        auto direction = Vec2::Zero();
+        if (event == ftxui::Event::ArrowUp) {
+            direction = Vec2::Up();
+        } else if (event == ftxui::Event::ArrowRight) {
+            direction = Vec2::Right();
+        } else if (event == ftxui::Event::ArrowDown) {
+            direction = Vec2::Down();
+        } else if (event == ftxui::Event::ArrowLeft) {
+            direction = Vec2::Left();
+        } else {
+            return false;
+        }
+
+        if (world.MovePlayer(direction)) { world.Update(); }
+        return true;
+    }
+} // namespace rglike
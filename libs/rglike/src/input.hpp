@@ -0,0 +1,20 @@
+/**
+ * @file input.hpp
+ * @author Alic Szecsei
+ * @date 7/17/2023
+ */
+
+#pragma once
+
+#include "world.hpp"
+
+#include <ftxui/component/event.hpp>
+
+namespace rglike {
+    /// @brief Applies a gameplay input, such as a movement key, to `world`.
+    ///
+    /// This is the only way player input reaches the world, so recording the events it accepts
+    /// is enough to replay a session.
+    /// @return Whether `event` was a gameplay input.
+    auto ApplyInput(World& world, const ftxui::Event& event) -> bool;
+} // namespace rglike
@@ -0,0 +1,250 @@
+/**
+ * @file light_map.cpp
+ * @author Alic Szecsei
+ * @date 7/21/2023
+ */
+
+#include "light_map.hpp"
+
+#include "fov.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rglike {
+    auto LightMap::SlotFor(entt::entity entity) -> Cast& {
+        auto index = static_cast<size_t>(entt::to_entity(entity));
+        if (index >= m_casts.size()) { m_casts.resize(index + 1); }
+        return m_casts[index];
+    }
+
+    void LightMap::Apply(const Cast& cast, int sign) {
+        if (cast.tiles.empty()) { return; }
+
+        // A light never spans more than a few chunks, so they are looked up once per cast rather
+        // than once per tile.
+        const Vec2 first{cast.bounds.min.X() >> CHUNK_SHIFT, cast.bounds.min.Y() >> CHUNK_SHIFT};
+        const Vec2 last{
+            (cast.bounds.max.X() - 1) >> CHUNK_SHIFT, (cast.bounds.max.Y() - 1) >> CHUNK_SHIFT};
+        const int chunks_wide = last.X() - first.X() + 1;
+        m_chunk_cache.clear();
+        for (int cy = first.Y(); cy <= last.Y(); ++cy) {
+            for (int cx = first.X(); cx <= last.X(); ++cx) {
+                auto& slot = m_chunks[PackVec2(Vec2{cx, cy})];
+                if (slot == nullptr) { slot = std::make_unique<LightChunk>(); }
+                m_chunk_cache.push_back(slot.get());
+            }
+        }
+
+        const auto red = static_cast<uint32_t>(cast.source.red);
+        const auto green = static_cast<uint32_t>(cast.source.green);
+        const auto blue = static_cast<uint32_t>(cast.source.blue);
+        for (size_t i = 0; i < cast.tiles.size(); ++i) {
+            auto pos = cast.tiles[i];
+            auto* chunk = m_chunk_cache[((pos.Y() >> CHUNK_SHIFT) - first.Y()) * chunks_wide +
+                                        (pos.X() >> CHUNK_SHIFT) - first.X()];
+            auto& level =
+                chunk->levels[TileChunk::Index(pos.X() & CHUNK_MASK, pos.Y() & CHUNK_MASK)];
+            uint32_t strength = cast.strengths[i];
+            if (sign > 0) {
+                level.red += red * strength >> 8U;
+                level.green += green * strength >> 8U;
+                level.blue += blue * strength >> 8U;
+            } else {
+                level.red -= red * strength >> 8U;
+                level.green -= green * strength >> 8U;
+                level.blue -= blue * strength >> 8U;
+            }
+        }
+    }
+
+    void LightMap::Caster::Prepare(int radius) {
+        const auto side = 2 * radius + 1;
+        const auto area = static_cast<size_t>(side) * static_cast<size_t>(side);
+        if (stamps.size() < area) { stamps.assign(area, 0); }
+        if (++stamp == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            stamp = 1;
+        }
+
+        if (radius == falloff_radius) { return; }
+        falloff_radius = radius;
+        falloff.resize(area);
+        // Fades linearly with distance, reaching zero just past the radius.
+        const auto reach = static_cast<float>(radius + 1);
+        for (int dy = -radius; dy <= radius; ++dy) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                auto distance = std::sqrt(static_cast<float>(dx * dx + dy * dy));
+                auto strength = std::max(0.0F, 1.0F - distance / reach);
+                falloff[(dy + radius) * side + dx + radius] =
+                    static_cast<uint16_t>(strength * 256.0F);
+            }
+        }
+    }
+
+    void LightMap::Caster::Trace(const TileMap& map, Cast& cast) {
+        cast.tiles.clear();
+        cast.strengths.clear();
+
+        const auto origin = cast.origin;
+        const auto radius = cast.source.radius;
+        const auto side = 2 * radius + 1;
+        Prepare(radius);
+        ShadowCast(
+            origin, radius, [&](Vec2 pos) { return map.IsOpaque(pos); },
+            [&](Vec2 pos) {
+                auto local = pos - origin;
+                auto index = (local.Y() + radius) * side + local.X() + radius;
+                if (stamps[index] == stamp) { return; }
+                stamps[index] = stamp;
+
+                auto strength = falloff[index];
+                if (strength == 0) { return; }
+                cast.tiles.push_back(pos);
+                cast.strengths.push_back(strength);
+            }
+        );
+    }
+
+    void LightMap::Queue(entt::entity entity) {
+        auto& cast = SlotFor(entity);
+        if (cast.queued == entity) { return; }
+        cast.queued = entity;
+        m_queue.push_back(entity);
+    }
+
+    void LightMap::Connect(entt::registry& registry) {
+        registry.on_construct<LightSource>().connect<&LightMap::OnChange>(*this);
+        registry.on_update<LightSource>().connect<&LightMap::OnChange>(*this);
+        registry.on_destroy<LightSource>().connect<&LightMap::OnRemove>(*this);
+        registry.on_construct<Position>().connect<&LightMap::OnMove>(*this);
+        registry.on_update<Position>().connect<&LightMap::OnMove>(*this);
+        registry.on_destroy<Position>().connect<&LightMap::OnRemove>(*this);
+
+        for (auto entity : registry.view<Position, LightSource>()) { Queue(entity); }
+    }
+
+    void LightMap::Disconnect(entt::registry& registry) {
+        registry.on_construct<LightSource>().disconnect<&LightMap::OnChange>(*this);
+        registry.on_update<LightSource>().disconnect<&LightMap::OnChange>(*this);
+        registry.on_destroy<LightSource>().disconnect<&LightMap::OnRemove>(*this);
+        registry.on_construct<Position>().disconnect<&LightMap::OnMove>(*this);
+        registry.on_update<Position>().disconnect<&LightMap::OnMove>(*this);
+        registry.on_destroy<Position>().disconnect<&LightMap::OnRemove>(*this);
+        Clear();
+    }
+
+    void LightMap::Clear() {
+        m_chunks.clear();
+        m_casts.clear();
+        m_queue.clear();
+        m_invalid.clear();
+        m_lights = 0;
+        m_dirty = Rect{};
+        ++m_revision;
+    }
+
+    void LightMap::InvalidateArea(const Rect& area) { m_invalid.push_back(area); }
+
+    auto LightMap::Update(const TileMap& map, const entt::registry& registry, ThreadPool* pool)
+        -> size_t {
+        m_dirty = Rect{};
+
+        // An edit nobody described could have changed any tile; otherwise only lights reaching
+        // into the described areas can see a difference.
+        bool unexplained = map.Revision() != m_map_revision && m_invalid.empty();
+        m_map_revision = map.Revision();
+        if (map.ResidencyRevision() != m_residency_revision) {
+            unexplained =
+                !map.ResidencyChangesSince(m_residency_revision, m_invalid) || unexplained;
+            m_residency_revision = map.ResidencyRevision();
+        }
+        if (unexplained || !m_invalid.empty()) {
+            for (const auto& cast : m_casts) {
+                if (cast.entity == entt::null) { continue; }
+                bool affected = unexplained;
+                for (const auto& area : m_invalid) {
+                    affected = affected || !cast.bounds.Intersect(area).Empty();
+                }
+                if (affected) { Queue(cast.entity); }
+            }
+            m_invalid.clear();
+        }
+
+        // Take out the old light of everything queued and work out where the new light goes.
+        // A slot may have been queued for a destroyed entity and then for its replacement; only
+        // the latest counts, but the old light goes either way.
+        size_t recast = 0;
+        m_batch.clear();
+        for (auto entity : m_queue) {
+            auto& cast = SlotFor(entity);
+            if (cast.queued != entity) { continue; }
+            cast.queued = entt::null;
+            ++recast;
+
+            if (cast.entity != entt::null) {
+                Apply(cast, -1);
+                m_dirty = m_dirty.Union(cast.bounds);
+                cast.entity = entt::null;
+                cast.tiles.clear();
+                cast.strengths.clear();
+                --m_lights;
+            }
+
+            if (!registry.valid(entity)) { continue; }
+            const auto* position = registry.try_get<Position>(entity);
+            const auto* source = registry.try_get<LightSource>(entity);
+            if (position == nullptr || source == nullptr || source->radius <= 0) { continue; }
+            cast.entity = entity;
+            cast.source = *source;
+            cast.origin = position->pos;
+            cast.bounds = Rect::Around(position->pos, source->radius);
+            m_batch.push_back(static_cast<size_t>(entt::to_entity(entity)));
+        }
+        m_queue.clear();
+
+        // Shadowcasting only reads the map, so the lights can be traced side by side; adding
+        // them up is left to this thread.
+        auto trace = [&](size_t begin, size_t end, size_t worker) {
+            auto& caster = m_casters[worker];
+            for (size_t i = begin; i < end; ++i) { caster.Trace(map, m_casts[m_batch[i]]); }
+        };
+        if (pool == nullptr) {
+            trace(0, m_batch.size(), 0);
+        } else {
+            if (m_casters.size() < pool->WorkerCount()) { m_casters.resize(pool->WorkerCount()); }
+            constexpr size_t LIGHTS_PER_TASK = 8;
+            pool->ParallelFor(m_batch.size(), LIGHTS_PER_TASK, trace);
+        }
+
+        for (auto slot : m_batch) {
+            const auto& cast = m_casts[slot];
+            Apply(cast, 1);
+            m_dirty = m_dirty.Union(cast.bounds);
+            ++m_lights;
+        }
+
+        if (recast > 0) { ++m_revision; }
+        return recast;
+    }
+
+    auto LightMap::LightAt(Vec2 pos) const -> LightLevel {
+        auto it = m_chunks.find(PackVec2(Vec2{pos.X() >> CHUNK_SHIFT, pos.Y() >> CHUNK_SHIFT}));
+        if (it == m_chunks.end()) { return LightLevel{}; }
+        return it->second->levels[TileChunk::Index(pos.X() & CHUNK_MASK, pos.Y() & CHUNK_MASK)];
+    }
+
+    void LightMap::OnChange(entt::registry& registry, entt::entity entity) {
+        if (registry.all_of<Position>(entity)) { Queue(entity); }
+    }
+
+    void LightMap::OnMove(entt::registry& registry, entt::entity entity) {
+        if (registry.all_of<LightSource>(entity)) { Queue(entity); }
+    }
+
+    void LightMap::OnRemove(entt::registry&, entt::entity entity) {
+        // The light is taken out on the next update, once the entity is really gone.
+        auto index = static_cast<size_t>(entt::to_entity(entity));
+        if (index < m_casts.size() && m_casts[index].entity == entity) { Queue(entity); }
+    }
+} // namespace rglike
@@ -0,0 +1,137 @@
+/**
+ * @file light_map.hpp
+ * @author Alic Szecsei
+ * @date 7/21/2023
+ */
+
+#pragma once
+
+#include "components.hpp"
+#include "math.hpp"
+#include "thread_pool.hpp"
+#include "tile_map.hpp"
+
+#include "entt/entt.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rglike {
+    /// @brief The light reaching a tile from every source. A channel of 255 is one light of that
+    /// channel at full strength; overlapping lights add up past it.
+    struct LightLevel {
+        uint32_t red = 0;
+        uint32_t green = 0;
+        uint32_t blue = 0;
+    };
+
+    /// @brief Accumulates the light cast by every LightSource in a registry.
+    ///
+    /// Each light is shadowcast from its Position, and what it added to each tile is remembered
+    /// so that it can be subtracted again exactly. Update() only recasts the lights that
+    /// changed: ones that moved or were edited, and ones reaching into an area passed to
+    /// InvalidateArea(). The recast lights are shadowcast in parallel when given a pool; only
+    /// adding their light into the map is serial. Light is stored in CHUNK_SIZE square chunks
+    /// allocated as light first reaches them, so dark stretches of a large map cost nothing.
+    ///
+    /// Connect() hooks the map up to a registry's LightSource and Position signals, like
+    /// SpatialIndex, so positions must be changed with `registry.patch` or `registry.replace`.
+    class LightMap {
+    private:
+        struct LightChunk {
+            std::array<LightLevel, CHUNK_AREA> levels{};
+        };
+
+        /// @brief What one light last added to the map.
+        struct Cast {
+            /// @brief The light, or null if it has nothing in the map.
+            entt::entity entity = entt::null;
+            LightSource source{};
+            Vec2 origin{0, 0};
+            Rect bounds{};
+            std::vector<Vec2> tiles;
+            /// @brief How strongly each tile was lit, out of 256.
+            std::vector<uint16_t> strengths;
+            /// @brief The entity waiting to be recast into this slot, if any.
+            entt::entity queued = entt::null;
+        };
+
+        /// @brief Per-worker scratch space for shadowcasting.
+        struct Caster {
+            /// @brief Marks tiles already lit by the cast in progress, which ShadowCast may visit
+            /// twice.
+            std::vector<uint32_t> stamps;
+            uint32_t stamp = 0;
+            /// @brief Strength by offset from the light, for lights of `falloff_radius`.
+            std::vector<uint16_t> falloff;
+            int falloff_radius = -1;
+
+            /// @brief Readies the scratch space for a light of `radius`.
+            void Prepare(int radius);
+
+            /// @brief Fills in the tiles `cast` lights, replacing any it had.
+            void Trace(const TileMap& map, Cast& cast);
+        };
+
+        std::unordered_map<uint64_t, std::unique_ptr<LightChunk>, Vec2KeyHash> m_chunks;
+        /// @brief Indexed by entity.
+        std::vector<Cast> m_casts;
+        std::vector<entt::entity> m_queue;
+        std::vector<Rect> m_invalid;
+        /// @brief Slots in m_casts being recast by the current update.
+        std::vector<size_t> m_batch;
+        std::vector<Caster> m_casters = std::vector<Caster>(1);
+        /// @brief The chunks under the cast being applied.
+        std::vector<LightChunk*> m_chunk_cache;
+        size_t m_lights = 0;
+
+        uint64_t m_map_revision = 0;
+        uint64_t m_residency_revision = 0;
+        uint64_t m_revision = 0;
+        Rect m_dirty{};
+
+        [[nodiscard]] auto SlotFor(entt::entity entity) -> Cast&;
+
+        /// @brief Adds (`sign` = 1) or removes (`sign` = -1) `cast`'s light.
+        void Apply(const Cast& cast, int sign);
+
+        void Queue(entt::entity entity);
+
+        void OnChange(entt::registry& registry, entt::entity entity);
+        void OnMove(entt::registry& registry, entt::entity entity);
+        void OnRemove(entt::registry& registry, entt::entity entity);
+
+    public:
+        /// @brief Queues every existing light in `registry` and follows its changes.
+        void Connect(entt::registry& registry);
+        void Disconnect(entt::registry& registry);
+
+        /// @brief Drops all light.
+        void Clear();
+
+        /// @brief Marks the tiles in `area` as having changed, e.g. becoming opaque, so that
+        /// lights reaching into it are recast. Map edits that are not reported here cause every
+        /// light to be recast. Chunks paged in or out are picked up without being reported.
+        void InvalidateArea(const Rect& area);
+
+        /// @brief Recasts every light that changed since the last update, spreading the work
+        /// over `pool` if given.
+        /// @return How many lights were recast or removed.
+        auto Update(const TileMap& map, const entt::registry& registry, ThreadPool* pool = nullptr)
+            -> size_t;
+
+        [[nodiscard]] auto LightAt(Vec2 pos) const -> LightLevel;
+
+        /// @brief How many lights are in the map.
+        [[nodiscard]] inline auto Lights() const -> size_t { return m_lights; }
+
+        /// @brief Bumped by every update that changed any light.
+        [[nodiscard]] inline auto Revision() const -> uint64_t { return m_revision; }
+
+        /// @brief The area in which light may have changed during the last update.
+        [[nodiscard]] inline auto DirtyBounds() const -> const Rect& { return m_dirty; }
+    };
+} // namespace rglike
@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <fmt/format.h>
 
 namespace rglike {
@@ -101,6 +104,72 @@ namespace rglike {
     }
 
     constexpr auto operator!=(const Vec2& lhs, const Vec2& rhs) -> bool { return !(lhs == rhs); }
+
+    /// @brief Packs a Vec2 into a single 64-bit key, x in the high half and y in the low half.
+    constexpr auto PackVec2(const Vec2& vec) -> uint64_t {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(vec.X())) << 32) |
+               static_cast<uint64_t>(static_cast<uint32_t>(vec.Y()));
+    }
+
+    constexpr auto UnpackVec2(uint64_t key) -> Vec2 {
+        return Vec2{
+            static_cast<int>(static_cast<uint32_t>(key >> 32)),
+            static_cast<int>(static_cast<uint32_t>(key)),
+        };
+    }
+
+    /// @brief Spreads a PackVec2 key over all 64 bits. Neighbouring tiles' keys differ only in
+    /// their low bits, which identity hashes and power-of-two tables handle badly.
+    constexpr auto HashVec2Key(uint64_t key) -> uint64_t {
+        key *= 0x9E3779B97F4A7C15;
+        return key ^ (key >> 32);
+    }
+
+    /// @brief Hashes PackVec2 keys for unordered containers.
+    struct Vec2KeyHash {
+        constexpr auto operator()(uint64_t key) const -> size_t {
+            return static_cast<size_t>(HashVec2Key(key));
+        }
+    };
+
+    /// @brief An axis-aligned rectangle of tiles, including `min` and excluding `max`.
+    struct Rect {
+        Vec2 min{0, 0};
+        Vec2 max{0, 0};
+
+        [[nodiscard]] constexpr auto Width() const -> int { return max.X() - min.X(); }
+
+        [[nodiscard]] constexpr auto Height() const -> int { return max.Y() - min.Y(); }
+
+        [[nodiscard]] constexpr auto Empty() const -> bool { return Width() <= 0 || Height() <= 0; }
+
+        [[nodiscard]] constexpr auto Contains(const Vec2& pos) const -> bool {
+            return pos.X() >= min.X() && pos.X() < max.X() && pos.Y() >= min.Y() &&
+                   pos.Y() < max.Y();
+        }
+
+        /// @brief The smallest rectangle containing both rectangles. Empty rectangles are ignored.
+        [[nodiscard]] constexpr auto Union(const Rect& other) const -> Rect {
+            if (Empty()) { return other; }
+            if (other.Empty()) { return *this; }
+            return Rect{
+                Vec2{std::min(min.X(), other.min.X()), std::min(min.Y(), other.min.Y())},
+                Vec2{std::max(max.X(), other.max.X()), std::max(max.Y(), other.max.Y())},
+            };
+        }
+
+        [[nodiscard]] constexpr auto Intersect(const Rect& other) const -> Rect {
+            return Rect{
+                Vec2{std::max(min.X(), other.min.X()), std::max(min.Y(), other.min.Y())},
+                Vec2{std::min(max.X(), other.max.X()), std::min(max.Y(), other.max.Y())},
+            };
+        }
+
+        /// @brief The square of tiles within Chebyshev distance `radius` of `center`.
+        static constexpr auto Around(const Vec2& center, int radius) -> Rect {
+            return Rect{center - Vec2{radius, radius}, center + Vec2{radius + 1, radius + 1}};
+        }
+    };
 } // namespace rglike
 
 template<> struct fmt::formatter<rglike::Vec2> : fmt::formatter<int> {
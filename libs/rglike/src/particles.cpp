@@ -0,0 +1,176 @@
+/**
+ * @file particles.cpp
+ * @author Alic Szecsei
+ * @date 7/23/2023
+ */
+
+#include "particles.hpp"
+
+#include "tile_map.hpp"
+
+#include <limits>
+#include <spdlog/spdlog.h>
+
+namespace rglike {
+    namespace {
+        /// @brief Decodes `text` if it is exactly one UTF-8 code point.
+        auto DecodeGlyph(std::string_view text) -> std::optional<char32_t> {
+            if (text.empty()) { return std::nullopt; }
+
+            auto lead = static_cast<unsigned char>(text[0]);
+            size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : 4;
+            if (text.size() != length || (length == 4 && (lead >> 3) != 0x1E)) {
+                return std::nullopt;
+            }
+
+            char32_t glyph = length == 1 ? lead : lead & (0x7F >> length);
+            for (size_t i = 1; i < length; ++i) {
+                auto byte = static_cast<unsigned char>(text[i]);
+                if ((byte >> 6) != 0x2) { return std::nullopt; }
+                glyph = (glyph << 6) | (byte & 0x3F);
+            }
+            return glyph;
+        }
+
+        /// @brief Parses `#RRGGBB`.
+        auto ParseColor(std::string_view text) -> std::optional<ftxui::Color> {
+            if (text.size() != 7 || text[0] != '#') { return std::nullopt; }
+
+            uint32_t rgb = 0;
+            for (size_t i = 1; i < text.size(); ++i) {
+                auto c = text[i];
+                uint32_t digit = 0;
+                if (c >= '0' && c <= '9') {
+                    digit = c - '0';
+                } else if (c >= 'a' && c <= 'f') {
+                    digit = c - 'a' + 10;
+                } else if (c >= 'A' && c <= 'F') {
+                    digit = c - 'A' + 10;
+                } else {
+                    return std::nullopt;
+                }
+                rgb = (rgb << 4) | digit;
+            }
+            return ftxui::Color::RGB(
+                static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8),
+                static_cast<uint8_t>(rgb)
+            );
+        }
+
+        /// @brief Parses a non-negative number of milliseconds, such as `400` or `400.0`.
+        auto ParseMilliseconds(std::string_view text) -> std::optional<ParticleClock::duration> {
+            if (text.empty()) { return std::nullopt; }
+
+            double value = 0.0;
+            double scale = 0.0;
+            for (auto c : text) {
+                if (c == '.' && scale == 0.0) {
+                    scale = 1.0;
+                } else if (c >= '0' && c <= '9') {
+                    if (scale > 0.0) {
+                        scale /= 10.0;
+                        value += (c - '0') * scale;
+                    } else {
+                        value = value * 10.0 + (c - '0');
+                    }
+                } else {
+                    return std::nullopt;
+                }
+            }
+            return std::chrono::duration_cast<ParticleClock::duration>(
+                std::chrono::duration<double, std::milli>(value)
+            );
+        }
+    } // namespace
+
+    auto ParseParticleSpec(std::string_view spec) -> std::optional<ParticleSpec> {
+        auto first = spec.find(';');
+        if (first == std::string_view::npos) { return std::nullopt; }
+        auto second = spec.find(';', first + 1);
+        if (second == std::string_view::npos) { return std::nullopt; }
+
+        auto glyph = DecodeGlyph(spec.substr(0, first));
+        auto color = ParseColor(spec.substr(first + 1, second - first - 1));
+        auto lifetime = ParseMilliseconds(spec.substr(second + 1));
+        if (!glyph || !color || !lifetime) { return std::nullopt; }
+        return ParticleSpec{*glyph, *color, *lifetime};
+    }
+
+    auto ParticleLibrary::Define(const std::string& name, std::string_view spec)
+        -> std::optional<ParticleId> {
+        auto parsed = ParseParticleSpec(spec);
+        if (!parsed) {
+            spdlog::warn("Ignoring malformed particle '{}' for {}", spec, name);
+            return std::nullopt;
+        }
+
+        auto existing = m_ids.find(name);
+        if (existing != m_ids.end()) {
+            m_specs[existing->second] = *parsed;
+            m_glyphs[existing->second] = GlyphToString(parsed->glyph);
+            return existing->second;
+        }
+
+        if (m_specs.size() > std::numeric_limits<ParticleId>::max()) {
+            spdlog::warn("Ignoring particle for {}: too many particles defined", name);
+            return std::nullopt;
+        }
+        auto id = static_cast<ParticleId>(m_specs.size());
+        m_specs.push_back(*parsed);
+        m_glyphs.push_back(GlyphToString(parsed->glyph));
+        m_ids.emplace(name, id);
+        return id;
+    }
+
+    auto ParticleLibrary::Find(std::string_view name) const -> std::optional<ParticleId> {
+        auto it = m_ids.find(std::string(name));
+        if (it == m_ids.end()) { return std::nullopt; }
+        return it->second;
+    }
+
+    void DefineBaseParticles(ParticleLibrary& library) {
+        library.Define("mmissile", "▓;#00FFFF;400.0");
+    }
+
+    ParticlePool::ParticlePool(size_t capacity)
+        : m_particles(capacity) { }
+
+    auto ParticlePool::Spawn(
+        const ParticleLibrary& library, ParticleId spec, Vec2 pos, ParticleClock::time_point now,
+        ParticleClock::duration delay
+    ) -> bool {
+        if (m_size == m_particles.size()) { return false; }
+
+        auto appears = now + delay;
+        m_particles[m_size++] = Particle{pos, spec, appears, appears + library.Spec(spec).lifetime};
+        return true;
+    }
+
+    auto ParticlePool::SpawnLine(
+        const ParticleLibrary& library, ParticleId spec, Vec2 from, Vec2 to,
+        ParticleClock::time_point now
+    ) -> size_t {
+        m_line.Clear();
+        TraceLine(from, to, LineKind::Bresenham, m_line);
+
+        size_t spawned = 0;
+        for (size_t i = 0; i < m_line.Size(); ++i) {
+            auto delay = std::chrono::milliseconds(PARTICLE_LINE_STEP_MS * static_cast<int>(i));
+            if (!Spawn(library, spec, m_line.At(i), now, delay)) { break; }
+            ++spawned;
+        }
+        return spawned;
+    }
+
+    void ParticlePool::Update(ParticleClock::time_point now) {
+        for (size_t i = 0; i < m_size;) {
+            if (m_particles[i].expires <= now) {
+                m_particles[i] = m_particles[--m_size];
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    void ParticlePool::Clear() { m_size = 0; }
+} // namespace rglike
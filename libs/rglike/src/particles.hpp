@@ -0,0 +1,130 @@
+/**
+ * @file particles.hpp
+ * @author Alic Szecsei
+ * @date 7/23/2023
+ */
+
+#pragma once
+
+#include "constants.hpp"
+#include "geometry.hpp"
+#include "math.hpp"
+
+#include <ftxui/screen/color.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace rglike {
+    using ParticleClock = std::chrono::steady_clock;
+
+    /// @brief Index of a spec in a ParticleLibrary.
+    using ParticleId = uint16_t;
+
+    /// @brief How a particle looks and how long it lasts. Written in the data scripts as
+    /// `glyph;#RRGGBB;milliseconds`, e.g. `▓;#00FFFF;400.0`.
+    struct ParticleSpec {
+        char32_t glyph = U'*';
+        ftxui::Color color = ftxui::Color::Default;
+        ParticleClock::duration lifetime{};
+    };
+
+    /// @brief Parses a spec string from the data scripts.
+    /// @return The spec, or nothing if the string is malformed.
+    [[nodiscard]] auto ParseParticleSpec(std::string_view spec) -> std::optional<ParticleSpec>;
+
+    /// @brief Every particle spec the game knows, parsed once as it is defined and looked up by
+    /// ParticleId from then on.
+    class ParticleLibrary {
+    private:
+        std::vector<ParticleSpec> m_specs;
+        /// @brief Each spec's glyph, already encoded for the terminal.
+        std::vector<std::string> m_glyphs;
+        std::unordered_map<std::string, ParticleId> m_ids;
+
+    public:
+        /// @brief Parses `spec` and files it under `name`, replacing any earlier spec of that name.
+        /// @return The spec's ID, or nothing if it could not be parsed.
+        auto Define(const std::string& name, std::string_view spec) -> std::optional<ParticleId>;
+
+        [[nodiscard]] auto Find(std::string_view name) const -> std::optional<ParticleId>;
+
+        [[nodiscard]] inline auto Spec(ParticleId id) const -> const ParticleSpec& {
+            return m_specs[id];
+        }
+
+        [[nodiscard]] inline auto Glyph(ParticleId id) const -> const std::string& {
+            return m_glyphs[id];
+        }
+    };
+
+    /// @brief Defines the particles used by `data/src/base/spells.ts`, under the ID of the spell
+    /// using them, until the script loader can define them itself.
+    void DefineBaseParticles(ParticleLibrary& library);
+
+    struct Particle {
+        Vec2 pos{0, 0};
+        ParticleId spec = 0;
+        ParticleClock::time_point appears{};
+        ParticleClock::time_point expires{};
+    };
+
+    /// @brief The live particles, in storage allocated once up front.
+    ///
+    /// Particles are kept packed at the front of the pool; an expired one is replaced by the last
+    /// so nothing has to shift. Once the pool is full, new particles are dropped.
+    class ParticlePool {
+    private:
+        std::vector<Particle> m_particles;
+        size_t m_size = 0;
+        /// @brief Scratch space for SpawnLine.
+        PositionBuffer m_line;
+
+    public:
+        explicit ParticlePool(size_t capacity = MAX_PARTICLES);
+
+        /// @brief Adds a particle at `pos` that appears after `delay` and lasts as long as its spec
+        /// says.
+        /// @return Whether there was room for it.
+        auto Spawn(
+            const ParticleLibrary& library, ParticleId spec, Vec2 pos,
+            ParticleClock::time_point now, ParticleClock::duration delay = {}
+        ) -> bool;
+
+        /// @brief Adds a particle on every tile from `from` to `to`, each appearing
+        /// PARTICLE_LINE_STEP_MS after the one before, as for spells with `particle_line`.
+        /// @return How many there was room for.
+        auto SpawnLine(
+            const ParticleLibrary& library, ParticleId spec, Vec2 from, Vec2 to,
+            ParticleClock::time_point now
+        ) -> size_t;
+
+        /// @brief Removes every particle that has expired by `now`.
+        void Update(ParticleClock::time_point now);
+
+        void Clear();
+
+        [[nodiscard]] inline auto Size() const -> size_t { return m_size; }
+
+        [[nodiscard]] inline auto Capacity() const -> size_t { return m_particles.size(); }
+
+        [[nodiscard]] inline auto Empty() const -> bool { return m_size == 0; }
+
+        /// @brief Calls `fn(particle, remaining)` for every particle showing at `now`, where
+        /// `remaining` is the fraction of its life it has left.
+        template<class Fn> void ForEachVisible(ParticleClock::time_point now, Fn&& fn) const {
+            for (size_t i = 0; i < m_size; ++i) {
+                const auto& particle = m_particles[i];
+                if (now < particle.appears || now >= particle.expires) { continue; }
+                std::chrono::duration<float> left = particle.expires - now;
+                std::chrono::duration<float> life = particle.expires - particle.appears;
+                fn(particle, life.count() > 0.0F ? left.count() / life.count() : 0.0F);
+            }
+        }
+    };
+} // namespace rglike
@@ -0,0 +1,280 @@
+/**
+ * @file pathfinding.cpp
+ * @author Alic Szecsei
+ * @date 6/20/2023
+ */
+
+#include "pathfinding.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace rglike {
+    namespace {
+        /// @brief Octile distance, which is exact on an open uniform-cost grid.
+        inline auto Octile(Vec2 from, Vec2 to) -> uint32_t {
+            auto dx = static_cast<uint32_t>(std::abs(to.X() - from.X()));
+            auto dy = static_cast<uint32_t>(std::abs(to.Y() - from.Y()));
+            return PATH_ORTHOGONAL_COST * std::max(dx, dy) +
+                   (PATH_DIAGONAL_COST - PATH_ORTHOGONAL_COST) * std::min(dx, dy);
+        }
+
+        inline auto Sign(int value) -> int { return (value > 0) - (value < 0); }
+
+        inline auto Walkable(const TileMap& map, int x, int y) -> bool {
+            return map.IsPassable(Vec2{x, y});
+        }
+
+        /// @brief Walks from `pos` (the first tile past the parent) in direction `dir` until it
+        /// finds a jump point, the goal, or a wall.
+        auto Jump(const TileMap& map, Vec2 pos, Vec2 dir, Vec2 goal, Vec2& out) -> bool {
+            int x = pos.X();
+            int y = pos.Y();
+            const int dx = dir.X();
+            const int dy = dir.Y();
+
+            while (true) {
+                if (!Walkable(map, x, y)) { return false; }
+                if (x == goal.X() && y == goal.Y()) {
+                    out = Vec2{x, y};
+                    return true;
+                }
+
+                if (dx != 0 && dy != 0) {
+                    // A diagonal move stops wherever one of its straight components finds
+                    // something interesting.
+                    Vec2 ignored{0, 0};
+                    if (Jump(map, Vec2{x + dx, y}, Vec2{dx, 0}, goal, ignored) ||
+                        Jump(map, Vec2{x, y + dy}, Vec2{0, dy}, goal, ignored)) {
+                        out = Vec2{x, y};
+                        return true;
+                    }
+                    if (!Walkable(map, x + dx, y) || !Walkable(map, x, y + dy)) { return false; }
+                } else if (dx != 0) {
+                    if ((Walkable(map, x, y - 1) && !Walkable(map, x - dx, y - 1)) ||
+                        (Walkable(map, x, y + 1) && !Walkable(map, x - dx, y + 1))) {
+                        out = Vec2{x, y};
+                        return true;
+                    }
+                } else {
+                    if ((Walkable(map, x - 1, y) && !Walkable(map, x - 1, y - dy)) ||
+                        (Walkable(map, x + 1, y) && !Walkable(map, x + 1, y - dy))) {
+                        out = Vec2{x, y};
+                        return true;
+                    }
+                }
+
+                x += dx;
+                y += dy;
+            }
+        }
+    } // namespace
+
+    void PathSearch::Begin(const TileMap& map) {
+        if (map.Width() != m_width || map.Height() != m_height) {
+            m_width = map.Width();
+            m_height = map.Height();
+            auto area = static_cast<size_t>(m_width) * m_height;
+            m_stamp.assign(area, 0);
+            m_g.resize(area);
+            m_parent.resize(area);
+            m_generation = 0;
+        }
+
+        // Stamps are 2 * generation (open) or 2 * generation + 1 (closed); anything lower is
+        // left over from an earlier search. Only on wrap-around do the stamps need clearing.
+        if (m_generation >= std::numeric_limits<uint32_t>::max() / 2 - 1) {
+            std::fill(m_stamp.begin(), m_stamp.end(), 0);
+            m_generation = 0;
+        }
+        ++m_generation;
+        m_open.clear();
+    }
+
+    void PathSearch::Push(uint32_t node, uint32_t g, uint32_t parent, Vec2 goal) {
+        m_stamp[node] = OpenStamp();
+        m_g[node] = g;
+        m_parent[node] = parent;
+        m_open.push_back(OpenEntry{g + Octile(Position(node), goal), g, node});
+        std::push_heap(m_open.begin(), m_open.end(), [](const OpenEntry& a, const OpenEntry& b) {
+            return a.f > b.f;
+        });
+    }
+
+    auto PathSearch::PopBest(uint32_t& node) -> bool {
+        auto cmp = [](const OpenEntry& a, const OpenEntry& b) {
+            return a.f > b.f;
+        };
+        while (!m_open.empty()) {
+            std::pop_heap(m_open.begin(), m_open.end(), cmp);
+            auto entry = m_open.back();
+            m_open.pop_back();
+
+            // Nodes are re-pushed instead of decreased in place, so skip stale entries.
+            if (m_stamp[entry.node] != OpenStamp()) { continue; }
+            if (entry.g != m_g[entry.node]) { continue; }
+
+            m_stamp[entry.node] = ClosedStamp();
+            node = entry.node;
+            return true;
+        }
+        return false;
+    }
+
+    void PathSearch::Reconstruct(uint32_t goal, std::vector<Vec2>& steps) {
+        // The start node is its own parent.
+        m_trace.clear();
+        auto node = goal;
+        m_trace.push_back(node);
+        while (m_parent[node] != node) {
+            node = m_parent[node];
+            m_trace.push_back(node);
+        }
+
+        // Consecutive trace nodes are joined by a straight or purely diagonal segment.
+        steps.clear();
+        for (auto it = m_trace.rbegin(); it + 1 != m_trace.rend(); ++it) {
+            Vec2 from = Position(*it);
+            Vec2 to = Position(*(it + 1));
+            Vec2 dir{Sign(to.X() - from.X()), Sign(to.Y() - from.Y())};
+            while (from != to) {
+                from += dir;
+                steps.push_back(from);
+            }
+        }
+    }
+
+    auto PathSearch::AStar(const TileMap& map, Vec2 from, Vec2 to) -> bool {
+        Push(Index(from), 0, Index(from), to);
+
+        uint32_t node = 0;
+        while (PopBest(node)) {
+            Vec2 pos = Position(node);
+            if (pos == to) { return true; }
+
+            for (const auto& dir : NEIGHBOR_OFFSETS) {
+                if (!map.CanStep(pos, dir)) { continue; }
+
+                Vec2 next = pos + dir;
+                auto next_node = Index(next);
+                if (m_stamp[next_node] == ClosedStamp()) { continue; }
+
+                auto step = (dir.X() != 0 && dir.Y() != 0) ? PATH_DIAGONAL_COST
+                                                           : PATH_ORTHOGONAL_COST;
+                auto g = m_g[node] + step * std::max(1, map.MoveCost(next));
+                if (m_stamp[next_node] == OpenStamp() && g >= m_g[next_node]) { continue; }
+                Push(next_node, g, node, to);
+            }
+        }
+        return false;
+    }
+
+    void PathSearch::JumpFrom(const TileMap& map, uint32_t node, Vec2 dir, Vec2 goal) {
+        Vec2 pos = Position(node);
+        Vec2 jump_point{0, 0};
+        if (!Jump(map, pos + dir, dir, goal, jump_point)) { return; }
+
+        auto jump_node = Index(jump_point);
+        if (m_stamp[jump_node] == ClosedStamp()) { return; }
+
+        auto g = m_g[node] + Octile(pos, jump_point);
+        if (m_stamp[jump_node] == OpenStamp() && g >= m_g[jump_node]) { return; }
+        Push(jump_node, g, node, goal);
+    }
+
+    auto PathSearch::JumpPointSearch(const TileMap& map, Vec2 from, Vec2 to) -> bool {
+        Push(Index(from), 0, Index(from), to);
+
+        uint32_t node = 0;
+        while (PopBest(node)) {
+            Vec2 pos = Position(node);
+            if (pos == to) { return true; }
+
+            auto parent = m_parent[node];
+            if (parent == node) {
+                // The start node has no direction to prune by.
+                for (const auto& dir : NEIGHBOR_OFFSETS) {
+                    if (map.CanStep(pos, dir)) { JumpFrom(map, node, dir, to); }
+                }
+                continue;
+            }
+
+            Vec2 parent_pos = Position(parent);
+            int dx = Sign(pos.X() - parent_pos.X());
+            int dy = Sign(pos.Y() - parent_pos.Y());
+            int x = pos.X();
+            int y = pos.Y();
+
+            if (dx != 0 && dy != 0) {
+                bool vertical = Walkable(map, x, y + dy);
+                bool horizontal = Walkable(map, x + dx, y);
+                if (vertical) { JumpFrom(map, node, Vec2{0, dy}, to); }
+                if (horizontal) { JumpFrom(map, node, Vec2{dx, 0}, to); }
+                if (vertical && horizontal) { JumpFrom(map, node, Vec2{dx, dy}, to); }
+            } else if (dx != 0) {
+                bool up = Walkable(map, x, y - 1);
+                bool down = Walkable(map, x, y + 1);
+                if (Walkable(map, x + dx, y)) {
+                    JumpFrom(map, node, Vec2{dx, 0}, to);
+                    if (up) { JumpFrom(map, node, Vec2{dx, -1}, to); }
+                    if (down) { JumpFrom(map, node, Vec2{dx, 1}, to); }
+                }
+                if (up) { JumpFrom(map, node, Vec2{0, -1}, to); }
+                if (down) { JumpFrom(map, node, Vec2{0, 1}, to); }
+            } else {
+                bool left = Walkable(map, x - 1, y);
+                bool right = Walkable(map, x + 1, y);
+                if (Walkable(map, x, y + dy)) {
+                    JumpFrom(map, node, Vec2{0, dy}, to);
+                    if (left) { JumpFrom(map, node, Vec2{-1, dy}, to); }
+                    if (right) { JumpFrom(map, node, Vec2{1, dy}, to); }
+                }
+                if (left) { JumpFrom(map, node, Vec2{-1, 0}, to); }
+                if (right) { JumpFrom(map, node, Vec2{1, 0}, to); }
+            }
+        }
+        return false;
+    }
+
+    auto PathSearch::Find(const TileMap& map, Vec2 from, Vec2 to, std::vector<Vec2>& steps)
+        -> bool {
+        steps.clear();
+        if (!map.InBounds(from) || !map.IsPassable(to)) { return false; }
+        if (from == to) { return true; }
+
+        Begin(map);
+        bool found = map.IsUniformCost() ? JumpPointSearch(map, from, to) : AStar(map, from, to);
+        if (found) { Reconstruct(Index(to), steps); }
+        return found;
+    }
+
+    auto Pathfinder::FindPath(const TileMap& map, Vec2 from, Vec2 to, std::vector<Vec2>& steps)
+        -> bool {
+        return m_searches.front().Find(map, from, to, steps);
+    }
+
+    void Pathfinder::FindPaths(
+        const TileMap& map, const std::vector<PathQuery>& queries, std::vector<PathResult>& results,
+        ThreadPool* pool
+    ) {
+        if (results.size() < queries.size()) { results.resize(queries.size()); }
+
+        auto resolve = [&](size_t begin, size_t end, size_t worker) {
+            auto& search = m_searches[worker];
+            for (size_t i = begin; i < end; ++i) {
+                const auto& query = queries[i];
+                results[i].found = search.Find(map, query.from, query.to, results[i].steps);
+            }
+        };
+
+        if (pool == nullptr) {
+            resolve(0, queries.size(), 0);
+            return;
+        }
+
+        if (m_searches.size() < pool->WorkerCount()) { m_searches.resize(pool->WorkerCount()); }
+        constexpr size_t QUERIES_PER_TASK = 8;
+        pool->ParallelFor(queries.size(), QUERIES_PER_TASK, resolve);
+    }
+} // namespace rglike
@@ -0,0 +1,100 @@
+/**
+ * @file pathfinding.hpp
+ * @author Alic Szecsei
+ * @date 6/20/2023
+ */
+
+#pragma once
+
+#include "math.hpp"
+#include "thread_pool.hpp"
+#include "tile_map.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace rglike {
+    /// @brief Cost of an orthogonal step onto an ordinary tile.
+    constexpr uint32_t PATH_ORTHOGONAL_COST = 10;
+    /// @brief Cost of a diagonal step onto an ordinary tile (roughly 10 * sqrt(2)).
+    constexpr uint32_t PATH_DIAGONAL_COST = 14;
+
+    struct PathQuery {
+        Vec2 from;
+        Vec2 to;
+    };
+
+    struct PathResult {
+        bool found = false;
+        /// @brief Every tile to step onto, in order, excluding the start and including the goal.
+        std::vector<Vec2> steps;
+    };
+
+    /// @brief Scratch space for a single path search.
+    ///
+    /// Node state lives in flat arrays sized to the map and stamped with a generation counter, so
+    /// starting a new search is O(1) instead of clearing them, and nothing is allocated once the
+    /// arrays and the open list have grown to fit the map. Not thread-safe; use one per thread.
+    class PathSearch {
+    private:
+        struct OpenEntry {
+            uint32_t f;
+            uint32_t g;
+            uint32_t node;
+        };
+
+        int m_width = 0;
+        int m_height = 0;
+        uint32_t m_generation = 0;
+        std::vector<uint32_t> m_stamp;
+        std::vector<uint32_t> m_g;
+        std::vector<uint32_t> m_parent;
+        std::vector<OpenEntry> m_open;
+        std::vector<uint32_t> m_trace;
+
+        void Begin(const TileMap& map);
+
+        [[nodiscard]] inline auto OpenStamp() const -> uint32_t { return m_generation * 2; }
+
+        [[nodiscard]] inline auto ClosedStamp() const -> uint32_t { return m_generation * 2 + 1; }
+
+        [[nodiscard]] inline auto Index(Vec2 pos) const -> uint32_t {
+            return static_cast<uint32_t>(pos.Y() * m_width + pos.X());
+        }
+
+        [[nodiscard]] inline auto Position(uint32_t node) const -> Vec2 {
+            return Vec2{static_cast<int>(node) % m_width, static_cast<int>(node) / m_width};
+        }
+
+        void Push(uint32_t node, uint32_t g, uint32_t parent, Vec2 goal);
+        auto PopBest(uint32_t& node) -> bool;
+        void Reconstruct(uint32_t goal, std::vector<Vec2>& steps);
+
+        auto AStar(const TileMap& map, Vec2 from, Vec2 to) -> bool;
+        auto JumpPointSearch(const TileMap& map, Vec2 from, Vec2 to) -> bool;
+        void JumpFrom(const TileMap& map, uint32_t node, Vec2 dir, Vec2 goal);
+
+    public:
+        /// @brief Finds a shortest 8-connected path that never cuts corners. Uses jump point
+        /// search when every tile costs the same to enter, and A* otherwise.
+        auto Find(const TileMap& map, Vec2 from, Vec2 to, std::vector<Vec2>& steps) -> bool;
+    };
+
+    /// @brief Answers path queries for the world, one at a time or in per-turn batches.
+    class Pathfinder {
+    private:
+        std::vector<PathSearch> m_searches = std::vector<PathSearch>(1);
+
+    public:
+        auto FindPath(const TileMap& map, Vec2 from, Vec2 to, std::vector<Vec2>& steps) -> bool;
+
+        /// @brief Resolves every query into the matching slot of `results`. If `pool` is given
+        /// the queries are spread across its workers. `results` is grown but never shrunk (slots
+        /// past the last query are left untouched), so reusing it from turn to turn avoids
+        /// reallocating the step lists.
+        void FindPaths(
+            const TileMap& map, const std::vector<PathQuery>& queries,
+            std::vector<PathResult>& results, ThreadPool* pool = nullptr
+        );
+    };
+} // namespace rglike
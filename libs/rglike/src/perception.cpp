@@ -0,0 +1,100 @@
+/**
+ * @file perception.cpp
+ * @author Alic Szecsei
+ * @date 7/19/2023
+ */
+
+#include "perception.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace rglike {
+    namespace {
+        /// @brief Entities each worker takes at a time. Each costs a spatial query, so small
+        /// batches still outweigh the scheduling.
+        constexpr size_t PERCEPTION_GRAIN = 64;
+
+        inline auto DistanceSquared(Vec2 from, Vec2 to) -> int {
+            auto delta = to - from;
+            return delta.X() * delta.X() + delta.Y() * delta.Y();
+        }
+    } // namespace
+
+    void Perception::Evaluate(
+        const entt::registry& registry, const SpatialIndex& spatial, const FactionMatrix& factions,
+        Vec2 player, int radius, ThreadPool& pool
+    ) {
+        m_entities.clear();
+        m_positions.clear();
+        m_factions.clear();
+        for (auto entity : registry.view<Position, FactionIndex>()) {
+            m_entities.push_back(entity);
+        }
+
+        std::fill(m_slots.begin(), m_slots.end(), NONE);
+        m_positions.reserve(m_entities.size());
+        m_factions.reserve(m_entities.size());
+        for (size_t i = 0; i < m_entities.size(); ++i) {
+            auto entity = m_entities[i];
+            m_positions.push_back(registry.get<Position>(entity).pos);
+            m_factions.push_back(registry.get<FactionIndex>(entity).id);
+
+            auto index = static_cast<size_t>(entt::to_entity(entity));
+            if (index >= m_slots.size()) { m_slots.resize(index + 1, NONE); }
+            m_slots[index] = static_cast<uint32_t>(i);
+        }
+        m_reactions.assign(m_entities.size(), Reaction{});
+
+        const auto player_faction = factions.Id(PLAYER_FACTION);
+        const auto radius_sq = radius * radius;
+        std::atomic<size_t> pairs{0};
+        const auto decide = [&](size_t begin, size_t end, size_t) {
+            size_t looked_up = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const auto self = m_entities[i];
+                const auto pos = m_positions[i];
+                const auto faction = m_factions[i];
+                auto& reaction = m_reactions[i];
+                int best = radius_sq + 1;
+
+                const auto consider = [&](Response response, Vec2 target, bool is_player) {
+                    if (response == Response::Ignore) { return; }
+                    auto distance = DistanceSquared(pos, target);
+                    if (distance > best) { return; }
+                    if (distance == best && (reaction.response == Response::Flee ||
+                                             response != Response::Flee)) {
+                        return;
+                    }
+                    best = distance;
+                    reaction = Reaction{response, target, is_player};
+                };
+
+                spatial.QueryRadius(pos, radius, [&](entt::entity other, Vec2 other_pos) {
+                    if (other == self) { return; }
+                    auto index = static_cast<size_t>(entt::to_entity(other));
+                    if (index >= m_slots.size() || m_slots[index] == NONE) { return; }
+                    ++looked_up;
+                    consider(
+                        factions.ResponseTo(faction, m_factions[m_slots[index]]), other_pos, false
+                    );
+                });
+
+                if (DistanceSquared(pos, player) <= radius_sq) {
+                    ++looked_up;
+                    consider(factions.ResponseTo(faction, player_faction), player, true);
+                }
+            }
+            pairs.fetch_add(looked_up, std::memory_order_relaxed);
+        };
+        pool.ParallelFor(m_entities.size(), PERCEPTION_GRAIN, decide);
+        m_pairs = pairs.load();
+    }
+
+    auto Perception::ReactionOf(entt::entity entity) const -> Reaction {
+        auto index = static_cast<size_t>(entt::to_entity(entity));
+        if (index >= m_slots.size() || m_slots[index] == NONE) { return Reaction{}; }
+        auto slot = m_slots[index];
+        return m_entities[slot] == entity ? m_reactions[slot] : Reaction{};
+    }
+} // namespace rglike
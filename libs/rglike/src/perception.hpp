@@ -0,0 +1,67 @@
+/**
+ * @file perception.hpp
+ * @author Alic Szecsei
+ * @date 7/19/2023
+ */
+
+#pragma once
+
+#include "components.hpp"
+#include "factions.hpp"
+#include "math.hpp"
+#include "spatial_index.hpp"
+#include "thread_pool.hpp"
+
+#include "entt/entt.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace rglike {
+    /// @brief What an entity has decided to do about the others it can see.
+    struct Reaction {
+        Response response = Response::Ignore;
+        /// @brief Where whatever it is attacking or fleeing from stands.
+        Vec2 target{0, 0};
+        /// @brief Whether that is the player, who has fields to follow rather than a bare
+        /// position.
+        bool player = false;
+    };
+
+    /// @brief Decides, once per turn, how every entity with a faction reacts to those around it.
+    ///
+    /// A pass gathers each faction member's position and interned faction into dense arrays,
+    /// then splits them across the worker threads. Each entity queries the spatial index for
+    /// everything within the sight radius, looks up its faction's response to each in the
+    /// FactionMatrix, and settles on the nearest one it would attack or flee from; fleeing wins
+    /// ties. The player is seen like anyone else, as a member of PLAYER_FACTION.
+    class Perception {
+    private:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        std::vector<entt::entity> m_entities;
+        std::vector<Vec2> m_positions;
+        std::vector<FactionId> m_factions;
+        std::vector<Reaction> m_reactions;
+        /// @brief Index into the arrays above, by entity.
+        std::vector<uint32_t> m_slots;
+        size_t m_pairs = 0;
+
+    public:
+        /// @brief Works out every faction member's reaction to whatever it can see within
+        /// `radius` tiles.
+        void Evaluate(
+            const entt::registry& registry, const SpatialIndex& spatial,
+            const FactionMatrix& factions, Vec2 player, int radius, ThreadPool& pool
+        );
+
+        /// @brief The reaction `entity` settled on in the last pass. Ignore if it wasn't in it.
+        [[nodiscard]] auto ReactionOf(entt::entity entity) const -> Reaction;
+
+        /// @brief How many entities the last pass decided for.
+        [[nodiscard]] inline auto Size() const -> size_t { return m_entities.size(); }
+
+        /// @brief How many pairs of entities the last pass looked up a response for.
+        [[nodiscard]] inline auto Pairs() const -> size_t { return m_pairs; }
+    };
+} // namespace rglike
@@ -0,0 +1,42 @@
+/**
+ * @file random.hpp
+ * @author Alic Szecsei
+ * @date 7/10/2023
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace rglike {
+    /// @brief The SplitMix64 finalizer.
+    constexpr auto Mix(uint64_t value) -> uint64_t {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+        return value ^ (value >> 31);
+    }
+
+    /// @brief A SplitMix64 generator. The standard distributions are implementation-defined, so
+    /// ranges are derived here to keep anything built from a seed identical across platforms.
+    class Rng {
+    private:
+        uint64_t m_state;
+
+    public:
+        explicit Rng(uint64_t seed)
+            : m_state(seed) { }
+
+        auto Next() -> uint64_t {
+            m_state += 0x9E3779B97F4A7C15;
+            return Mix(m_state);
+        }
+
+        /// @brief A value in [lo, hi].
+        auto Range(int lo, int hi) -> int {
+            auto span = static_cast<uint64_t>(hi - lo + 1);
+            return lo + static_cast<int>(((Next() >> 32) * span) >> 32);
+        }
+
+        auto Percent(int chance) -> bool { return Range(0, 99) < chance; }
+    };
+} // namespace rglike
@@ -0,0 +1,172 @@
+/**
+ * @file region_file.cpp
+ * @author Alic Szecsei
+ * @date 7/2/2023
+ */
+
+#include "region_file.hpp"
+
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rglike {
+    namespace {
+        constexpr std::array<char, 8> REGION_MAGIC{'R', 'G', 'L', 'R', 'E', 'G', 'N', '\0'};
+        constexpr uint32_t REGION_VERSION = 2;
+        constexpr size_t REGION_PAGE = 4096;
+        constexpr uint32_t INITIAL_SLOTS = 64;
+
+        constexpr auto RoundUp(size_t value, size_t multiple) -> size_t {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        constexpr size_t SLOT_BYTES = RoundUp(sizeof(TileChunk), REGION_PAGE);
+    } // namespace
+
+    struct RegionFile::Header {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t chunk_bytes;
+        int32_t chunks_wide;
+        int32_t chunks_high;
+        uint32_t slots_used;
+        uint32_t slots_capacity;
+        uint64_t fingerprint;
+    };
+
+    RegionFile::RegionFile(
+        const std::string& path, int chunks_wide, int chunks_high, uint64_t fingerprint
+    )
+        : m_chunk_count(static_cast<size_t>(chunks_wide) * chunks_high) {
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (m_fd < 0) { throw std::runtime_error("Could not open region file " + path); }
+
+        try {
+            Open(path, chunks_wide, chunks_high, fingerprint);
+        } catch (...) {
+            if (m_base != nullptr) { ::munmap(m_base, m_mapped_bytes); }
+            ::close(m_fd);
+            throw;
+        }
+    }
+
+    void RegionFile::Open(
+        const std::string& path, int chunks_wide, int chunks_high, uint64_t fingerprint
+    ) {
+        struct stat info {};
+        ::fstat(m_fd, &info);
+        if (info.st_size == 0) {
+            auto bytes = DataOffset() + INITIAL_SLOTS * SLOT_BYTES;
+            if (::ftruncate(m_fd, static_cast<off_t>(bytes)) != 0) {
+                throw std::runtime_error("Could not size region file " + path);
+            }
+            Map(bytes);
+            auto& header = GetHeader();
+            header.magic = REGION_MAGIC;
+            header.version = REGION_VERSION;
+            header.chunk_bytes = sizeof(TileChunk);
+            header.chunks_wide = chunks_wide;
+            header.chunks_high = chunks_high;
+            header.slots_used = 0;
+            header.slots_capacity = INITIAL_SLOTS;
+            header.fingerprint = fingerprint;
+            return;
+        }
+
+        if (static_cast<size_t>(info.st_size) < DataOffset()) {
+            throw std::runtime_error("Region file " + path + " is truncated");
+        }
+        Map(static_cast<size_t>(info.st_size));
+        const auto& header = GetHeader();
+        if (header.magic != REGION_MAGIC || header.version != REGION_VERSION ||
+            header.chunk_bytes != sizeof(TileChunk) || header.chunks_wide != chunks_wide ||
+            header.chunks_high != chunks_high || header.fingerprint != fingerprint) {
+            throw std::runtime_error("Region file " + path + " does not match this map");
+        }
+        auto capacity_bytes = uint64_t{header.slots_capacity} * SLOT_BYTES;
+        if (header.slots_used > header.slots_capacity ||
+            DataOffset() + capacity_bytes > static_cast<uint64_t>(info.st_size)) {
+            throw std::runtime_error("Region file " + path + " is corrupt");
+        }
+    }
+
+    RegionFile::~RegionFile() {
+        if (m_base != nullptr) {
+            ::msync(m_base, m_mapped_bytes, MS_SYNC);
+            ::munmap(m_base, m_mapped_bytes);
+        }
+        if (m_fd >= 0) { ::close(m_fd); }
+    }
+
+    auto RegionFile::GetHeader() const -> Header& { return *reinterpret_cast<Header*>(m_base); }
+
+    auto RegionFile::Index() const -> uint32_t* {
+        return reinterpret_cast<uint32_t*>(m_base + RoundUp(sizeof(Header), alignof(uint64_t)));
+    }
+
+    auto RegionFile::DataOffset() const -> size_t {
+        auto index_bytes = m_chunk_count * sizeof(uint32_t);
+        return RoundUp(RoundUp(sizeof(Header), alignof(uint64_t)) + index_bytes, REGION_PAGE);
+    }
+
+    void RegionFile::Map(size_t bytes) {
+        if (m_base != nullptr) { ::munmap(m_base, m_mapped_bytes); }
+
+        void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (base == MAP_FAILED) {
+            m_base = nullptr;
+            throw std::runtime_error("Could not map region file");
+        }
+        m_base = static_cast<uint8_t*>(base);
+        m_mapped_bytes = bytes;
+    }
+
+    void RegionFile::Grow() {
+        auto capacity = GetHeader().slots_capacity * 2;
+        auto bytes = DataOffset() + capacity * SLOT_BYTES;
+        if (::ftruncate(m_fd, static_cast<off_t>(bytes)) != 0) {
+            throw std::runtime_error("Could not grow region file");
+        }
+        Map(bytes);
+        GetHeader().slots_capacity = capacity;
+    }
+
+    auto RegionFile::Contains(size_t index) const -> bool {
+        return index < m_chunk_count && Index()[index] != 0;
+    }
+
+    auto RegionFile::Read(size_t index, TileChunk& chunk) const -> bool {
+        if (!Contains(index)) { return false; }
+
+        auto slot = Index()[index];
+        if (slot > GetHeader().slots_used) {
+            spdlog::warn("Region file slot {} for chunk {} is out of range", slot, index);
+            return false;
+        }
+        auto offset = DataOffset() + size_t{slot - 1} * SLOT_BYTES;
+        std::memcpy(&chunk, m_base + offset, sizeof(TileChunk));
+        return true;
+    }
+
+    void RegionFile::Write(size_t index, const TileChunk& chunk) {
+        if (index >= m_chunk_count) { return; }
+
+        auto slot = Index()[index];
+        if (slot == 0 || slot > GetHeader().slots_used) {
+            if (GetHeader().slots_used == GetHeader().slots_capacity) { Grow(); }
+            slot = ++GetHeader().slots_used;
+            Index()[index] = slot;
+        }
+
+        auto offset = DataOffset() + size_t{slot - 1} * SLOT_BYTES;
+        std::memcpy(m_base + offset, &chunk, sizeof(TileChunk));
+    }
+
+    void RegionFile::Flush() { ::msync(m_base, m_mapped_bytes, MS_ASYNC); }
+} // namespace rglike
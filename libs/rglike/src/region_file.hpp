@@ -0,0 +1,69 @@
+/**
+ * @file region_file.hpp
+ * @author Alic Szecsei
+ * @date 7/2/2023
+ */
+
+#pragma once
+
+#include "tile_map.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rglike {
+    /// @brief A memory-mapped file holding evicted chunks of one TileMap.
+    ///
+    /// The file starts with a header and a fixed-size index with one slot number per chunk of
+    /// the map (zero for chunks never stored). The header records a fingerprint of the level the
+    /// chunks came from, so a file left over from a different seed is never read back. Chunk
+    /// data follows in page-aligned slots, handed out in the order chunks are first stored. The
+    /// file grows by doubling its slot capacity.
+    ///
+    /// Reads and writes go through the mapping, so the kernel pages chunk data in and out
+    /// as needed. Not thread-safe; ChunkStreamer only touches it from its I/O thread.
+    class RegionFile {
+    private:
+        struct Header;
+
+        int m_fd = -1;
+        uint8_t* m_base = nullptr;
+        size_t m_mapped_bytes = 0;
+        size_t m_chunk_count = 0;
+
+        [[nodiscard]] auto GetHeader() const -> Header&;
+        [[nodiscard]] auto Index() const -> uint32_t*;
+        [[nodiscard]] auto DataOffset() const -> size_t;
+
+        void Open(const std::string& path, int chunks_wide, int chunks_high, uint64_t fingerprint);
+        void Map(size_t bytes);
+        void Grow();
+
+    public:
+        /// @brief Opens the region file at `path`, creating it if needed.
+        /// @param fingerprint Identifies the level, e.g. DungeonFingerprint of its settings.
+        /// @throws std::runtime_error if the file cannot be opened or mapped, is corrupt, or was
+        /// written for a different level.
+        RegionFile(const std::string& path, int chunks_wide, int chunks_high, uint64_t fingerprint);
+        ~RegionFile();
+
+        RegionFile(const RegionFile&) = delete;
+        auto operator=(const RegionFile&) -> RegionFile& = delete;
+        RegionFile(RegionFile&&) = delete;
+        auto operator=(RegionFile&&) -> RegionFile& = delete;
+
+        /// @brief Whether chunk `index` (row-major chunk order) has ever been stored.
+        [[nodiscard]] auto Contains(size_t index) const -> bool;
+
+        /// @brief Copies chunk `index` into `chunk`.
+        /// @return False, leaving `chunk` untouched, if the chunk has never been stored or its
+        /// index entry points outside the file.
+        auto Read(size_t index, TileChunk& chunk) const -> bool;
+
+        void Write(size_t index, const TileChunk& chunk);
+
+        /// @brief Schedules dirty pages to be written back to disk.
+        void Flush();
+    };
+} // namespace rglike
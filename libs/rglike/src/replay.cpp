@@ -0,0 +1,163 @@
+/**
+ * @file replay.cpp
+ * @author Alic Szecsei
+ * @date 7/17/2023
+ */
+
+#include "replay.hpp"
+
+#include "input.hpp"
+
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <spdlog/spdlog.h>
+
+namespace rglike {
+    namespace {
+        constexpr std::array<char, 8> REPLAY_MAGIC{'R', 'G', 'L', 'R', 'E', 'P', 'L', '\0'};
+        constexpr uint64_t REPLAY_VERSION = 1;
+        /// @brief Marks the end of the events; the final state hash follows.
+        constexpr uint64_t REPLAY_END = 0;
+
+        class ReplayReader {
+        private:
+            const std::vector<char>& m_data;
+            size_t m_offset;
+            bool m_failed = false;
+
+        public:
+            ReplayReader(const std::vector<char>& data, size_t offset)
+                : m_data(data)
+                , m_offset(offset) { }
+
+            [[nodiscard]] auto Failed() const -> bool { return m_failed; }
+
+            [[nodiscard]] auto AtEnd() const -> bool { return m_offset == m_data.size(); }
+
+            [[nodiscard]] auto Remaining() const -> size_t { return m_data.size() - m_offset; }
+
+            auto Varint() -> uint64_t {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64 && m_offset < m_data.size(); shift += 7) {
+                    auto byte = static_cast<uint8_t>(m_data[m_offset++]);
+                    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0) { return value; }
+                }
+                m_failed = true;
+                return 0;
+            }
+
+            auto Fixed64() -> uint64_t {
+                if (Remaining() < 8) {
+                    m_failed = true;
+                    return 0;
+                }
+                uint64_t value = 0;
+                for (int byte = 0; byte < 8; ++byte) {
+                    value |= static_cast<uint64_t>(static_cast<uint8_t>(m_data[m_offset++]))
+                          << (byte * 8);
+                }
+                return value;
+            }
+
+            auto String(size_t length) -> std::string {
+                if (length > Remaining()) {
+                    m_failed = true;
+                    return {};
+                }
+                std::string value{m_data.data() + m_offset, length};
+                m_offset += length;
+                return value;
+            }
+        };
+    } // namespace
+
+    void ReplayRecorder::WriteVarint(uint64_t value) {
+        while (value >= 0x80) {
+            m_file.put(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        m_file.put(static_cast<char>(value));
+    }
+
+    auto ReplayRecorder::Start(const std::string& path, uint64_t seed) -> bool {
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_file) {
+            spdlog::error("Failed to open replay {} for recording", path);
+            return false;
+        }
+        m_inputs.clear();
+        m_events = 0;
+        m_file.write(REPLAY_MAGIC.data(), REPLAY_MAGIC.size());
+        WriteVarint(REPLAY_VERSION);
+        WriteVarint(seed);
+        m_file.flush();
+        spdlog::info("Recording replay to {}", path);
+        return true;
+    }
+
+    void ReplayRecorder::Record(const ftxui::Event& event) {
+        if (!Recording()) { return; }
+
+        // Codes 1 to N refer to the N inputs seen so far; N + 1 introduces a new one.
+        const auto& input = event.input();
+        auto [it, inserted] = m_inputs.emplace(input, m_inputs.size());
+        WriteVarint(it->second + 1);
+        if (inserted) {
+            WriteVarint(input.size());
+            m_file.write(input.data(), static_cast<std::streamsize>(input.size()));
+        }
+        m_file.flush();
+        ++m_events;
+    }
+
+    void ReplayRecorder::Finish(uint64_t state_hash) {
+        if (!Recording()) { return; }
+
+        WriteVarint(REPLAY_END);
+        for (int byte = 0; byte < 8; ++byte) {
+            m_file.put(static_cast<char>((state_hash >> (byte * 8)) & 0xFF));
+        }
+        m_file.close();
+        spdlog::info("Recorded {} events, final state {:016x}", m_events, state_hash);
+    }
+
+    auto LoadReplay(const std::string& path) -> std::optional<Replay> {
+        std::ifstream file{path, std::ios::binary};
+        if (!file) { return std::nullopt; }
+        std::vector<char> data{std::istreambuf_iterator<char>(file), {}};
+        if (data.size() < REPLAY_MAGIC.size() ||
+            std::memcmp(data.data(), REPLAY_MAGIC.data(), REPLAY_MAGIC.size()) != 0) {
+            return std::nullopt;
+        }
+
+        ReplayReader reader{data, REPLAY_MAGIC.size()};
+        if (reader.Varint() != REPLAY_VERSION) { return std::nullopt; }
+
+        Replay replay{};
+        replay.seed = reader.Varint();
+        while (!reader.Failed() && !reader.AtEnd()) {
+            auto code = reader.Varint();
+            if (code == REPLAY_END) {
+                replay.final_hash = reader.Fixed64();
+                break;
+            }
+            if (code == replay.inputs.size() + 1) {
+                replay.inputs.push_back(reader.String(reader.Varint()));
+            } else if (code > replay.inputs.size()) {
+                return std::nullopt;
+            }
+            replay.events.push_back(static_cast<uint32_t>(code - 1));
+        }
+        if (reader.Failed()) { return std::nullopt; }
+        return replay;
+    }
+
+    void PlayReplay(World& world, const Replay& replay) {
+        std::vector<ftxui::Event> events{};
+        events.reserve(replay.inputs.size());
+        for (const auto& input : replay.inputs) { events.push_back(ftxui::Event::Special(input)); }
+        for (auto event : replay.events) { ApplyInput(world, events[event]); }
+    }
+} // namespace rglike
@@ -0,0 +1,67 @@
+/**
+ * @file replay.hpp
+ * @author Alic Szecsei
+ * @date 7/17/2023
+ */
+
+#pragma once
+
+#include "world.hpp"
+
+#include <ftxui/component/event.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rglike {
+    /// @brief A recorded session: the seed it started from and every input the world accepted.
+    struct Replay {
+        uint64_t seed = 0;
+        /// @brief Each distinct input's raw terminal sequence, as in `ftxui::Event::input()`.
+        std::vector<std::string> inputs;
+        /// @brief The session's events, as indices into `inputs`.
+        std::vector<uint32_t> events;
+        /// @brief World::StateHash() when the session ended. Missing if it never ended cleanly.
+        std::optional<uint64_t> final_hash;
+    };
+
+    /// @brief Writes a session's inputs to a replay file as they happen.
+    ///
+    /// The file is a short header followed by one varint per event. An event seen before is
+    /// written as its index in the table of distinct inputs; a new one is written in full, once.
+    /// Events are flushed as they arrive, so a crashed session can still be replayed.
+    class ReplayRecorder {
+    private:
+        std::ofstream m_file;
+        std::unordered_map<std::string, uint64_t> m_inputs;
+        size_t m_events = 0;
+
+        void WriteVarint(uint64_t value);
+
+    public:
+        /// @brief Starts recording to `path` a session generated from `seed`.
+        auto Start(const std::string& path, uint64_t seed) -> bool;
+
+        [[nodiscard]] inline auto Recording() const -> bool { return m_file.is_open(); }
+
+        [[nodiscard]] inline auto Events() const -> size_t { return m_events; }
+
+        /// @brief Appends `event`. Does nothing if not recording.
+        void Record(const ftxui::Event& event);
+
+        /// @brief Ends the recording with the world's final state, to check replays against.
+        void Finish(uint64_t state_hash);
+    };
+
+    /// @brief Reads a replay written by ReplayRecorder.
+    /// @return The replay, or nothing if the file is missing or malformed.
+    auto LoadReplay(const std::string& path) -> std::optional<Replay>;
+
+    /// @brief Feeds every event in `replay` to `world`, which should have been initialized from
+    /// the replay's seed.
+    void PlayReplay(World& world, const Replay& replay);
+} // namespace rglike
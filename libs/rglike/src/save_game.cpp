@@ -0,0 +1,516 @@
+/**
+ * @file save_game.cpp
+ * @author Alic Szecsei
+ * @date 7/5/2023
+ */
+
+#include "save_game.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <unordered_map>
+
+#ifdef RGLIKE_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace rglike {
+    namespace {
+        constexpr std::array<char, 8> SAVE_MAGIC{'R', 'G', 'L', 'S', 'A', 'V', 'E', '\0'};
+        constexpr uint32_t SAVE_VERSION = 4;
+        constexpr int ZSTD_LEVEL = 3;
+        /// @brief The largest decompressed save accepted. Far beyond any real save, but small
+        /// enough that a corrupt size can't exhaust memory.
+        constexpr uint64_t MAX_SAVE_BYTES = uint64_t{1} << 30;
+        /// @brief No snapshot can list more entities than there are entity identifiers.
+        constexpr uint64_t MAX_SAVE_ENTITIES =
+            uint64_t{entt::entt_traits<entt::entity>::entity_mask} + 1;
+        /// @brief The widest light a save may hold. A light's stamp grows with the square of its
+        /// radius, and is allocated as soon as the save is lit.
+        constexpr int64_t MAX_LIGHT_RADIUS = 255;
+        /// @brief The fastest actor a save may hold: ten actions a tick.
+        constexpr int64_t MAX_ACTOR_SPEED = 10 * ACTION_COST;
+        /// @brief Energy a saved actor may be in credit or debt by. Keeps the scheduler's energy
+        /// arithmetic well clear of overflow.
+        constexpr int64_t MAX_ACTOR_ENERGY = 1000 * ACTION_COST;
+
+        using EntityBits = std::underlying_type_t<entt::entity>;
+
+        /// @brief The components that go into a save. Saving and loading both go through here so
+        /// the two can never disagree on the order.
+        template<class Snapshot, class Archive>
+        void ArchiveComponents(Snapshot& snapshot, Archive& archive) {
+            snapshot.template component<Position, FactionMember, Actor, LightSource>(archive);
+        }
+
+        constexpr auto ZigZag(int64_t value) -> uint64_t {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        constexpr auto UnZigZag(uint64_t value) -> int64_t {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        class SaveWriter {
+        private:
+            std::vector<uint8_t>& m_out;
+            EntityBits m_last_entity = 0;
+            Vec2 m_last_position{0, 0};
+            std::unordered_map<std::string, uint32_t> m_strings;
+
+        public:
+            explicit SaveWriter(std::vector<uint8_t>& out)
+                : m_out(out) { }
+
+            void Varint(uint64_t value) {
+                while (value >= 0x80) {
+                    m_out.push_back(static_cast<uint8_t>(value | 0x80));
+                    value >>= 7;
+                }
+                m_out.push_back(static_cast<uint8_t>(value));
+            }
+
+            void Signed(int64_t value) { Varint(ZigZag(value)); }
+
+            /// @brief Strings are written out the first time and by index afterwards.
+            void String(const std::string& value) {
+                auto [it, inserted] =
+                    m_strings.emplace(value, static_cast<uint32_t>(m_strings.size()));
+                Varint(it->second);
+                if (!inserted) { return; }
+                Varint(value.size());
+                m_out.insert(m_out.end(), value.begin(), value.end());
+            }
+
+            void operator()(EntityBits count) { Varint(count); }
+
+            void operator()(entt::entity entity) {
+                auto bits = static_cast<EntityBits>(entity);
+                Signed(static_cast<int64_t>(bits) - m_last_entity);
+                m_last_entity = bits;
+            }
+
+            void operator()(entt::entity entity, const Position& position) {
+                (*this)(entity);
+                Signed(position.pos.X() - m_last_position.X());
+                Signed(position.pos.Y() - m_last_position.Y());
+                m_last_position = position.pos;
+            }
+
+            void operator()(entt::entity entity, const FactionMember& member) {
+                (*this)(entity);
+                String(member.faction);
+            }
+
+            void operator()(entt::entity entity, const Actor& actor) {
+                (*this)(entity);
+                Signed(actor.speed);
+                Signed(actor.energy);
+            }
+
+            void operator()(entt::entity entity, const LightSource& light) {
+                (*this)(entity);
+                Varint(light.red);
+                Varint(light.green);
+                Varint(light.blue);
+                Signed(light.radius);
+            }
+        };
+
+        class SaveReader {
+        private:
+            const uint8_t* m_data;
+            size_t m_size;
+            size_t m_offset = 0;
+            bool m_failed = false;
+            EntityBits m_last_entity = 0;
+            Vec2 m_last_position{0, 0};
+            std::vector<std::string> m_strings;
+
+        public:
+            SaveReader(const uint8_t* data, size_t size)
+                : m_data(data)
+                , m_size(size) { }
+
+            [[nodiscard]] auto Failed() const -> bool { return m_failed; }
+
+            [[nodiscard]] auto AtEnd() const -> bool { return m_offset == m_size; }
+
+            [[nodiscard]] auto Offset() const -> size_t { return m_offset; }
+
+            auto Varint() -> uint64_t {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64 && !m_failed; shift += 7) {
+                    if (m_offset == m_size) { break; }
+                    auto byte = m_data[m_offset++];
+                    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0) { return value; }
+                }
+                m_failed = true;
+                return 0;
+            }
+
+            auto Signed() -> int64_t { return UnZigZag(Varint()); }
+
+            auto String() -> std::string {
+                auto index = Varint();
+                if (index < m_strings.size()) { return m_strings[index]; }
+
+                auto length = Varint();
+                if (m_failed || index != m_strings.size() || length > m_size - m_offset) {
+                    m_failed = true;
+                    return {};
+                }
+                auto begin = reinterpret_cast<const char*>(m_data + m_offset);
+                m_offset += length;
+                return m_strings.emplace_back(begin, length);
+            }
+
+            void operator()(EntityBits& count) {
+                auto value = Varint();
+                // Every record takes at least a byte, and there are only so many entities, so a
+                // larger count can only be corruption. The loader sizes its buffers from the
+                // count before reading a single record, so it has to be bounded here.
+                if (value > m_size - m_offset || value > MAX_SAVE_ENTITIES) { m_failed = true; }
+                count = m_failed ? 0 : static_cast<EntityBits>(value);
+            }
+
+            void operator()(entt::entity& entity) {
+                m_last_entity = static_cast<EntityBits>(m_last_entity + Signed());
+                entity = static_cast<entt::entity>(m_last_entity);
+            }
+
+            void operator()(entt::entity& entity, Position& position) {
+                (*this)(entity);
+                auto x = static_cast<int>(m_last_position.X() + Signed());
+                auto y = static_cast<int>(m_last_position.Y() + Signed());
+                m_last_position = Vec2{x, y};
+                position.pos = m_last_position;
+            }
+
+            void operator()(entt::entity& entity, FactionMember& member) {
+                (*this)(entity);
+                member.faction = String();
+            }
+
+            void operator()(entt::entity& entity, Actor& actor) {
+                (*this)(entity);
+                auto speed = Signed();
+                auto energy = Signed();
+                if (speed < 0 || speed > MAX_ACTOR_SPEED || energy < -MAX_ACTOR_ENERGY ||
+                    energy > MAX_ACTOR_ENERGY) {
+                    m_failed = true;
+                    return;
+                }
+                actor.speed = static_cast<int>(speed);
+                actor.energy = static_cast<int>(energy);
+            }
+
+            void operator()(entt::entity& entity, LightSource& light) {
+                (*this)(entity);
+                light.red = static_cast<uint8_t>(Varint());
+                light.green = static_cast<uint8_t>(Varint());
+                light.blue = static_cast<uint8_t>(Varint());
+                auto radius = Signed();
+                if (radius < 0 || radius > MAX_LIGHT_RADIUS) {
+                    m_failed = true;
+                    return;
+                }
+                light.radius = static_cast<int>(radius);
+            }
+        };
+
+        auto Milliseconds(std::chrono::steady_clock::duration duration) -> double {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+
+        auto Compress(const std::vector<uint8_t>& raw, std::vector<uint8_t>& out) -> bool {
+#ifdef RGLIKE_HAS_ZSTD
+            auto offset = out.size();
+            out.resize(offset + ZSTD_compressBound(raw.size()));
+            auto written = ZSTD_compress(
+                out.data() + offset, out.size() - offset, raw.data(), raw.size(), ZSTD_LEVEL
+            );
+            if (ZSTD_isError(written) != 0) {
+                out.resize(offset);
+                return false;
+            }
+            out.resize(offset + written);
+            return true;
+#else
+            (void)raw;
+            (void)out;
+            return false;
+#endif
+        }
+
+        /// @brief Decompresses a frame that should hold `raw_size` bytes into `raw`. The size is
+        /// only allocated for once the frame agrees with it.
+        auto Decompress(
+            const uint8_t* data, size_t size, uint64_t raw_size, std::vector<uint8_t>& raw
+        ) -> bool {
+#ifdef RGLIKE_HAS_ZSTD
+            if (raw_size > MAX_SAVE_BYTES || ZSTD_getFrameContentSize(data, size) != raw_size) {
+                return false;
+            }
+            raw.resize(raw_size);
+            auto read = ZSTD_decompress(raw.data(), raw.size(), data, size);
+            return ZSTD_isError(read) == 0 && read == raw.size();
+#else
+            (void)data;
+            (void)size;
+            (void)raw_size;
+            (void)raw;
+            return false;
+#endif
+        }
+
+        /// @brief Reads everything after the header out of an uncompressed payload.
+        auto ReadPayload(const uint8_t* raw, size_t size, entt::registry& registry)
+            -> std::optional<SaveState> {
+            SaveReader reader{raw, size};
+            SaveState state{};
+            state.seed = reader.Varint();
+            state.region = reader.String();
+            auto width = static_cast<int>(reader.Signed());
+            auto height = static_cast<int>(reader.Signed());
+            state.level_size = Vec2{width, height};
+            auto x = static_cast<int>(reader.Signed());
+            auto y = static_cast<int>(reader.Signed());
+            state.player = Vec2{x, y};
+            state.clock = reader.Varint();
+            state.turns_taken = reader.Varint();
+
+            entt::snapshot_loader loader{registry};
+            loader.entities(reader);
+            ArchiveComponents(loader, reader);
+            loader.orphans();
+            if (reader.Failed() || !reader.AtEnd()) {
+                registry.clear();
+                return std::nullopt;
+            }
+            state.entities = registry.alive();
+            return state;
+        }
+    } // namespace
+
+    void SnapshotTape::Clear() {
+        m_records.clear();
+        m_counts.clear();
+        m_entities.clear();
+        m_positions.clear();
+        m_factions.clear();
+        m_actors.clear();
+        m_lights.clear();
+    }
+
+    void SnapshotTape::ReserveLike(const SnapshotTape& other) {
+        m_records.reserve(other.m_records.size());
+        m_counts.reserve(other.m_counts.size());
+        m_entities.reserve(other.m_entities.size());
+        m_positions.reserve(other.m_positions.size());
+        m_factions.reserve(other.m_factions.size());
+        m_actors.reserve(other.m_actors.size());
+        m_lights.reserve(other.m_lights.size());
+    }
+
+    void SnapshotTape::operator()(std::underlying_type_t<entt::entity> count) {
+        m_records.push_back(Record::Count);
+        m_counts.push_back(count);
+    }
+
+    void SnapshotTape::operator()(entt::entity entity) {
+        m_records.push_back(Record::Entity);
+        m_entities.push_back(entity);
+    }
+
+    void SnapshotTape::operator()(entt::entity entity, const Position& position) {
+        m_records.push_back(Record::Position);
+        m_entities.push_back(entity);
+        m_positions.push_back(position);
+    }
+
+    void SnapshotTape::operator()(entt::entity entity, const FactionMember& member) {
+        m_records.push_back(Record::Faction);
+        m_entities.push_back(entity);
+        m_factions.push_back(member);
+    }
+
+    void SnapshotTape::operator()(entt::entity entity, const Actor& actor) {
+        m_records.push_back(Record::Actor);
+        m_entities.push_back(entity);
+        m_actors.push_back(actor);
+    }
+
+    void SnapshotTape::operator()(entt::entity entity, const LightSource& light) {
+        m_records.push_back(Record::Light);
+        m_entities.push_back(entity);
+        m_lights.push_back(light);
+    }
+
+    void CaptureRegistry(const entt::registry& registry, SnapshotTape& tape) {
+        tape.Clear();
+        entt::snapshot snapshot{registry};
+        snapshot.entities(tape);
+        ArchiveComponents(snapshot, tape);
+    }
+
+    auto EncodeSave(const SaveState& state, SaveCompression compression) -> std::vector<uint8_t> {
+        std::vector<uint8_t> raw{};
+        SaveWriter writer{raw};
+        writer.Varint(state.seed);
+        writer.String(state.region);
+        writer.Signed(state.level_size.X());
+        writer.Signed(state.level_size.Y());
+        writer.Signed(state.player.X());
+        writer.Signed(state.player.Y());
+        writer.Varint(state.clock);
+        writer.Varint(state.turns_taken);
+        state.registry.Replay(writer);
+
+        std::vector<uint8_t> out(SAVE_MAGIC.begin(), SAVE_MAGIC.end());
+        SaveWriter header{out};
+        header.Varint(SAVE_VERSION);
+        header.Varint(raw.size());
+
+        auto flag_offset = out.size();
+        out.push_back(static_cast<uint8_t>(SaveCompression::None));
+        if (compression == SaveCompression::Zstd) {
+            if (Compress(raw, out)) {
+                out[flag_offset] = static_cast<uint8_t>(SaveCompression::Zstd);
+                return out;
+            }
+            spdlog::warn("zstd is unavailable; writing the save uncompressed");
+        }
+        out.insert(out.end(), raw.begin(), raw.end());
+        return out;
+    }
+
+    auto DecodeSave(const std::vector<uint8_t>& bytes, entt::registry& registry)
+        -> std::optional<SaveState> {
+        if (bytes.size() < SAVE_MAGIC.size() ||
+            std::memcmp(bytes.data(), SAVE_MAGIC.data(), SAVE_MAGIC.size()) != 0) {
+            return std::nullopt;
+        }
+
+        SaveReader header{bytes.data() + SAVE_MAGIC.size(), bytes.size() - SAVE_MAGIC.size()};
+        auto version = header.Varint();
+        auto raw_size = header.Varint();
+        auto payload = SAVE_MAGIC.size() + header.Offset();
+        if (header.Failed() || version != SAVE_VERSION || payload >= bytes.size()) {
+            return std::nullopt;
+        }
+
+        auto compression = static_cast<SaveCompression>(bytes[payload++]);
+        std::vector<uint8_t> decompressed{};
+        const uint8_t* raw = bytes.data() + payload;
+        size_t size = bytes.size() - payload;
+        try {
+            if (compression == SaveCompression::Zstd) {
+                if (!Decompress(raw, size, raw_size, decompressed)) { return std::nullopt; }
+                raw = decompressed.data();
+                size = decompressed.size();
+            } else if (compression != SaveCompression::None || size != raw_size) {
+                return std::nullopt;
+            }
+            return ReadPayload(raw, size, registry);
+        } catch (const std::exception& e) {
+            // Whatever got past the checks above, e.g. an allocation too big for this machine.
+            spdlog::warn("Rejecting malformed save: {}", e.what());
+            registry.clear();
+            return std::nullopt;
+        }
+    }
+
+    auto WriteSaveFile(const std::string& path, const std::vector<uint8_t>& bytes) -> bool {
+        auto temporary = path + ".tmp";
+        {
+            std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+            file.write(
+                reinterpret_cast<const char*>(bytes.data()),
+                static_cast<std::streamsize>(bytes.size())
+            );
+            if (!file) { return false; }
+        }
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    auto ReadSaveFile(const std::string& path, std::vector<uint8_t>& bytes) -> bool {
+        std::ifstream file{path, std::ios::binary | std::ios::ate};
+        if (!file) { return false; }
+        bytes.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(
+            reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())
+        );
+        return static_cast<bool>(file);
+    }
+
+    Autosaver::Autosaver()
+        : m_worker(&Autosaver::WorkerLoop, this) { }
+
+    Autosaver::~Autosaver() {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        m_worker.join();
+    }
+
+    void Autosaver::Save(
+        std::string path, std::unique_ptr<SaveState> state, SaveCompression compression,
+        double capture_ms
+    ) {
+        {
+            std::lock_guard lock{m_mutex};
+            m_pending = Job{std::move(path), std::move(state), compression, capture_ms};
+        }
+        m_wake.notify_one();
+    }
+
+    void Autosaver::Wait() {
+        std::unique_lock lock{m_mutex};
+        m_idle.wait(lock, [&] { return !m_pending.has_value() && !m_busy; });
+    }
+
+    void Autosaver::WorkerLoop() {
+        while (true) {
+            Job job{};
+            {
+                std::unique_lock lock{m_mutex};
+                m_wake.wait(lock, [&] { return m_stopping || m_pending.has_value(); });
+                if (!m_pending.has_value()) { return; }
+                job = std::move(*m_pending);
+                m_pending.reset();
+                m_busy = true;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            auto bytes = EncodeSave(*job.state, job.compression);
+            auto encoded = std::chrono::steady_clock::now();
+            auto written = WriteSaveFile(job.path, bytes);
+            auto finished = std::chrono::steady_clock::now();
+
+            if (written) {
+                spdlog::info(
+                    "Autosaved {} entities to {}: {} bytes, captured in {:.2f} ms, encoded in "
+                    "{:.2f} ms, written in {:.2f} ms",
+                    job.state->entities, job.path, bytes.size(), job.capture_ms,
+                    Milliseconds(encoded - start), Milliseconds(finished - encoded)
+                );
+            } else {
+                spdlog::error("Autosave to {} failed", job.path);
+            }
+
+            std::lock_guard lock{m_mutex};
+            m_busy = false;
+            if (!m_pending.has_value()) { m_idle.notify_all(); }
+        }
+    }
+} // namespace rglike
@@ -0,0 +1,171 @@
+/**
+ * @file save_game.hpp
+ * @author Alic Szecsei
+ * @date 7/5/2023
+ */
+
+#pragma once
+
+#include "components.hpp"
+#include "math.hpp"
+
+#include "entt/entt.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace rglike {
+    enum class SaveCompression : uint8_t {
+        None,
+        /// @brief zstd, when the library was built with it; otherwise saves are left uncompressed.
+        Zstd,
+    };
+
+    /// @brief A plain in-memory copy of everything `entt::snapshot` hands its archive.
+    ///
+    /// Recording one is little more than a few vector appends, so the main thread can capture
+    /// the registry quickly and leave encoding to someone else. Replay() feeds the same calls,
+    /// in the same order, to another archive.
+    class SnapshotTape {
+    private:
+        enum class Record : uint8_t { Count, Entity, Position, Faction, Actor, Light };
+
+        std::vector<Record> m_records;
+        std::vector<uint32_t> m_counts;
+        std::vector<entt::entity> m_entities;
+        std::vector<Position> m_positions;
+        std::vector<FactionMember> m_factions;
+        std::vector<Actor> m_actors;
+        std::vector<LightSource> m_lights;
+
+    public:
+        void Clear();
+
+        /// @brief Reserves room for roughly the same amount of data as `other`.
+        void ReserveLike(const SnapshotTape& other);
+
+        void operator()(std::underlying_type_t<entt::entity> count);
+        void operator()(entt::entity entity);
+        void operator()(entt::entity entity, const Position& position);
+        void operator()(entt::entity entity, const FactionMember& member);
+        void operator()(entt::entity entity, const Actor& actor);
+        void operator()(entt::entity entity, const LightSource& light);
+
+        template<class Archive> void Replay(Archive& archive) const {
+            size_t count = 0;
+            size_t entity = 0;
+            size_t position = 0;
+            size_t faction = 0;
+            size_t actor = 0;
+            size_t light = 0;
+            for (auto record : m_records) {
+                switch (record) {
+                case Record::Count:
+                    archive(m_counts[count++]);
+                    break;
+                case Record::Entity:
+                    archive(m_entities[entity++]);
+                    break;
+                case Record::Position:
+                    archive(m_entities[entity++], m_positions[position++]);
+                    break;
+                case Record::Faction:
+                    archive(m_entities[entity++], m_factions[faction++]);
+                    break;
+                case Record::Actor:
+                    archive(m_entities[entity++], m_actors[actor++]);
+                    break;
+                case Record::Light:
+                    archive(m_entities[entity++], m_lights[light++]);
+                    break;
+                }
+            }
+        }
+    };
+
+    /// @brief Everything a save file holds.
+    struct SaveState {
+        /// @brief The level seed; levels are regenerated from it rather than stored.
+        uint64_t seed = 0;
+        /// @brief The region file of a streamed level, whose chunks are read back from it; empty
+        /// for levels generated whole.
+        std::string region;
+        /// @brief The level's size in tiles.
+        Vec2 level_size{0, 0};
+        Vec2 player{0, 0};
+        /// @brief The turn scheduler's clock, and how many turns actors had taken by then.
+        uint64_t clock = 0;
+        uint64_t turns_taken = 0;
+        size_t entities = 0;
+        SnapshotTape registry;
+    };
+
+    /// @brief Records `registry` into `tape` through `entt::snapshot`.
+    void CaptureRegistry(const entt::registry& registry, SnapshotTape& tape);
+
+    /// @brief Serializes a save: varints throughout, entities and positions delta-encoded
+    /// against the previous record, and faction names written once and then referred to by index.
+    [[nodiscard]] auto EncodeSave(const SaveState& state, SaveCompression compression)
+        -> std::vector<uint8_t>;
+
+    /// @brief Restores a save made by EncodeSave into `registry`, which must be empty.
+    /// @return The level and player position, or nothing if the data is malformed.
+    [[nodiscard]] auto DecodeSave(const std::vector<uint8_t>& bytes, entt::registry& registry)
+        -> std::optional<SaveState>;
+
+    /// @brief Writes `bytes` to a temporary file beside `path`, then renames it over `path`, so
+    /// a crash mid-save never leaves a torn file behind.
+    auto WriteSaveFile(const std::string& path, const std::vector<uint8_t>& bytes) -> bool;
+
+    auto ReadSaveFile(const std::string& path, std::vector<uint8_t>& bytes) -> bool;
+
+    /// @brief Encodes and writes saves on a background thread.
+    ///
+    /// Only the most recent request is kept; if saves are requested faster than they can be
+    /// written, the stale ones are skipped.
+    class Autosaver {
+    private:
+        struct Job {
+            std::string path;
+            std::unique_ptr<SaveState> state;
+            SaveCompression compression = SaveCompression::None;
+            double capture_ms = 0.0;
+        };
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_idle;
+        std::optional<Job> m_pending;
+        bool m_busy = false;
+        bool m_stopping = false;
+        std::thread m_worker;
+
+        void WorkerLoop();
+
+    public:
+        Autosaver();
+        ~Autosaver();
+
+        Autosaver(const Autosaver&) = delete;
+        auto operator=(const Autosaver&) -> Autosaver& = delete;
+        Autosaver(Autosaver&&) = delete;
+        auto operator=(Autosaver&&) -> Autosaver& = delete;
+
+        /// @brief Queues `state` to be saved to `path`. `capture_ms` is how long the caller spent
+        /// capturing it, for the log.
+        void Save(
+            std::string path, std::unique_ptr<SaveState> state, SaveCompression compression,
+            double capture_ms
+        );
+
+        /// @brief Blocks until every queued save has been written.
+        void Wait();
+    };
+} // namespace rglike
@@ -0,0 +1,121 @@
+/**
+ * @file simulation.cpp
+ * @author Alic Szecsei
+ * @date 7/10/2023
+ */
+
+#include "rglike/simulation.hpp"
+
+#include "components.hpp"
+#include "constants.hpp"
+#include "random.hpp"
+#include "replay.hpp"
+#include "world.hpp"
+
+#include <array>
+#include <chrono>
+
+namespace rglike {
+    namespace {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr std::array<const char*, 3> MONSTER_FACTIONS{"mindless", "townsfolk", "bandits"};
+        /// @brief Random tiles tried per monster before giving up on placing it.
+        constexpr int MAX_SPAWN_ATTEMPTS = 64;
+        /// @brief One monster in this many carries a torch.
+        constexpr size_t TORCH_BEARER_EVERY = 5;
+
+        auto Microseconds(Clock::duration duration) -> double {
+            return std::chrono::duration<double, std::micro>(duration).count();
+        }
+
+        /// @brief Scatters `count` monsters of assorted factions and speeds over passable tiles,
+        /// some of them carrying torches.
+        void SpawnMonsters(World& world, size_t count, Rng& rng) {
+            const auto& map = world.Map();
+            for (size_t i = 0; i < count; ++i) {
+                for (int attempt = 0; attempt < MAX_SPAWN_ATTEMPTS; ++attempt) {
+                    Vec2 pos{rng.Range(0, map.Width() - 1), rng.Range(0, map.Height() - 1)};
+                    if (!map.IsPassable(pos)) { continue; }
+
+                    auto entity = world.Registry.create();
+                    world.Registry.emplace<Position>(entity, pos);
+                    world.Registry.emplace<FactionMember>(
+                        entity, FactionMember{MONSTER_FACTIONS[i % MONSTER_FACTIONS.size()]}
+                    );
+                    world.Registry.emplace<Actor>(
+                        entity, Actor{rng.Range(NORMAL_SPEED / 2, NORMAL_SPEED * 2), 0}
+                    );
+                    if (i % TORCH_BEARER_EVERY == 0) {
+                        world.Registry.emplace<LightSource>(entity);
+                    }
+                    break;
+                }
+            }
+        }
+
+        /// @brief Steps the player in a random direction, trying the others if it is blocked.
+        void WanderPlayer(World& world, Rng& rng) {
+            const std::array<Vec2, 4> directions{
+                Vec2::Up(),
+                Vec2::Right(),
+                Vec2::Down(),
+                Vec2::Left(),
+            };
+            auto first = rng.Range(0, 3);
+            for (int i = 0; i < 4; ++i) {
+                if (world.MovePlayer(directions[(first + i) % 4])) { return; }
+            }
+        }
+    } // namespace
+
+    auto RunSimulation(const SimulationOptions& options) -> SimulationReport {
+        World world{};
+        world.Initialize(options.seed);
+        Rng rng{Mix(options.seed)};
+        SpawnMonsters(world, options.actors, rng);
+
+        SimulationReport report{};
+        report.systems.push_back(SystemTiming{"input"});
+        const auto& systems = world.Systems();
+        for (size_t i = 0; i < systems.Size(); ++i) {
+            report.systems.push_back(SystemTiming{systems.Name(i)});
+        }
+
+        auto start = Clock::now();
+        for (size_t turn = 0; turn < options.turns; ++turn) {
+            auto before_input = Clock::now();
+            WanderPlayer(world, rng);
+            report.systems[0].microseconds += Microseconds(Clock::now() - before_input);
+
+            world.Update();
+            for (size_t i = 0; i < systems.Size(); ++i) {
+                report.systems[i + 1].microseconds += Microseconds(systems.LastRun(i));
+            }
+        }
+        report.actor_turns = world.TurnsTaken();
+        report.turns = options.turns;
+        report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return report;
+    }
+
+    auto RunReplay(const std::string& path) -> std::optional<ReplayReport> {
+        auto replay = LoadReplay(path);
+        if (!replay) { return std::nullopt; }
+
+        World world{};
+        world.Initialize(replay->seed);
+
+        auto start = Clock::now();
+        PlayReplay(world, *replay);
+
+        ReplayReport report{};
+        report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        report.seed = replay->seed;
+        report.events = replay->events.size();
+        report.actor_turns = world.TurnsTaken();
+        report.expected_hash = replay->final_hash;
+        report.final_hash = world.StateHash();
+        return report;
+    }
+} // namespace rglike
@@ -0,0 +1,121 @@
+/**
+ * @file spatial_index.cpp
+ * @author Alic Szecsei
+ * @date 6/27/2023
+ */
+
+#include "spatial_index.hpp"
+
+namespace rglike {
+    void SpatialIndex::Connect(entt::registry& registry) {
+        registry.on_construct<Position>().connect<&SpatialIndex::OnConstruct>(*this);
+        registry.on_update<Position>().connect<&SpatialIndex::OnUpdate>(*this);
+        registry.on_destroy<Position>().connect<&SpatialIndex::OnDestroy>(*this);
+
+        for (auto [entity, position] : registry.view<Position>().each()) {
+            Insert(entity, position.pos);
+        }
+    }
+
+    void SpatialIndex::Disconnect(entt::registry& registry) {
+        registry.on_construct<Position>().disconnect<&SpatialIndex::OnConstruct>(*this);
+        registry.on_update<Position>().disconnect<&SpatialIndex::OnUpdate>(*this);
+        registry.on_destroy<Position>().disconnect<&SpatialIndex::OnDestroy>(*this);
+        Clear();
+    }
+
+    void SpatialIndex::OnConstruct(entt::registry& registry, entt::entity entity) {
+        Insert(entity, registry.get<Position>(entity).pos);
+    }
+
+    void SpatialIndex::OnUpdate(entt::registry& registry, entt::entity entity) {
+        Move(entity, registry.get<Position>(entity).pos);
+    }
+
+    void SpatialIndex::OnDestroy(entt::registry& /*registry*/, entt::entity entity) {
+        Remove(entity);
+    }
+
+    void SpatialIndex::Insert(entt::entity entity, Vec2 pos) {
+        auto id = static_cast<size_t>(entt::to_entity(entity));
+        if (id >= m_locators.size()) { m_locators.resize(id + 1); }
+        if (m_locators[id].slot != NONE) { Remove(entity); }
+
+        auto chunk = PackVec2(ChunkOf(pos));
+        auto& owned = m_buckets[chunk];
+        if (!owned) { owned = std::make_unique<Bucket>(); }
+        auto& bucket = *owned;
+
+        auto slot = static_cast<uint32_t>(bucket.entities.size());
+        auto& head = bucket.heads[TileOf(pos)];
+        bucket.entities.push_back(entity);
+        bucket.positions.push_back(pos);
+        bucket.prev.push_back(NONE);
+        bucket.next.push_back(head);
+        if (head != NONE) { bucket.prev[head] = slot; }
+        head = slot;
+
+        m_locators[id] = Locator{chunk, slot};
+        ++m_size;
+    }
+
+    void SpatialIndex::Move(entt::entity entity, Vec2 pos) {
+        auto id = static_cast<size_t>(entt::to_entity(entity));
+        if (id < m_locators.size() && m_locators[id].slot != NONE) {
+            const auto& loc = m_locators[id];
+            if (m_buckets.find(loc.chunk)->second->positions[loc.slot] == pos) { return; }
+        }
+        Insert(entity, pos);
+    }
+
+    void SpatialIndex::Remove(entt::entity entity) {
+        auto id = static_cast<size_t>(entt::to_entity(entity));
+        if (id >= m_locators.size() || m_locators[id].slot == NONE) { return; }
+
+        auto loc = m_locators[id];
+        m_locators[id].slot = NONE;
+        --m_size;
+
+        auto it = m_buckets.find(loc.chunk);
+        auto& bucket = *it->second;
+        auto slot = loc.slot;
+
+        // Unlink from the tile list.
+        if (bucket.prev[slot] != NONE) {
+            bucket.next[bucket.prev[slot]] = bucket.next[slot];
+        } else {
+            bucket.heads[TileOf(bucket.positions[slot])] = bucket.next[slot];
+        }
+        if (bucket.next[slot] != NONE) { bucket.prev[bucket.next[slot]] = bucket.prev[slot]; }
+
+        // Swap the last entry into the hole and repoint everything that referred to it.
+        auto last = static_cast<uint32_t>(bucket.entities.size() - 1);
+        if (slot != last) {
+            bucket.entities[slot] = bucket.entities[last];
+            bucket.positions[slot] = bucket.positions[last];
+            bucket.prev[slot] = bucket.prev[last];
+            bucket.next[slot] = bucket.next[last];
+
+            if (bucket.prev[slot] != NONE) {
+                bucket.next[bucket.prev[slot]] = slot;
+            } else {
+                bucket.heads[TileOf(bucket.positions[slot])] = slot;
+            }
+            if (bucket.next[slot] != NONE) { bucket.prev[bucket.next[slot]] = slot; }
+
+            m_locators[static_cast<size_t>(entt::to_entity(bucket.entities[slot]))].slot = slot;
+        }
+        bucket.entities.pop_back();
+        bucket.positions.pop_back();
+        bucket.prev.pop_back();
+        bucket.next.pop_back();
+
+        if (bucket.entities.empty()) { m_buckets.erase(it); }
+    }
+
+    void SpatialIndex::Clear() {
+        m_buckets.clear();
+        m_locators.clear();
+        m_size = 0;
+    }
+} // namespace rglike
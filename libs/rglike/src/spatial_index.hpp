@@ -0,0 +1,152 @@
+/**
+ * @file spatial_index.hpp
+ * @author Alic Szecsei
+ * @date 6/27/2023
+ */
+
+#pragma once
+
+#include "components.hpp"
+#include "math.hpp"
+#include "tile_map.hpp"
+
+#include "entt/entt.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rglike {
+    /// @brief Answers "what is at this tile?" for every entity with a Position.
+    ///
+    /// Entities are bucketed by CHUNK_SIZE square chunks, keyed by the packed chunk coordinate so
+    /// the index does not care how big the map is. Each bucket keeps a dense list of its entities
+    /// for whole-chunk queries, plus a per-tile linked list for point and partial-chunk queries.
+    /// Empty chunks are never visited, so queries cost time proportional to what they return
+    /// plus the chunks and tiles they cover.
+    ///
+    /// Connect() hooks the index up to a registry's Position signals; positions must then be
+    /// changed with `registry.patch` or `registry.replace` so the index hears about it.
+    class SpatialIndex {
+    private:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        struct Bucket {
+            std::vector<entt::entity> entities;
+            std::vector<Vec2> positions;
+            std::vector<uint32_t> prev;
+            std::vector<uint32_t> next;
+            std::array<uint32_t, CHUNK_AREA> heads;
+
+            Bucket() { heads.fill(NONE); }
+        };
+
+        struct Locator {
+            uint64_t chunk = 0;
+            uint32_t slot = NONE;
+        };
+
+        std::unordered_map<uint64_t, std::unique_ptr<Bucket>, Vec2KeyHash> m_buckets;
+        std::vector<Locator> m_locators;
+        size_t m_size = 0;
+
+        static inline auto ChunkOf(Vec2 pos) -> Vec2 {
+            return Vec2{pos.X() >> CHUNK_SHIFT, pos.Y() >> CHUNK_SHIFT};
+        }
+
+        static inline auto TileOf(Vec2 pos) -> int {
+            return TileChunk::Index(pos.X() & CHUNK_MASK, pos.Y() & CHUNK_MASK);
+        }
+
+        [[nodiscard]] inline auto FindBucket(Vec2 chunk) const -> const Bucket* {
+            auto it = m_buckets.find(PackVec2(chunk));
+            return it == m_buckets.end() ? nullptr : it->second.get();
+        }
+
+        void OnConstruct(entt::registry& registry, entt::entity entity);
+        void OnUpdate(entt::registry& registry, entt::entity entity);
+        void OnDestroy(entt::registry& registry, entt::entity entity);
+
+        /// @brief Calls fn for every entity in `bucket` within `area` (already clipped to the
+        /// bucket's chunk), choosing whichever of a tile walk or a list scan is cheaper.
+        template<class Filter, class Fn>
+        static void
+        VisitBucket(const Bucket& bucket, const Rect& area, Filter&& filter, Fn&& fn) {
+            auto tiles = static_cast<size_t>(area.Width()) * static_cast<size_t>(area.Height());
+            if (tiles == CHUNK_AREA || bucket.entities.size() < tiles) {
+                for (size_t i = 0; i < bucket.entities.size(); ++i) {
+                    const auto& pos = bucket.positions[i];
+                    if (area.Contains(pos) && filter(pos)) { fn(bucket.entities[i], pos); }
+                }
+                return;
+            }
+
+            for (int y = area.min.Y(); y < area.max.Y(); ++y) {
+                for (int x = area.min.X(); x < area.max.X(); ++x) {
+                    Vec2 pos{x, y};
+                    if (!filter(pos)) { continue; }
+                    for (auto slot = bucket.heads[TileOf(pos)]; slot != NONE;
+                         slot = bucket.next[slot]) {
+                        fn(bucket.entities[slot], pos);
+                    }
+                }
+            }
+        }
+
+        template<class Filter, class Fn>
+        void VisitArea(const Rect& area, Filter&& filter, Fn&& fn) const {
+            if (area.Empty() || m_size == 0) { return; }
+
+            auto first = ChunkOf(area.min);
+            auto last = ChunkOf(area.max - Vec2::One());
+            for (int cy = first.Y(); cy <= last.Y(); ++cy) {
+                for (int cx = first.X(); cx <= last.X(); ++cx) {
+                    const auto* bucket = FindBucket(Vec2{cx, cy});
+                    if (bucket == nullptr) { continue; }
+
+                    Vec2 origin{cx << CHUNK_SHIFT, cy << CHUNK_SHIFT};
+                    auto chunk_area = Rect{origin, origin + Vec2{CHUNK_SIZE, CHUNK_SIZE}};
+                    VisitBucket(*bucket, area.Intersect(chunk_area), filter, fn);
+                }
+            }
+        }
+
+    public:
+        /// @brief Indexes every existing Position in `registry` and follows its changes.
+        void Connect(entt::registry& registry);
+        void Disconnect(entt::registry& registry);
+
+        void Insert(entt::entity entity, Vec2 pos);
+        void Move(entt::entity entity, Vec2 pos);
+        void Remove(entt::entity entity);
+        void Clear();
+
+        [[nodiscard]] inline auto Size() const -> size_t { return m_size; }
+
+        /// @brief Calls `fn(entity, pos)` for every entity standing on `pos`.
+        template<class Fn> void QueryPoint(Vec2 pos, Fn&& fn) const {
+            const auto* bucket = FindBucket(ChunkOf(pos));
+            if (bucket == nullptr) { return; }
+            for (auto slot = bucket->heads[TileOf(pos)]; slot != NONE; slot = bucket->next[slot]) {
+                fn(bucket->entities[slot], pos);
+            }
+        }
+
+        /// @brief Calls `fn(entity, pos)` for every entity inside `area`.
+        template<class Fn> void QueryRect(const Rect& area, Fn&& fn) const {
+            VisitArea(area, [](Vec2) { return true; }, fn);
+        }
+
+        /// @brief Calls `fn(entity, pos)` for every entity within Euclidean distance `radius` of
+        /// `center`, as used by area-of-effect spells.
+        template<class Fn> void QueryRadius(Vec2 center, int radius, Fn&& fn) const {
+            const auto radius_sq = static_cast<double>(radius) * radius;
+            VisitArea(
+                Rect::Around(center, radius),
+                [&](Vec2 pos) { return (pos - center).LengthSquared() <= radius_sq; }, fn
+            );
+        }
+    };
+} // namespace rglike
@@ -0,0 +1,78 @@
+/**
+ * @file state_hash.cpp
+ * @author Alic Szecsei
+ * @date 7/12/2023
+ */
+
+#include "state_hash.hpp"
+
+#include "components.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace rglike {
+    namespace {
+        constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325;
+        constexpr uint64_t FNV_PRIME = 0x100000001b3;
+
+        class Hasher {
+        private:
+            uint64_t m_hash = FNV_OFFSET;
+
+        public:
+            void Add(uint64_t value) {
+                for (int byte = 0; byte < 8; ++byte) {
+                    m_hash = (m_hash ^ ((value >> (byte * 8)) & 0xFF)) * FNV_PRIME;
+                }
+            }
+
+            void Add(const std::string& value) {
+                Add(value.size());
+                for (auto c : value) { m_hash = (m_hash ^ static_cast<uint8_t>(c)) * FNV_PRIME; }
+            }
+
+            [[nodiscard]] auto Value() const -> uint64_t { return m_hash; }
+        };
+
+        /// @brief Hashes every `Component` in entity order, with `add(hasher, component)`
+        /// hashing its fields.
+        template<class Component, class Add>
+        void HashComponent(const entt::registry& registry, Hasher& hasher, Add&& add) {
+            std::vector<std::pair<entt::entity, const Component*>> sorted{};
+            for (auto entity : registry.view<Component>()) {
+                sorted.emplace_back(entity, &registry.get<Component>(entity));
+            }
+            std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            });
+
+            hasher.Add(sorted.size());
+            for (const auto& [entity, component] : sorted) {
+                hasher.Add(static_cast<uint64_t>(entt::to_integral(entity)));
+                add(hasher, *component);
+            }
+        }
+
+        auto Unsigned(int value) -> uint64_t {
+            return static_cast<uint64_t>(static_cast<int64_t>(value));
+        }
+    } // namespace
+
+    auto HashRegistry(const entt::registry& registry) -> uint64_t {
+        Hasher hasher{};
+        HashComponent<Position>(registry, hasher, [](Hasher& h, const Position& position) {
+            h.Add(Unsigned(position.pos.X()));
+            h.Add(Unsigned(position.pos.Y()));
+        });
+        HashComponent<FactionMember>(registry, hasher, [](Hasher& h, const FactionMember& member) {
+            h.Add(member.faction);
+        });
+        HashComponent<Actor>(registry, hasher, [](Hasher& h, const Actor& actor) {
+            h.Add(Unsigned(actor.speed));
+            h.Add(Unsigned(actor.energy));
+        });
+        return hasher.Value();
+    }
+} // namespace rglike
@@ -0,0 +1,17 @@
+/**
+ * @file state_hash.hpp
+ * @author Alic Szecsei
+ * @date 7/12/2023
+ */
+
+#pragma once
+
+#include "entt/entt.hpp"
+
+#include <cstdint>
+
+namespace rglike {
+    /// @brief A fingerprint of every entity's gameplay components, for checking that two runs
+    /// ended up in the same state. Independent of the order components are stored in.
+    [[nodiscard]] auto HashRegistry(const entt::registry& registry) -> uint64_t;
+} // namespace rglike
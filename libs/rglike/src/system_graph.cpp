@@ -0,0 +1,85 @@
+/**
+ * @file system_graph.cpp
+ * @author Alic Szecsei
+ * @date 7/12/2023
+ */
+
+#include "system_graph.hpp"
+
+#include <atomic>
+#include <memory>
+
+namespace rglike {
+    namespace {
+        auto Overlaps(const std::vector<std::type_index>& a, const std::vector<std::type_index>& b)
+            -> bool {
+            return std::any_of(a.begin(), a.end(), [&](const auto& type) {
+                return std::find(b.begin(), b.end(), type) != b.end();
+            });
+        }
+    } // namespace
+
+    auto SystemAccess::ConflictsWith(const SystemAccess& other) const -> bool {
+        return Overlaps(m_writes, other.m_writes) || Overlaps(m_writes, other.m_reads) ||
+               Overlaps(m_reads, other.m_writes);
+    }
+
+    void SystemGraph::Add(std::string name, SystemAccess access, SystemFn fn) {
+        auto index = m_systems.size();
+        System system{};
+        system.name = std::move(name);
+        system.access = std::move(access);
+        system.fn = std::move(fn);
+        for (size_t i = 0; i < index; ++i) {
+            if (m_systems[i].access.ConflictsWith(system.access)) {
+                m_systems[i].dependents.push_back(index);
+                ++system.dependencies;
+            }
+        }
+        m_systems.push_back(std::move(system));
+    }
+
+    void SystemGraph::Run(entt::registry& registry, ThreadPool& pool) {
+        if (pool.WorkerCount() == 1) {
+            RunSerial(registry, pool);
+            return;
+        }
+
+        // Create every pool up front; entt creates them lazily, which is not thread-safe.
+        for (const auto& system : m_systems) {
+            for (auto assure : system.access.m_storages) { assure(registry); }
+        }
+
+        auto waiting = std::make_unique<std::atomic<size_t>[]>(m_systems.size());
+        for (size_t i = 0; i < m_systems.size(); ++i) {
+            waiting[i].store(m_systems[i].dependencies, std::memory_order_relaxed);
+        }
+
+        ThreadPool::TaskGroup group{};
+        std::function<void(size_t)> launch = [&](size_t index) {
+            pool.Submit(group, [&, index](size_t) {
+                auto& system = m_systems[index];
+                auto start = std::chrono::steady_clock::now();
+                system.fn(registry, pool);
+                system.last_run = std::chrono::steady_clock::now() - start;
+                for (auto dependent : system.dependents) {
+                    if (waiting[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        launch(dependent);
+                    }
+                }
+            });
+        };
+        for (size_t i = 0; i < m_systems.size(); ++i) {
+            if (m_systems[i].dependencies == 0) { launch(i); }
+        }
+        pool.Wait(group);
+    }
+
+    void SystemGraph::RunSerial(entt::registry& registry, ThreadPool& pool) {
+        for (auto& system : m_systems) {
+            auto start = std::chrono::steady_clock::now();
+            system.fn(registry, pool);
+            system.last_run = std::chrono::steady_clock::now() - start;
+        }
+    }
+} // namespace rglike
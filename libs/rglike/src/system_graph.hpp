@@ -0,0 +1,132 @@
+/**
+ * @file system_graph.hpp
+ * @author Alic Szecsei
+ * @date 7/12/2023
+ */
+
+#pragma once
+
+#include "thread_pool.hpp"
+
+#include "entt/entt.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+namespace rglike {
+    /// @brief What a system reads and writes: registry components, plus any other shared state
+    /// ("resources", such as the tile map) it touches.
+    class SystemAccess {
+    private:
+        std::vector<std::type_index> m_reads;
+        std::vector<std::type_index> m_writes;
+        std::vector<void (*)(entt::registry&)> m_storages;
+
+        template<class T> static void AssureStorage(entt::registry& registry) {
+            static_cast<void>(registry.storage<T>());
+        }
+
+        friend class SystemGraph;
+
+    public:
+        template<class... Components> auto Read() -> SystemAccess& {
+            (m_reads.emplace_back(typeid(Components)), ...);
+            (m_storages.push_back(&AssureStorage<Components>), ...);
+            return *this;
+        }
+
+        template<class... Components> auto Write() -> SystemAccess& {
+            (m_writes.emplace_back(typeid(Components)), ...);
+            (m_storages.push_back(&AssureStorage<Components>), ...);
+            return *this;
+        }
+
+        template<class... Resources> auto ReadResource() -> SystemAccess& {
+            (m_reads.emplace_back(typeid(Resources)), ...);
+            return *this;
+        }
+
+        template<class... Resources> auto WriteResource() -> SystemAccess& {
+            (m_writes.emplace_back(typeid(Resources)), ...);
+            return *this;
+        }
+
+        /// @brief Whether the two can't safely run at the same time.
+        [[nodiscard]] auto ConflictsWith(const SystemAccess& other) const -> bool;
+    };
+
+    /// @brief Runs a set of systems, concurrently wherever their accesses allow.
+    ///
+    /// Systems are given in the order they would run single-threaded. A system waits for every
+    /// earlier system it conflicts with, one of them writing what the other reads or writes; the
+    /// rest may run in parallel. Since conflicting systems always run in registration order, the
+    /// results match a serial run as long as systems stick to their declared access.
+    ///
+    /// Systems must not create or destroy entities, or add or remove components, while the graph
+    /// runs; the registry is not safe for that across threads.
+    class SystemGraph {
+    public:
+        using SystemFn = std::function<void(entt::registry&, ThreadPool&)>;
+
+    private:
+        struct System {
+            std::string name;
+            SystemAccess access;
+            SystemFn fn;
+            std::vector<size_t> dependents;
+            size_t dependencies = 0;
+            std::chrono::steady_clock::duration last_run{};
+        };
+
+        std::vector<System> m_systems;
+
+    public:
+        /// @brief Adds a system to run after every system added so far that it conflicts with.
+        void Add(std::string name, SystemAccess access, SystemFn fn);
+
+        /// @brief Runs every system once, on `pool`.
+        void Run(entt::registry& registry, ThreadPool& pool);
+
+        /// @brief Runs every system once, one at a time in registration order.
+        void RunSerial(entt::registry& registry, ThreadPool& pool);
+
+        [[nodiscard]] inline auto Size() const -> size_t { return m_systems.size(); }
+
+        [[nodiscard]] inline auto Name(size_t system) const -> const std::string& {
+            return m_systems[system].name;
+        }
+
+        /// @brief How long `system` took the last time the graph ran.
+        [[nodiscard]] inline auto LastRun(size_t system) const
+            -> std::chrono::steady_clock::duration {
+            return m_systems[system].last_run;
+        }
+
+        /// @brief How many earlier systems `system` waits on.
+        [[nodiscard]] inline auto Dependencies(size_t system) const -> size_t {
+            return m_systems[system].dependencies;
+        }
+    };
+
+    /// @brief Calls `fn(entity, components&...)` for every entity with all of `Components`,
+    /// split into ranges of `grain` entities across `pool`.
+    ///
+    /// `fn` may run concurrently for different entities, so it should only touch the entity it
+    /// is given.
+    template<class... Components, class Fn>
+    void ParallelEach(entt::registry& registry, ThreadPool& pool, size_t grain, Fn&& fn) {
+        auto view = registry.view<Components...>();
+        const auto& leader = view.handle();
+        const auto* entities = leader.data();
+        pool.ParallelFor(leader.size(), grain, [&](size_t begin, size_t end, size_t) {
+            for (auto i = begin; i < end; ++i) {
+                auto entity = entities[i];
+                if (view.contains(entity)) { fn(entity, view.template get<Components>(entity)...); }
+            }
+        });
+    }
+} // namespace rglike
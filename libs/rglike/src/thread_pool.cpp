@@ -0,0 +1,179 @@
+/**
+ * @file thread_pool.cpp
+ * @author Alic Szecsei
+ * @date 6/20/2023
+ */
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace rglike {
+    namespace {
+        thread_local const ThreadPool* t_pool = nullptr;
+        thread_local size_t t_worker = 0;
+    } // namespace
+
+    ThreadPool::ThreadPool(size_t threads) {
+        m_queues.reserve(threads + 1);
+        for (size_t i = 0; i <= threads; ++i) { m_queues.push_back(std::make_unique<WorkQueue>()); }
+
+        m_threads.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            m_threads.emplace_back([this, i] { WorkerLoop(i + 1); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads) { thread.join(); }
+    }
+
+    auto ThreadPool::DefaultThreadCount() -> size_t {
+        auto hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 0;
+    }
+
+    auto ThreadPool::CurrentWorker() const -> size_t { return t_pool == this ? t_worker : 0; }
+
+    void ThreadPool::WorkerLoop(size_t worker) {
+        t_pool = this;
+        t_worker = worker;
+        while (true) {
+            QueuedTask task{};
+            if (TryPop(worker, task)) {
+                Execute(task, worker);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_queued > 0; });
+            if (m_stopping) { return; }
+        }
+    }
+
+    auto ThreadPool::TryPop(size_t worker, QueuedTask& task) -> bool {
+        // Our own queue newest-first, since its tasks are likely still warm in cache; everyone
+        // else's oldest-first, since those tend to be the biggest pieces of work.
+        bool found = false;
+        for (size_t i = 0; i < m_queues.size() && !found; ++i) {
+            auto& queue = *m_queues[(worker + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) { continue; }
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            found = true;
+        }
+        if (!found) { return false; }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_queued;
+        return true;
+    }
+
+    void ThreadPool::Execute(QueuedTask& task, size_t worker) {
+        // The group has to hear that the task finished however it finished, or Wait never
+        // returns. The exception goes to whoever waits on the group instead.
+        try {
+            task.fn(worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(task.group->m_error_mutex);
+            if (task.group->m_error == nullptr) { task.group->m_error = std::current_exception(); }
+        }
+        if (task.group->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Taking the lock orders this against a waiter checking the count before sleeping.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_wake.notify_all();
+        }
+    }
+
+    void ThreadPool::Submit(TaskGroup& group, Task task) {
+        group.m_remaining.fetch_add(1, std::memory_order_relaxed);
+        // Counted before it's published, so a thief can never take the count below zero.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_queued;
+        }
+        {
+            auto& queue = *m_queues[CurrentWorker()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(QueuedTask{std::move(task), &group});
+        }
+        m_wake.notify_one();
+    }
+
+    void ThreadPool::Wait(TaskGroup& group) {
+        auto worker = CurrentWorker();
+        while (group.m_remaining.load(std::memory_order_acquire) != 0) {
+            QueuedTask task{};
+            if (TryPop(worker, task)) {
+                Execute(task, worker);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] {
+                return m_queued > 0 || group.m_remaining.load(std::memory_order_acquire) == 0;
+            });
+        }
+
+        std::exception_ptr error{};
+        {
+            std::lock_guard<std::mutex> lock(group.m_error_mutex);
+            error = std::exchange(group.m_error, nullptr);
+        }
+        if (error != nullptr) { std::rethrow_exception(error); }
+    }
+
+    void ThreadPool::ParallelFor(
+        size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)>& fn
+    ) {
+        if (count == 0) { return; }
+        grain = std::max<size_t>(grain, 1);
+
+        auto worker = CurrentWorker();
+        size_t chunks = (count + grain - 1) / grain;
+        if (m_threads.empty() || chunks == 1) {
+            for (size_t begin = 0; begin < count; begin += grain) {
+                fn(begin, std::min(count, begin + grain), worker);
+            }
+            return;
+        }
+
+        // Ranges are pulled off a shared counter until it runs dry, by the caller and by as many
+        // helper tasks as could usefully join in.
+        std::atomic<size_t> next{0};
+        auto drain = [&](size_t drainer) {
+            while (true) {
+                size_t begin = next.fetch_add(grain);
+                if (begin >= count) { return; }
+                fn(begin, std::min(count, begin + grain), drainer);
+            }
+        };
+
+        TaskGroup group{};
+        auto helpers = std::min(chunks - 1, m_threads.size());
+        for (size_t i = 0; i < helpers; ++i) { Submit(group, drain); }
+        std::exception_ptr error{};
+        try {
+            drain(worker);
+        } catch (...) {
+            // Stop handing out ranges, but the helpers still point into this frame, so they must
+            // finish before it unwinds.
+            next.store(count);
+            error = std::current_exception();
+        }
+        Wait(group);
+        if (error != nullptr) { std::rethrow_exception(error); }
+    }
+} // namespace rglike
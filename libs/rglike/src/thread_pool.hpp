@@ -0,0 +1,111 @@
+/**
+ * @file thread_pool.hpp
+ * @author Alic Szecsei
+ * @date 6/20/2023
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rglike {
+    /// @brief A fixed set of worker threads that share work by stealing it from each other.
+    ///
+    /// Every worker has its own queue. Tasks are pushed onto the queue of whoever submits them
+    /// and popped from the back by their owner, while idle workers steal from the front of other
+    /// queues. Threads waiting on a TaskGroup run queued tasks in the meantime, so tasks may
+    /// submit and wait on further tasks without deadlocking the pool.
+    ///
+    /// The calling thread always takes part in the work as worker 0, so a pool with zero threads
+    /// simply runs everything inline.
+    ///
+    /// A task that throws still counts as finished. The first exception thrown by a group's tasks
+    /// is rethrown by Wait() once the rest of the group is done.
+    class ThreadPool {
+    public:
+        /// @brief Called with the index of the worker running it.
+        using Task = std::function<void(size_t)>;
+
+        /// @brief A batch of submitted tasks that can be waited on together.
+        class TaskGroup {
+        private:
+            std::atomic<size_t> m_remaining{0};
+            std::mutex m_error_mutex;
+            /// @brief The first exception a task threw, if any. Guarded by m_error_mutex.
+            std::exception_ptr m_error;
+
+            friend class ThreadPool;
+        };
+
+    private:
+        struct QueuedTask {
+            Task fn;
+            TaskGroup* group = nullptr;
+        };
+
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<QueuedTask> tasks;
+        };
+
+        std::vector<std::thread> m_threads;
+        std::vector<std::unique_ptr<WorkQueue>> m_queues;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        /// @brief Tasks sitting in any queue. Guarded by m_mutex.
+        size_t m_queued = 0;
+        bool m_stopping = false;
+
+        void WorkerLoop(size_t worker);
+
+        /// @brief Takes a task from `worker`'s own queue, or failing that steals one.
+        auto TryPop(size_t worker, QueuedTask& task) -> bool;
+
+        void Execute(QueuedTask& task, size_t worker);
+
+    public:
+        /// @brief Starts `threads` background workers. Defaults to one less than the number of
+        /// hardware threads, leaving room for the calling thread.
+        explicit ThreadPool(size_t threads = DefaultThreadCount());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+        ThreadPool(ThreadPool&&) = delete;
+        auto operator=(ThreadPool&&) -> ThreadPool& = delete;
+
+        static auto DefaultThreadCount() -> size_t;
+
+        /// @brief The number of distinct `worker` indices a job may be called with.
+        [[nodiscard]] inline auto WorkerCount() const -> size_t { return m_threads.size() + 1; }
+
+        /// @brief The worker index of the calling thread: its own on pool threads, 0 elsewhere.
+        [[nodiscard]] auto CurrentWorker() const -> size_t;
+
+        /// @brief Queues `task` as part of `group`.
+        void Submit(TaskGroup& group, Task task);
+
+        /// @brief Runs queued tasks until every task in `group` has finished, then rethrows the
+        /// first exception any of them threw.
+        void Wait(TaskGroup& group);
+
+        /// @brief Calls `fn(begin, end, worker)` over consecutive ranges of [0, count), each at
+        /// most `grain` long, spread across all workers. Blocks until every range is done, even if
+        /// one throws, and then rethrows.
+        ///
+        /// May be called from inside a task. `worker` identifies the thread running the range,
+        /// so per-worker scratch space is safe to use, but not across a nested ParallelFor.
+        void ParallelFor(
+            size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)>& fn
+        );
+    };
+} // namespace rglike
@@ -0,0 +1,253 @@
+/**
+ * @file tile_map.cpp
+ * @author Alic Szecsei
+ * @date 6/12/2023
+ */
+
+#include "tile_map.hpp"
+
+#include <algorithm>
+
+namespace rglike {
+    void TileChunk::Fill(const Tile& tile) {
+        glyphs.fill(tile.glyph);
+        fg.fill(tile.fg);
+        bg.fill(tile.bg);
+        passable.fill(tile.passable ? ~ChunkRowBits{0} : ChunkRowBits{0});
+        opaque.fill(tile.opaque ? ~ChunkRowBits{0} : ChunkRowBits{0});
+        cost.fill(tile.cost);
+    }
+
+    TileMap::TileMap(int width, int height, const Tile& fill) { Resize(width, height, fill); }
+
+    TileMap::TileMap(const TileMap& other) { *this = other; }
+
+    auto TileMap::operator=(const TileMap& other) -> TileMap& {
+        if (this == &other) { return *this; }
+
+        m_width = other.m_width;
+        m_height = other.m_height;
+        m_chunks_wide = other.m_chunks_wide;
+        m_chunks_high = other.m_chunks_high;
+        m_revision = other.m_revision + 1;
+        m_residency_revision = other.m_residency_revision;
+        m_residency_log = other.m_residency_log;
+        m_weighted_tiles = other.m_weighted_tiles;
+        m_resident_chunks = other.m_resident_chunks;
+        m_chunks.clear();
+        m_chunks.reserve(other.m_chunks.size());
+        for (const auto& chunk : other.m_chunks) {
+            m_chunks.push_back(chunk != nullptr ? std::make_unique<TileChunk>(*chunk) : nullptr);
+        }
+        return *this;
+    }
+
+    auto TileMap::SolidChunk() -> const TileChunk& {
+        static const TileChunk solid = [] {
+            TileChunk chunk{};
+            chunk.Fill(Tile{});
+            chunk.cost.fill(0);
+            return chunk;
+        }();
+        return solid;
+    }
+
+    void TileMap::Resize(int width, int height, const Tile& fill) {
+        ResizeUnloaded(width, height);
+
+        for (auto& chunk : m_chunks) {
+            chunk = std::make_unique<TileChunk>();
+            chunk->Fill(fill);
+        }
+        m_resident_chunks = m_chunks.size();
+        m_weighted_tiles = fill.cost != 1 ? static_cast<size_t>(m_width) * m_height : 0;
+    }
+
+    void TileMap::ResizeUnloaded(int width, int height) {
+        m_width = std::max(0, width);
+        m_height = std::max(0, height);
+        m_chunks_wide = (m_width + CHUNK_MASK) >> CHUNK_SHIFT;
+        m_chunks_high = (m_height + CHUNK_MASK) >> CHUNK_SHIFT;
+        ++m_revision;
+
+        m_chunks.clear();
+        m_chunks.resize(static_cast<size_t>(m_chunks_wide) * m_chunks_high);
+        m_resident_chunks = 0;
+        m_weighted_tiles = 0;
+    }
+
+    auto TileMap::CountWeighted(int chunk_x, int chunk_y, const TileChunk& chunk) const -> size_t {
+        int width = std::min(CHUNK_SIZE, m_width - (chunk_x << CHUNK_SHIFT));
+        int height = std::min(CHUNK_SIZE, m_height - (chunk_y << CHUNK_SHIFT));
+        size_t count = 0;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                count += chunk.cost[TileChunk::Index(x, y)] != 1 ? 1 : 0;
+            }
+        }
+        return count;
+    }
+
+    void TileMap::Invalidate() {
+        ++m_revision;
+
+        m_weighted_tiles = 0;
+        for (int chunk_y = 0; chunk_y < m_chunks_high; ++chunk_y) {
+            for (int chunk_x = 0; chunk_x < m_chunks_wide; ++chunk_x) {
+                const auto& chunk = m_chunks[ChunkSlot(chunk_x, chunk_y)];
+                if (chunk != nullptr) {
+                    m_weighted_tiles += CountWeighted(chunk_x, chunk_y, *chunk);
+                }
+            }
+        }
+    }
+
+    void TileMap::LogResidency(int chunk_x, int chunk_y) {
+        ++m_residency_revision;
+        auto min = Vec2{chunk_x << CHUNK_SHIFT, chunk_y << CHUNK_SHIFT};
+        m_residency_log[m_residency_revision % RESIDENCY_LOG_SIZE] =
+            Rect{min, min + Vec2{CHUNK_SIZE, CHUNK_SIZE}}.Intersect(
+                Rect{Vec2::Zero(), Vec2{m_width, m_height}}
+            );
+    }
+
+    auto TileMap::ResidencyChangesSince(uint64_t since, std::vector<Rect>& areas) const -> bool {
+        if (since > m_residency_revision || m_residency_revision - since > RESIDENCY_LOG_SIZE) {
+            return false;
+        }
+        for (auto revision = since + 1; revision <= m_residency_revision; ++revision) {
+            areas.push_back(m_residency_log[revision % RESIDENCY_LOG_SIZE]);
+        }
+        return true;
+    }
+
+    auto TileMap::ResidencyChangedIn(uint64_t since, const Rect& area) const -> bool {
+        if (since == m_residency_revision) { return false; }
+        if (since > m_residency_revision || m_residency_revision - since > RESIDENCY_LOG_SIZE) {
+            return true;
+        }
+        for (auto revision = since + 1; revision <= m_residency_revision; ++revision) {
+            if (!m_residency_log[revision % RESIDENCY_LOG_SIZE].Intersect(area).Empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto TileMap::ReleaseChunk(int chunk_x, int chunk_y) -> std::unique_ptr<TileChunk> {
+        auto chunk = std::move(m_chunks[ChunkSlot(chunk_x, chunk_y)]);
+        if (chunk != nullptr) {
+            LogResidency(chunk_x, chunk_y);
+            --m_resident_chunks;
+            m_weighted_tiles -= CountWeighted(chunk_x, chunk_y, *chunk);
+        }
+        return chunk;
+    }
+
+    void TileMap::InstallChunk(int chunk_x, int chunk_y, std::unique_ptr<TileChunk> chunk) {
+        ReleaseChunk(chunk_x, chunk_y);
+        if (chunk == nullptr) { return; }
+
+        LogResidency(chunk_x, chunk_y);
+        ++m_resident_chunks;
+        m_weighted_tiles += CountWeighted(chunk_x, chunk_y, *chunk);
+        m_chunks[ChunkSlot(chunk_x, chunk_y)] = std::move(chunk);
+    }
+
+    auto TileMap::Get(Vec2 pos) const -> Tile {
+        if (!InBounds(pos)) { return Tile{}; }
+
+        const auto& chunk = ChunkAt(pos);
+        auto idx = LocalIndex(pos);
+        auto row = pos.Y() & CHUNK_MASK;
+        return Tile{
+            chunk.glyphs[idx],
+            chunk.fg[idx],
+            chunk.bg[idx],
+            (chunk.passable[row] & RowBit(pos)) != 0,
+            (chunk.opaque[row] & RowBit(pos)) != 0,
+            chunk.cost[idx],
+        };
+    }
+
+    void TileMap::Set(Vec2 pos, const Tile& tile) {
+        auto* chunk = WritableChunkAt(pos);
+        if (chunk == nullptr) { return; }
+
+        auto idx = LocalIndex(pos);
+        ++m_revision;
+        chunk->glyphs[idx] = tile.glyph;
+        chunk->fg[idx] = tile.fg;
+        chunk->bg[idx] = tile.bg;
+        SetPassable(pos, tile.passable);
+        SetOpaque(pos, tile.opaque);
+        SetMoveCost(pos, tile.cost);
+    }
+
+    void TileMap::SetGlyph(Vec2 pos, char32_t glyph) {
+        auto* chunk = WritableChunkAt(pos);
+        if (chunk == nullptr) { return; }
+        ++m_revision;
+        chunk->glyphs[LocalIndex(pos)] = glyph;
+    }
+
+    void TileMap::SetColors(Vec2 pos, ftxui::Color fg, ftxui::Color bg) {
+        auto* chunk = WritableChunkAt(pos);
+        if (chunk == nullptr) { return; }
+
+        auto idx = LocalIndex(pos);
+        ++m_revision;
+        chunk->fg[idx] = fg;
+        chunk->bg[idx] = bg;
+    }
+
+    void TileMap::SetPassable(Vec2 pos, bool passable) {
+        auto* chunk = WritableChunkAt(pos);
+        if (chunk == nullptr) { return; }
+
+        ++m_revision;
+        auto& row = chunk->passable[pos.Y() & CHUNK_MASK];
+        row = passable ? (row | RowBit(pos)) : (row & ~RowBit(pos));
+    }
+
+    void TileMap::SetOpaque(Vec2 pos, bool opaque) {
+        auto* chunk = WritableChunkAt(pos);
+        if (chunk == nullptr) { return; }
+
+        ++m_revision;
+        auto& row = chunk->opaque[pos.Y() & CHUNK_MASK];
+        row = opaque ? (row | RowBit(pos)) : (row & ~RowBit(pos));
+    }
+
+    void TileMap::SetMoveCost(Vec2 pos, uint8_t cost) {
+        auto* chunk = WritableChunkAt(pos);
+        if (chunk == nullptr) { return; }
+
+        ++m_revision;
+        auto& slot = chunk->cost[LocalIndex(pos)];
+        if (slot != 1 && cost == 1) { --m_weighted_tiles; }
+        if (slot == 1 && cost != 1) { ++m_weighted_tiles; }
+        slot = cost;
+    }
+
+    auto GlyphToString(char32_t glyph) -> std::string {
+        std::string out{};
+        auto cp = static_cast<uint32_t>(glyph);
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        return out;
+    }
+} // namespace rglike
@@ -0,0 +1,269 @@
+/**
+ * @file tile_map.hpp
+ * @author Alic Szecsei
+ * @date 6/12/2023
+ */
+
+#pragma once
+
+#include "math.hpp"
+
+#include <array>
+#include <cstdint>
+#include <ftxui/screen/color.hpp>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace rglike {
+    /// @brief log2 of the side length of a chunk, in tiles.
+    constexpr int CHUNK_SHIFT = 5;
+    /// @brief Side length of a chunk, in tiles.
+    constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    /// @brief Mask extracting the chunk-local part of a tile coordinate.
+    constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+    /// @brief Number of tiles in a single chunk.
+    constexpr int CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+
+    /// @brief The eight king's-move offsets; orthogonal directions first.
+    constexpr std::array<Vec2, 8> NEIGHBOR_OFFSETS{
+        Vec2{1, 0},
+        Vec2{-1, 0},
+        Vec2{0, 1},
+        Vec2{0, -1},
+        Vec2{1, 1},
+        Vec2{-1, 1},
+        Vec2{1, -1},
+        Vec2{-1, -1},
+    };
+
+    /// @brief One bit per tile in a chunk row.
+    using ChunkRowBits = uint32_t;
+    static_assert(sizeof(ChunkRowBits) * 8 == CHUNK_SIZE, "Chunk rows must fit in one word");
+
+    /// @brief A value-type description of a single tile, used for reads and writes that touch
+    /// every layer at once. Hot paths should prefer the per-layer accessors on TileMap.
+    struct Tile {
+        char32_t glyph = U' ';
+        ftxui::Color fg = ftxui::Color::Default;
+        ftxui::Color bg = ftxui::Color::Default;
+        bool passable = false;
+        bool opaque = true;
+        /// @brief Relative cost of stepping onto this tile; 1 is ordinary ground.
+        uint8_t cost = 1;
+    };
+
+    /// @brief A fixed-size square of tiles, stored structure-of-arrays so that each layer is
+    /// dense and can be scanned without dragging the others through the cache.
+    struct TileChunk {
+        std::array<char32_t, CHUNK_AREA> glyphs{};
+        std::array<ftxui::Color, CHUNK_AREA> fg{};
+        std::array<ftxui::Color, CHUNK_AREA> bg{};
+        /// @brief Passability, one word per row, bit `x` set when tile `x` can be walked on.
+        std::array<ChunkRowBits, CHUNK_SIZE> passable{};
+        /// @brief Opacity, one word per row, bit `x` set when tile `x` blocks sight.
+        std::array<ChunkRowBits, CHUNK_SIZE> opaque{};
+        std::array<uint8_t, CHUNK_AREA> cost{};
+
+        static constexpr auto Index(int local_x, int local_y) -> int {
+            return (local_y << CHUNK_SHIFT) | local_x;
+        }
+
+        void Fill(const Tile& tile);
+    };
+
+    static_assert(
+        std::is_trivially_copyable_v<TileChunk>, "Chunks are copied to and from disk as raw bytes"
+    );
+
+    /// @brief A rectangular map of tiles addressed by Vec2, split into CHUNK_SIZE chunks.
+    ///
+    /// Every accessor is O(1): a shift and a mask select the chunk and the tile inside it.
+    /// Out-of-bounds reads return the same values as a solid wall, and so do reads from chunks
+    /// that are not resident (see ReleaseChunk). Writes to either are ignored.
+    class TileMap {
+    private:
+        /// @brief How many chunk installs and releases ResidencyChangedSince can look back over.
+        static constexpr size_t RESIDENCY_LOG_SIZE = 64;
+
+        int m_width = 0;
+        int m_height = 0;
+        int m_chunks_wide = 0;
+        int m_chunks_high = 0;
+        uint64_t m_revision = 0;
+        uint64_t m_residency_revision = 0;
+        /// @brief The tiles of each recent install or release, by residency revision.
+        std::array<Rect, RESIDENCY_LOG_SIZE> m_residency_log{};
+        size_t m_weighted_tiles = 0;
+        size_t m_resident_chunks = 0;
+        std::vector<std::unique_ptr<TileChunk>> m_chunks;
+
+        /// @brief What non-resident chunks read as.
+        static auto SolidChunk() -> const TileChunk&;
+
+        [[nodiscard]] inline auto ChunkSlot(int chunk_x, int chunk_y) const -> size_t {
+            return static_cast<size_t>(chunk_y) * m_chunks_wide + chunk_x;
+        }
+
+        [[nodiscard]] inline auto ChunkIndex(Vec2 pos) const -> size_t {
+            return ChunkSlot(pos.X() >> CHUNK_SHIFT, pos.Y() >> CHUNK_SHIFT);
+        }
+
+        /// @brief The chunk holding `pos`, or null if it is out of bounds or not resident.
+        [[nodiscard]] inline auto WritableChunkAt(Vec2 pos) -> TileChunk* {
+            return InBounds(pos) ? m_chunks[ChunkIndex(pos)].get() : nullptr;
+        }
+
+        [[nodiscard]] inline auto ChunkAt(Vec2 pos) const -> const TileChunk& {
+            const auto* chunk = m_chunks[ChunkIndex(pos)].get();
+            return chunk != nullptr ? *chunk : SolidChunk();
+        }
+
+        /// @brief Tiles in chunk (`chunk_x`, `chunk_y`) that lie inside the map and do not
+        /// cost 1 to enter.
+        [[nodiscard]] auto CountWeighted(int chunk_x, int chunk_y, const TileChunk& chunk) const
+            -> size_t;
+
+        /// @brief Records that chunk (`chunk_x`, `chunk_y`) came or went.
+        void LogResidency(int chunk_x, int chunk_y);
+
+        static inline auto LocalIndex(Vec2 pos) -> int {
+            return TileChunk::Index(pos.X() & CHUNK_MASK, pos.Y() & CHUNK_MASK);
+        }
+
+        static inline auto RowBit(Vec2 pos) -> ChunkRowBits {
+            return ChunkRowBits{1} << (pos.X() & CHUNK_MASK);
+        }
+
+    public:
+        TileMap() = default;
+        TileMap(int width, int height, const Tile& fill = Tile{});
+        TileMap(const TileMap& other);
+        TileMap(TileMap&& other) noexcept = default;
+        auto operator=(const TileMap& other) -> TileMap&;
+        auto operator=(TileMap&& other) noexcept -> TileMap& = default;
+        ~TileMap() = default;
+
+        /// @brief Discards the current contents and resizes the map, filling it with `fill`.
+        void Resize(int width, int height, const Tile& fill = Tile{});
+
+        /// @brief Discards the current contents and resizes the map without loading any chunks,
+        /// for maps too big to hold in memory at once. Chunks are brought in with InstallChunk.
+        void ResizeUnloaded(int width, int height);
+
+        [[nodiscard]] inline auto Width() const -> int { return m_width; }
+
+        [[nodiscard]] inline auto Height() const -> int { return m_height; }
+
+        [[nodiscard]] inline auto ChunksWide() const -> int { return m_chunks_wide; }
+
+        [[nodiscard]] inline auto ChunksHigh() const -> int { return m_chunks_high; }
+
+        /// @brief A counter bumped by every write, so views can tell when cached tiles are stale.
+        /// Chunks coming and going don't count; see ResidencyRevision().
+        [[nodiscard]] inline auto Revision() const -> uint64_t { return m_revision; }
+
+        /// @brief A counter bumped whenever a chunk is installed or released. Paging leaves the
+        /// level as it was, so it doesn't bump Revision(), and only the chunks involved need
+        /// looking at again.
+        [[nodiscard]] inline auto ResidencyRevision() const -> uint64_t {
+            return m_residency_revision;
+        }
+
+        /// @brief Appends the tiles of every chunk installed or released since
+        /// ResidencyRevision() was `since` to `areas`.
+        /// @return False if that was too long ago to tell, in which case any tile may have changed.
+        auto ResidencyChangesSince(uint64_t since, std::vector<Rect>& areas) const -> bool;
+
+        /// @brief Whether a chunk overlapping `area` may have been installed or released since
+        /// ResidencyRevision() was `since`.
+        [[nodiscard]] auto ResidencyChangedIn(uint64_t since, const Rect& area) const -> bool;
+
+        [[nodiscard]] inline auto InBounds(Vec2 pos) const -> bool {
+            return static_cast<unsigned>(pos.X()) < static_cast<unsigned>(m_width) &&
+                   static_cast<unsigned>(pos.Y()) < static_cast<unsigned>(m_height);
+        }
+
+        [[nodiscard]] inline auto IsResident(int chunk_x, int chunk_y) const -> bool {
+            return m_chunks[ChunkSlot(chunk_x, chunk_y)] != nullptr;
+        }
+
+        [[nodiscard]] inline auto ResidentChunks() const -> size_t { return m_resident_chunks; }
+
+        [[nodiscard]] inline auto Glyph(Vec2 pos) const -> char32_t {
+            return InBounds(pos) ? ChunkAt(pos).glyphs[LocalIndex(pos)] : U' ';
+        }
+
+        [[nodiscard]] inline auto Foreground(Vec2 pos) const -> ftxui::Color {
+            return InBounds(pos) ? ChunkAt(pos).fg[LocalIndex(pos)] : ftxui::Color::Default;
+        }
+
+        [[nodiscard]] inline auto Background(Vec2 pos) const -> ftxui::Color {
+            return InBounds(pos) ? ChunkAt(pos).bg[LocalIndex(pos)] : ftxui::Color::Default;
+        }
+
+        [[nodiscard]] inline auto IsPassable(Vec2 pos) const -> bool {
+            return InBounds(pos) &&
+                   (ChunkAt(pos).passable[pos.Y() & CHUNK_MASK] & RowBit(pos)) != 0;
+        }
+
+        [[nodiscard]] inline auto IsOpaque(Vec2 pos) const -> bool {
+            return !InBounds(pos) ||
+                   (ChunkAt(pos).opaque[pos.Y() & CHUNK_MASK] & RowBit(pos)) != 0;
+        }
+
+        /// @brief Whether a single step from `pos` in direction `dir` is allowed. Diagonal steps
+        /// may not squeeze past a blocked orthogonal neighbor.
+        [[nodiscard]] inline auto CanStep(Vec2 pos, Vec2 dir) const -> bool {
+            if (!IsPassable(pos + dir)) { return false; }
+            if (dir.X() != 0 && dir.Y() != 0) {
+                return IsPassable(pos + Vec2{dir.X(), 0}) && IsPassable(pos + Vec2{0, dir.Y()});
+            }
+            return true;
+        }
+
+        [[nodiscard]] inline auto MoveCost(Vec2 pos) const -> int {
+            return InBounds(pos) ? ChunkAt(pos).cost[LocalIndex(pos)] : 0;
+        }
+
+        /// @brief Whether every tile costs the same to enter, which lets pathfinding use jump
+        /// point search instead of plain A*.
+        [[nodiscard]] inline auto IsUniformCost() const -> bool { return m_weighted_tiles == 0; }
+
+        [[nodiscard]] auto Get(Vec2 pos) const -> Tile;
+        void Set(Vec2 pos, const Tile& tile);
+
+        void SetGlyph(Vec2 pos, char32_t glyph);
+        void SetColors(Vec2 pos, ftxui::Color fg, ftxui::Color bg);
+        void SetPassable(Vec2 pos, bool passable);
+        void SetOpaque(Vec2 pos, bool opaque);
+        void SetMoveCost(Vec2 pos, uint8_t cost);
+
+        /// @brief Direct access to a chunk by chunk coordinates, for whole-chunk passes.
+        [[nodiscard]] inline auto Chunk(int chunk_x, int chunk_y) const -> const TileChunk& {
+            const auto* chunk = m_chunks[ChunkSlot(chunk_x, chunk_y)].get();
+            return chunk != nullptr ? *chunk : SolidChunk();
+        }
+
+        /// @brief Mutable chunk access; the chunk must be resident. Writes made through this do
+        /// not bump Revision(); call Invalidate() once the batch of writes is finished.
+        [[nodiscard]] inline auto Chunk(int chunk_x, int chunk_y) -> TileChunk& {
+            return *m_chunks[ChunkSlot(chunk_x, chunk_y)];
+        }
+
+        /// @brief Takes a resident chunk out of the map, e.g. to write it to disk. Its tiles read
+        /// as solid wall until a chunk is installed in its place.
+        auto ReleaseChunk(int chunk_x, int chunk_y) -> std::unique_ptr<TileChunk>;
+
+        /// @brief Makes `chunk` the contents of chunk (`chunk_x`, `chunk_y`), replacing whatever
+        /// was resident there.
+        void InstallChunk(int chunk_x, int chunk_y, std::unique_ptr<TileChunk> chunk);
+
+        /// @brief Bumps Revision() and recounts derived statistics after direct chunk writes.
+        void Invalidate();
+    };
+
+    /// @brief Encodes a glyph as UTF-8, for handing to the terminal.
+    [[nodiscard]] auto GlyphToString(char32_t glyph) -> std::string;
+} // namespace rglike
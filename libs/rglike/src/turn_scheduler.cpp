@@ -0,0 +1,175 @@
+/**
+ * @file turn_scheduler.cpp
+ * @author Alic Szecsei
+ * @date 7/8/2023
+ */
+
+#include "turn_scheduler.hpp"
+
+#include <algorithm>
+
+namespace rglike {
+    void TurnScheduler::Connect(entt::registry& registry) {
+        registry.on_construct<Actor>().connect<&TurnScheduler::OnConstruct>(*this);
+        registry.on_destroy<Actor>().connect<&TurnScheduler::OnDestroy>(*this);
+
+        for (auto entity : registry.view<Actor>()) { Schedule(registry, entity); }
+    }
+
+    void TurnScheduler::Disconnect(entt::registry& registry) {
+        registry.on_construct<Actor>().disconnect<&TurnScheduler::OnConstruct>(*this);
+        registry.on_destroy<Actor>().disconnect<&TurnScheduler::OnDestroy>(*this);
+        Clear();
+    }
+
+    void TurnScheduler::Clear(uint64_t now) {
+        for (auto& bucket : m_wheel) {
+            bucket.queue.clear();
+            bucket.head = 0;
+        }
+        m_overflow.clear();
+        m_slots.clear();
+        m_now = now;
+        m_next_drain = now;
+        m_in_wheel = 0;
+        m_scheduled = 0;
+    }
+
+    void TurnScheduler::OnConstruct(entt::registry& registry, entt::entity entity) {
+        Schedule(registry, entity);
+    }
+
+    void TurnScheduler::OnDestroy(entt::registry&, entt::entity entity) { Unschedule(entity); }
+
+    void TurnScheduler::Schedule(entt::registry& registry, entt::entity entity) {
+        Unschedule(entity);
+
+        const auto& actor = registry.get<Actor>(entity);
+        if (actor.speed <= 0) { return; }
+
+        auto index = static_cast<size_t>(entt::to_entity(entity));
+        if (index >= m_slots.size()) { m_slots.resize(index + 1); }
+        auto& slot = m_slots[index];
+
+        auto missing = ACTION_COST - actor.energy;
+        uint64_t delay = missing <= 0 ? 0 : static_cast<uint64_t>(missing + actor.speed - 1) /
+                                                static_cast<uint64_t>(actor.speed);
+        slot.entity = entity;
+        slot.since = m_now;
+        slot.due = m_now + delay;
+
+        Ticket ticket{entity, ++slot.ticket};
+        if (delay < WHEEL_SIZE) {
+            m_wheel[slot.due & WHEEL_MASK].queue.push_back(ticket);
+            slot.in_wheel = true;
+            ++m_in_wheel;
+        } else {
+            m_overflow.push_back(ticket);
+            slot.in_wheel = false;
+        }
+        ++m_scheduled;
+    }
+
+    void TurnScheduler::Unschedule(entt::entity entity) {
+        auto index = static_cast<size_t>(entt::to_entity(entity));
+        if (index >= m_slots.size()) { return; }
+        auto& slot = m_slots[index];
+        if (slot.entity != entity) { return; }
+
+        // Whatever ticket it holds goes stale, and is skipped when it comes up.
+        if (slot.in_wheel) { --m_in_wheel; }
+        slot.entity = entt::null;
+        slot.in_wheel = false;
+        ++slot.ticket;
+        --m_scheduled;
+    }
+
+    auto TurnScheduler::Pop(entt::registry& registry, uint64_t until) -> entt::entity {
+        while (m_now < until) {
+            auto& bucket = m_wheel[m_now & WHEEL_MASK];
+            while (bucket.head < bucket.queue.size()) {
+                auto ticket = bucket.queue[bucket.head++];
+                const auto& slot = m_slots[entt::to_entity(ticket.entity)];
+                if (slot.entity != ticket.entity || slot.ticket != ticket.ticket) { continue; }
+
+                auto& actor = registry.get<Actor>(ticket.entity);
+                actor.energy += actor.speed * static_cast<int>(m_now - slot.since);
+                Unschedule(ticket.entity);
+                return ticket.entity;
+            }
+            bucket.queue.clear();
+            bucket.head = 0;
+            Advance(until);
+        }
+        return entt::null;
+    }
+
+    void TurnScheduler::Spend(entt::registry& registry, entt::entity entity, int cost) {
+        registry.get<Actor>(entity).energy -= cost;
+        Schedule(registry, entity);
+    }
+
+    void TurnScheduler::SetSpeed(entt::registry& registry, entt::entity entity, int speed) {
+        auto& actor = registry.get<Actor>(entity);
+        auto index = static_cast<size_t>(entt::to_entity(entity));
+        if (index < m_slots.size() && m_slots[index].entity == entity) {
+            actor.energy += actor.speed * static_cast<int>(m_now - m_slots[index].since);
+        }
+        actor.speed = speed;
+        Schedule(registry, entity);
+    }
+
+    void TurnScheduler::Settle(entt::registry& registry) {
+        for (auto& slot : m_slots) {
+            if (slot.entity == entt::null) { continue; }
+            auto& actor = registry.get<Actor>(slot.entity);
+            actor.energy += actor.speed * static_cast<int>(m_now - slot.since);
+            slot.since = m_now;
+        }
+    }
+
+    void TurnScheduler::Advance(uint64_t until) {
+        if (m_in_wheel == 0) {
+            // Nothing live in the wheel, so skip straight to the earliest overflowed actor. The
+            // buckets hold nothing but stale tickets.
+            auto next = until;
+            for (const auto& ticket : m_overflow) {
+                const auto& slot = m_slots[entt::to_entity(ticket.entity)];
+                if (slot.entity == ticket.entity && slot.ticket == ticket.ticket) {
+                    next = std::min(next, slot.due);
+                }
+            }
+            for (auto& bucket : m_wheel) {
+                bucket.queue.clear();
+                bucket.head = 0;
+            }
+            m_now = next;
+            if (!m_overflow.empty()) { DrainOverflow(); }
+            return;
+        }
+
+        do {
+            ++m_now;
+            if (!m_overflow.empty() && m_now >= m_next_drain) { DrainOverflow(); }
+        } while (m_now < until && m_wheel[m_now & WHEEL_MASK].queue.empty());
+    }
+
+    void TurnScheduler::DrainOverflow() {
+        // Anything left over is due at least WHEEL_SIZE / 2 ticks after the next drain, so it
+        // always makes it into the wheel before it comes up.
+        m_next_drain = m_now + WHEEL_SIZE / 2;
+        auto kept = m_overflow.begin();
+        for (const auto& ticket : m_overflow) {
+            auto& slot = m_slots[entt::to_entity(ticket.entity)];
+            if (slot.entity != ticket.entity || slot.ticket != ticket.ticket) { continue; }
+            if (slot.due < m_now + WHEEL_SIZE) {
+                m_wheel[slot.due & WHEEL_MASK].queue.push_back(ticket);
+                slot.in_wheel = true;
+                ++m_in_wheel;
+            } else {
+                *kept++ = ticket;
+            }
+        }
+        m_overflow.erase(kept, m_overflow.end());
+    }
+} // namespace rglike
@@ -0,0 +1,108 @@
+/**
+ * @file turn_scheduler.hpp
+ * @author Alic Szecsei
+ * @date 7/8/2023
+ */
+
+#pragma once
+
+#include "components.hpp"
+
+#include "entt/entt.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace rglike {
+    /// @brief Decides whose turn it is among every entity with an Actor.
+    ///
+    /// Rather than topping up every actor's energy each tick, the scheduler works out the tick on
+    /// which each actor will next reach ACTION_COST and files it in a timing wheel, one bucket per
+    /// tick. Finding the next actor is then a matter of walking forward to the next non-empty
+    /// bucket; energy is only brought up to date when an actor's turn comes round. Actors due
+    /// further out than the wheel covers wait in an overflow list until the wheel catches up.
+    ///
+    /// Actors that become due on the same tick act in the order they were scheduled.
+    class TurnScheduler {
+    private:
+        static constexpr size_t WHEEL_SIZE = 256;
+        static constexpr size_t WHEEL_MASK = WHEEL_SIZE - 1;
+
+        /// @brief A queued turn. It is stale if the actor's slot has since moved on to another
+        /// ticket.
+        struct Ticket {
+            entt::entity entity = entt::null;
+            uint32_t ticket = 0;
+        };
+
+        struct Bucket {
+            std::vector<Ticket> queue;
+            size_t head = 0;
+        };
+
+        /// @brief The state of one actor, indexed by entity.
+        struct Slot {
+            entt::entity entity = entt::null;
+            uint32_t ticket = 0;
+            bool in_wheel = false;
+            /// @brief The tick its energy was last brought up to date.
+            uint64_t since = 0;
+            uint64_t due = 0;
+        };
+
+        std::array<Bucket, WHEEL_SIZE> m_wheel;
+        std::vector<Ticket> m_overflow;
+        std::vector<Slot> m_slots;
+        uint64_t m_now = 0;
+        uint64_t m_next_drain = 0;
+        size_t m_in_wheel = 0;
+        size_t m_scheduled = 0;
+
+        void OnConstruct(entt::registry& registry, entt::entity entity);
+        void OnDestroy(entt::registry& registry, entt::entity entity);
+
+        /// @brief Moves overflowed actors that are now within the wheel's reach into it.
+        void DrainOverflow();
+
+        /// @brief Moves the clock forward to the next tick with someone due, but no further than
+        /// `until`.
+        void Advance(uint64_t until);
+
+    public:
+        /// @brief Hooks the scheduler up to `registry`'s Actor signals, and schedules every
+        /// existing actor.
+        void Connect(entt::registry& registry);
+
+        void Disconnect(entt::registry& registry);
+
+        /// @brief Forgets every actor and sets the clock to `now`, e.g. the tick a save was made on.
+        void Clear(uint64_t now = 0);
+
+        /// @brief (Re)schedules `entity` from its current energy and speed, as of now.
+        void Schedule(entt::registry& registry, entt::entity entity);
+
+        void Unschedule(entt::entity entity);
+
+        /// @brief The next actor to act before tick `until`, with its energy brought up to date,
+        /// or null if no one is due by then. In that case the clock moves on to `until`.
+        ///
+        /// A popped actor is no longer scheduled; call Spend() once it has acted.
+        auto Pop(entt::registry& registry, uint64_t until) -> entt::entity;
+
+        /// @brief Takes `cost` energy from `entity` and schedules its next turn.
+        void Spend(entt::registry& registry, entt::entity entity, int cost = ACTION_COST);
+
+        /// @brief Changes `entity`'s speed, keeping the energy it built up at the old speed.
+        void SetSpeed(entt::registry& registry, entt::entity entity, int speed);
+
+        /// @brief Brings every scheduled actor's energy up to date with the clock, without moving
+        /// anyone's turn. Do this before saving, since a loaded game schedules from energy alone.
+        void Settle(entt::registry& registry);
+
+        [[nodiscard]] inline auto Now() const -> uint64_t { return m_now; }
+
+        /// @brief How many actors are waiting for a turn.
+        [[nodiscard]] inline auto Scheduled() const -> size_t { return m_scheduled; }
+    };
+} // namespace rglike
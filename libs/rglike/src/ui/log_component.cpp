@@ -5,72 +5,29 @@
  */
 
 #include "log_component.hpp"
+
+#include "../constants.hpp"
+#include "log_layout_cache.hpp"
+
 #include <algorithm>
-#include <sstream>
 
 using namespace ftxui;
 
 namespace rglike::ui {
-    void Tokenize(
-        const std::string_view& s, std::vector<std::string>& tokens, const std::string_view& delims
-    ) {
-        auto pos = s.begin();
-        auto end = pos;
-        while (true) {
-            end = std::find_first_of(pos, s.end(), delims.begin(), delims.end());
-            tokens.emplace_back(pos, end);
-
-            if (end == s.end()) { return; }
-            pos = end + 1;
-        }
-    }
-
-    auto Split(const std::vector<GameLogFragment>& the_text) -> ftxui::Elements {
-        Elements output{};
-        output.push_back(text(":: "));
-        for (const auto& fragment : the_text) {
-            std::stringstream ss(fragment.text);
-            std::string word;
-            bool is_first = true;
-
-            std::vector<std::string> words{};
-            Tokenize(fragment.text, words, " ");
-
-            for (const auto& word : words) {
-                Decorator text_decorator = color(fragment.color) | bgcolor(fragment.bg_color);
-                if (fragment.bold) { text_decorator = text_decorator | bold; }
-                if (fragment.dim) { text_decorator = text_decorator | dim; }
-                if (fragment.underlined) { text_decorator = text_decorator | underlined; }
-                if (fragment.blinking) { text_decorator = text_decorator | blink; }
-
-                if (is_first) {
-                    output.push_back(text(word) | text_decorator);
-                } else {
-                    output.push_back(text(" " + word) | text_decorator);
-                }
-                is_first = false;
-            }
-        }
-        return output;
-    }
-
-    auto LogParagraphAlignLeft(const std::vector<GameLogFragment>& the_text) -> ftxui::Element {
-        static const auto config = ftxui::FlexboxConfig().SetGap(0, 0);
-        return ftxui::flexbox(Split(the_text), config);
-    }
-
-    auto LogParagraph(const std::vector<GameLogFragment>& the_text) -> ftxui::Element {
-        return LogParagraphAlignLeft(the_text);
-    }
-
     class GameLogComponent : public ComponentBase {
     private:
         int m_selected = 0;
-        const GameLog& m_log;
+        /// @brief The line at the top of the view.
+        int m_top = 0;
+        GameLog& m_log;
+        LogLayoutCache m_layouts;
         Box m_box;
 
+        /// @brief Scrolls just far enough for the selected line to be in view.
+        void ScrollToSelected(int width, int height);
+
     public:
-        explicit GameLogComponent(const GameLog& gameLog)
+        explicit GameLogComponent(GameLog& gameLog)
             : m_log(gameLog) { }
 
         [[nodiscard]] auto Render() -> ftxui::Element final;
@@ -81,23 +38,67 @@ namespace rglike::ui {
         [[nodiscard]] inline auto Selected() const -> int { return m_selected; }
     };
 
+    void GameLogComponent::ScrollToSelected(int width, int height) {
+        auto size = static_cast<int>(m_log.Size());
+        m_selected = std::max(0, std::min(size - 1, m_selected));
+        m_top = std::max(0, std::min(m_selected, m_top));
+
+        // The highest top the selected line still fits under. Only lines near the selection are
+        // laid out, however long the log is.
+        int top = m_selected;
+        int rows = static_cast<int>(m_layouts.Rows(m_log, top, width).size());
+        while (top > 0) {
+            auto above = static_cast<int>(m_layouts.Rows(m_log, top - 1, width).size());
+            if (rows + above > height) { break; }
+            rows += above;
+            --top;
+        }
+        m_top = std::max(m_top, top);
+    }
+
     auto GameLogComponent::Render() -> ftxui::Element {
-        ftxui::Elements log{};
-        log.reserve(m_log.Size());
-        int index = 0;
-        for (const auto& line : m_log.Entries()) {
-            bool is_focus = (index++ == m_selected);
-            Decorator line_decorator = nothing;
-            if (is_focus) {
-                line_decorator = line_decorator | focus;
-                if (Focused()) { line_decorator = line_decorator | bold; }
+        // New lines push the ones below them down, so the selection follows the line it was on.
+        auto drained = static_cast<int>(m_log.Drain());
+        if (m_selected > 0) {
+            m_selected += drained;
+            m_top += drained;
+        }
+
+        // The box is from the last frame; the column on the right is the scroll indicator.
+        auto width = m_box.x_max - m_box.x_min;
+        auto height = m_box.y_max - m_box.y_min + 1;
+        if (height <= 0) { height = LOG_HEIGHT; }
+
+        ftxui::Elements rows{};
+        if (m_log.Size() > 0) {
+            ScrollToSelected(width, height);
+            for (int index = m_top; index < static_cast<int>(m_log.Size()); ++index) {
+                if (static_cast<int>(rows.size()) >= height) { break; }
+
+                const auto& lines = m_layouts.Rows(m_log, index, width);
+                auto count = std::min(lines.size(), static_cast<size_t>(height) - rows.size());
+                auto line = ftxui::vbox(Elements(lines.begin(), lines.begin() + count));
+                if (index == m_selected && Focused()) { line = line | bold; }
+                rows.push_back(line);
             }
-            log.push_back(LogParagraph(line) | line_decorator);
         }
+
+        // Where the view sits in the whole log, by line rather than by row.
+        ftxui::Elements bar{};
+        auto size = std::max<size_t>(1, m_log.Size());
+        auto thumb = static_cast<int>(static_cast<size_t>(m_top) * height / size);
+        for (int row = 0; row < height; ++row) {
+            bar.push_back(ftxui::text(row == thumb && m_log.Size() > 1 ? "┃" : " "));
+        }
+
         return ftxui::vbox({
             ftxui::text("> Game Log"),
             ftxui::separatorCharacter("-"),
-            ftxui::vbox(log) | vscroll_indicator | yframe | reflect(m_box),
+            ftxui::hbox({
+                ftxui::vbox(std::move(rows)) | flex,
+                ftxui::vbox(std::move(bar)),
+            }) | flex |
+                reflect(m_box),
         });
     }
 
@@ -124,7 +125,7 @@ namespace rglike::ui {
         return m_selected != old_selected;
     }
 
-    auto GameLogViewer(const GameLog& gameLog) -> ftxui::Component {
+    auto GameLogViewer(GameLog& gameLog) -> ftxui::Component {
         return Make<GameLogComponent>(gameLog);
     }
 } // namespace rglike::ui
\ No newline at end of file
@@ -11,5 +11,5 @@
 
 /// View/rendering components for rglike
 namespace rglike::ui {
-    [[nodiscard]] auto GameLogViewer(const GameLog& gameLog) -> ftxui::Component;
+    [[nodiscard]] auto GameLogViewer(GameLog& gameLog) -> ftxui::Component;
 } // namespace rglike::ui
\ No newline at end of file
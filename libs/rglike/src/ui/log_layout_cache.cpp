@@ -0,0 +1,105 @@
+/**
+ * @file log_layout_cache.cpp
+ * @author Alic Szecsei
+ * @date 7/25/2023
+ */
+
+#include "log_layout_cache.hpp"
+
+#include <ftxui/screen/string.hpp>
+
+namespace rglike::ui {
+    namespace {
+        /// @brief Every line starts with this.
+        constexpr std::string_view LINE_PREFIX = ":: ";
+
+        auto StyleOf(const GameLog& log, const LogStyle& style) -> ftxui::Decorator {
+            auto decorator = ftxui::color(log.Color(style.color)) |
+                             ftxui::bgcolor(log.Color(style.bg_color));
+            if (style.Has(LogStyle::BOLD)) { decorator = decorator | ftxui::bold; }
+            if (style.Has(LogStyle::DIM)) { decorator = decorator | ftxui::dim; }
+            if (style.Has(LogStyle::UNDERLINED)) { decorator = decorator | ftxui::underlined; }
+            if (style.Has(LogStyle::BLINKING)) { decorator = decorator | ftxui::blink; }
+            return decorator;
+        }
+
+        /// @brief Fills rows left to right, starting a new one whenever a word won't fit.
+        class RowBuilder {
+        private:
+            int m_width;
+            int m_used = 0;
+            ftxui::Elements m_row;
+            ftxui::Elements m_rows;
+
+        public:
+            explicit RowBuilder(int width)
+                : m_width(width) { }
+
+            /// @brief Adds `word`, which starts with a space unless it directly follows the
+            /// previous word. The space is dropped if the word has to start a new row.
+            void Add(std::string_view word, const ftxui::Decorator& style) {
+                auto text = std::string(word);
+                auto width = ftxui::string_width(text);
+                if (m_width > 0 && !m_row.empty() && m_used + width > m_width) {
+                    Break();
+                    if (!text.empty() && text.front() == ' ') {
+                        text.erase(0, 1);
+                        --width;
+                    }
+                }
+                m_used += width;
+                m_row.push_back(ftxui::text(std::move(text)) | style);
+            }
+
+            void Break() {
+                m_rows.push_back(ftxui::hbox(std::move(m_row)));
+                m_row = {};
+                m_used = 0;
+            }
+
+            auto Finish() -> ftxui::Elements {
+                if (!m_row.empty() || m_rows.empty()) { Break(); }
+                return std::move(m_rows);
+            }
+        };
+    } // namespace
+
+    auto LogLayoutCache::Wrap(const GameLog& log, const LogLine& line, int width)
+        -> ftxui::Elements {
+        RowBuilder rows(width);
+        rows.Add(LINE_PREFIX, ftxui::nothing);
+        for (const auto& fragment : line.Fragments()) {
+            auto style = StyleOf(log, fragment.style);
+            auto text = line.Text(fragment);
+
+            // Words keep the space before them, so that fragments join up exactly as written.
+            size_t start = 0;
+            while (true) {
+                auto end = text.find(' ', start + 1);
+                if (end == std::string_view::npos) { end = text.size(); }
+                if (end > start) { rows.Add(text.substr(start, end - start), style); }
+                if (end == text.size()) { break; }
+                start = end;
+            }
+        }
+        return rows.Finish();
+    }
+
+    auto LogLayoutCache::Rows(const GameLog& log, size_t index, int width)
+        -> const ftxui::Elements& {
+        if (m_layouts.size() != log.Capacity()) {
+            m_layouts.clear();
+            m_layouts.resize(log.Capacity());
+        }
+
+        auto id = log.LineId(index);
+        auto& layout = m_layouts[id % m_layouts.size()];
+        if (layout.line != id || layout.width != width) {
+            layout.line = id;
+            layout.width = width;
+            layout.rows = Wrap(log, log.Line(index), width);
+            ++m_misses;
+        }
+        return layout.rows;
+    }
+} // namespace rglike::ui
@@ -0,0 +1,44 @@
+/**
+ * @file log_layout_cache.hpp
+ * @author Alic Szecsei
+ * @date 7/25/2023
+ */
+
+#pragma once
+
+#include "../game_log.hpp"
+
+#include <ftxui/dom/elements.hpp>
+#include <vector>
+
+namespace rglike::ui {
+    /// @brief Game log lines already word-wrapped into rows of styled text.
+    ///
+    /// A line is only laid out the first time it is asked for at a given width, so a frame in
+    /// which nothing was logged and nothing was resized builds no elements at all.
+    class LogLayoutCache {
+    private:
+        struct Layout {
+            uint64_t line = UINT64_MAX;
+            int width = 0;
+            ftxui::Elements rows;
+        };
+
+        /// @brief Indexed by line ID modulo the log's capacity, so it never outgrows the log.
+        std::vector<Layout> m_layouts;
+        size_t m_misses = 0;
+
+    public:
+        /// @brief Word-wraps `line` to `width` columns; a width of zero or less never wraps.
+        [[nodiscard]] static auto Wrap(const GameLog& log, const LogLine& line, int width)
+            -> ftxui::Elements;
+
+        /// @brief The rows of the `index`th most recent line of `log`, wrapped to `width`.
+        auto Rows(const GameLog& log, size_t index, int width) -> const ftxui::Elements&;
+
+        /// @brief How many lines have had to be laid out.
+        [[nodiscard]] inline auto Misses() const -> size_t { return m_misses; }
+
+        inline void Clear() { m_layouts.clear(); }
+    };
+} // namespace rglike::ui
@@ -6,8 +6,18 @@
 
 #include "world_component.hpp"
 
+#include "../constants.hpp"
 #include "../game_log.hpp"
+#include "../input.hpp"
+#include "world_view_cache.hpp"
+
+#include <algorithm>
 #include <fmt/core.h>
+#include <ftxui/component/animation.hpp>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <limits>
+#include <optional>
 
 namespace rglike::ui {
     using namespace ftxui;
@@ -16,39 +26,134 @@ namespace rglike::ui {
     class WorldComponent : public ComponentBase {
     private:
         World& m_world;
+        ReplayRecorder* m_recorder;
         Box m_box;
+        WorldViewCache m_cache;
+        Vec2 m_camera{0, 0};
+
+        void UpdateCamera(int width, int height);
+        void PaintParticles(ftxui::Screen& screen, const Box& box);
+        /// @brief Fires the magic missile effect at the nearest visible monster, if there is one.
+        auto CastMissile() -> bool;
 
     public:
-        explicit WorldComponent(World& world)
-            : m_world(world) { }
+        WorldComponent(World& world, ReplayRecorder* recorder)
+            : m_world(world)
+            , m_recorder(recorder) { }
 
         [[nodiscard]] auto Render() -> ftxui::Element final;
         auto OnEvent(ftxui::Event event) -> bool final;
 
         [[nodiscard]] auto Focusable() const -> bool final { return true; }
+
+        /// @brief Paints the map into `screen` inside `box`. Called by WorldNode.
+        void Paint(ftxui::Screen& screen, const Box& box);
     };
 
-    auto WorldComponent::Render() -> ftxui::Element {
-        ftxui::Elements world{};
-
-        auto height = 1 + m_box.y_max - m_box.y_min;
-        auto width = 1 + m_box.x_max - m_box.x_min;
-
-        world.reserve(height);
-        for (int i = 0; i < height; ++i) {
-            ftxui::Elements row;
-            row.reserve(width);
-            for (int j = 0; j < width; ++j) {
-                Vec2 pos{j, i};
-                if (pos == m_world.PlayerPos()) {
-                    row.push_back(ftxui::text("@"));
-                } else {
-                    row.push_back(ftxui::text("."));
-                }
-            }
-            world.push_back(ftxui::hbox(row));
+    /// @brief A leaf node that paints the world straight into the screen buffer, instead of
+    /// building a text element per cell.
+    class WorldNode : public Node {
+    private:
+        WorldComponent& m_component;
+
+    public:
+        explicit WorldNode(WorldComponent& component)
+            : m_component(component) { }
+
+        void ComputeRequirement() override {
+            requirement_.min_x = 0;
+            requirement_.min_y = 0;
+            requirement_.flex_grow_x = 1;
+            requirement_.flex_grow_y = 1;
+            requirement_.flex_shrink_x = 1;
+            requirement_.flex_shrink_y = 1;
+        }
+
+        void Render(Screen& screen) override { m_component.Paint(screen, box_); }
+    };
+
+    void WorldComponent::UpdateCamera(int width, int height) {
+        // Only scroll once the player gets close to the edge of the view, so that most moves leave
+        // the cached cells where they are.
+        auto player = m_world.PlayerPos();
+        int margin_x = std::min(CAMERA_SCROLL_MARGIN, width / 4);
+        int margin_y = std::min(CAMERA_SCROLL_MARGIN, height / 4);
+
+        if (player.X() < m_camera.X() + margin_x || player.X() >= m_camera.X() + width - margin_x) {
+            m_camera.X() = player.X() - width / 2;
+        }
+        if (player.Y() < m_camera.Y() + margin_y ||
+            player.Y() >= m_camera.Y() + height - margin_y) {
+            m_camera.Y() = player.Y() - height / 2;
         }
-        return ftxui::vbox(world) | flex | reflect(m_box);
+    }
+
+    void WorldComponent::Paint(ftxui::Screen& screen, const Box& box) {
+        auto height = 1 + box.y_max - box.y_min;
+        auto width = 1 + box.x_max - box.x_min;
+        if (width <= 0 || height <= 0) { return; }
+
+        UpdateCamera(width, height);
+        m_cache.Update(m_world.Map(), m_world.Fov(), m_world.Lights(), m_camera, width, height);
+        m_cache.Blit(screen, box.x_min, box.y_min);
+        PaintParticles(screen, box);
+
+        // Entities are drawn over the cached map layer.
+        auto player = m_world.PlayerPos() - m_camera;
+        if (player.X() >= 0 && player.X() < width && player.Y() >= 0 && player.Y() < height) {
+            auto& pixel = screen.PixelAt(box.x_min + player.X(), box.y_min + player.Y());
+            pixel.character = "@";
+            pixel.foreground_color = Color::Default;
+        }
+    }
+
+    void WorldComponent::PaintParticles(ftxui::Screen& screen, const Box& box) {
+        auto& particles = m_world.Particles();
+        auto now = ParticleClock::now();
+        particles.Update(now);
+        if (particles.Empty()) { return; }
+
+        const auto& types = m_world.ParticleTypes();
+        particles.ForEachVisible(now, [&](const Particle& particle, float remaining) {
+            auto pos = particle.pos - m_camera;
+            if (pos.X() < 0 || pos.Y() < 0 || pos.X() > box.x_max - box.x_min ||
+                pos.Y() > box.y_max - box.y_min) {
+                return;
+            }
+            auto& pixel = screen.PixelAt(box.x_min + pos.X(), box.y_min + pos.Y());
+            pixel.character = types.Glyph(particle.spec);
+            pixel.foreground_color = types.Spec(particle.spec).color;
+            pixel.dim = remaining < 0.5F;
+        });
+
+        // Keep redrawing until the last particle has faded; input is still handled in between.
+        animation::RequestAnimationFrame();
+    }
+
+    auto WorldComponent::CastMissile() -> bool {
+        auto spec = m_world.ParticleTypes().Find("mmissile");
+        if (!spec) { return false; }
+
+        auto player = m_world.PlayerPos();
+        std::optional<Vec2> target;
+        auto best = std::numeric_limits<double>::max();
+        m_world.Spatial().QueryRadius(player, MONSTER_SIGHT_RADIUS, [&](entt::entity, Vec2 pos) {
+            auto distance = (pos - player).LengthSquared();
+            if (distance < best && m_world.Fov().IsVisible(pos)) {
+                best = distance;
+                target = pos;
+            }
+        });
+        if (!target) { return false; }
+
+        m_world.Particles().SpawnLine(
+            m_world.ParticleTypes(), *spec, player, *target, ParticleClock::now()
+        );
+        return true;
+    }
+
+    auto WorldComponent::Render() -> ftxui::Element {
+        return std::make_shared<WorldNode>(*this) | reflect(m_box);
     }
 
     auto WorldComponent::OnEvent(ftxui::Event event) -> bool {
@@ -64,28 +169,17 @@ namespace rglike::ui {
             return true;
         }
 
-        if (event == ftxui::Event::ArrowUp) {
-            m_world.MovePlayer(Vec2::Up());
-            return true;
-        }
-
-        if (event == ftxui::Event::ArrowRight) {
-            m_world.MovePlayer(Vec2::Right());
-            return true;
-        }
+        if (event == ftxui::Event::Character('f')) { return CastMissile(); }
 
-        if (event == ftxui::Event::ArrowDown) {
-            m_world.MovePlayer(Vec2::Down());
-            return true;
-        }
-
-        if (event == ftxui::Event::ArrowLeft) {
-            m_world.MovePlayer(Vec2::Left());
+        if (ApplyInput(m_world, event)) {
+            if (m_recorder != nullptr) { m_recorder->Record(event); }
             return true;
         }
 
         return false;
     }
 
-    auto WorldViewer(World& gameLog) -> Component { return Make<WorldComponent>(gameLog); }
+    auto WorldViewer(World& gameLog, ReplayRecorder* recorder) -> Component {
+        return Make<WorldComponent>(gameLog, recorder);
+    }
 } // namespace rglike::ui
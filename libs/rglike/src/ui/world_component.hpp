@@ -6,9 +6,13 @@
 
 #pragma once
 
+#include "../replay.hpp"
 #include "../world.hpp"
 #include <ftxui/component/component.hpp>
 
 namespace rglike::ui {
-    [[nodiscard]] auto WorldViewer(World& gameLog) -> ftxui::Component;
+    /// @brief Shows the world and passes gameplay input on to it, recording that input to
+    /// `recorder` if one is given.
+    [[nodiscard]] auto WorldViewer(World& gameLog, ReplayRecorder* recorder = nullptr)
+        -> ftxui::Component;
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+/**
+ * @file world_view_cache.cpp
+ * @author Alic Szecsei
+ * @date 6/14/2023
+ */
+
+#include "world_view_cache.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+namespace rglike::ui {
+    namespace {
+        /// @brief How far a full-strength light pulls a glyph's color towards its own.
+        constexpr float LIGHT_TINT = 0.6F;
+        /// @brief How far a full-strength light pulls a tile's background towards its color.
+        constexpr float LIGHT_GLOW = 0.25F;
+
+        /// @brief Tints a visible cell by the light falling on it.
+        void Shade(const LightLevel& light, ftxui::Pixel& cell) {
+            auto peak = std::max({light.red, light.green, light.blue});
+            if (peak == 0) { return; }
+
+            // The light's hue at full brightness; how bright it is decides how far to tint.
+            auto channel = [peak](uint32_t value) {
+                return static_cast<uint8_t>(value * 255 / peak);
+            };
+            auto hue =
+                ftxui::Color::RGB(channel(light.red), channel(light.green), channel(light.blue));
+            auto strength = std::min(1.0F, static_cast<float>(peak) / 255.0F);
+
+            // Default colors are up to the terminal, so assume the usual light-on-dark.
+            auto fg = cell.foreground_color == ftxui::Color::Default
+                          ? ftxui::Color(ftxui::Color::GrayLight)
+                          : cell.foreground_color;
+            auto bg = cell.background_color == ftxui::Color::Default
+                          ? ftxui::Color(ftxui::Color::Black)
+                          : cell.background_color;
+            cell.foreground_color = ftxui::Color::Interpolate(strength * LIGHT_TINT, fg, hue);
+            cell.background_color = ftxui::Color::Interpolate(strength * LIGHT_GLOW, bg, hue);
+        }
+    } // namespace
+
+    void WorldViewCache::Resolve(
+        const TileMap& map, const FieldOfView& fov, const LightMap& lights, Vec2 pos,
+        ftxui::Pixel& cell
+    ) {
+        if (!fov.IsExplored(pos)) {
+            cell.character = " ";
+            cell.foreground_color = ftxui::Color::Default;
+            cell.background_color = ftxui::Color::Default;
+            cell.dim = false;
+            return;
+        }
+
+        cell.character = GlyphToString(map.Glyph(pos));
+        cell.foreground_color = map.Foreground(pos);
+        cell.background_color = map.Background(pos);
+        // Remembered but out-of-sight tiles are drawn dimmed, and only what is in sight is lit.
+        cell.dim = !fov.IsVisible(pos);
+        if (!cell.dim) { Shade(lights.LightAt(pos), cell); }
+    }
+
+    auto WorldViewCache::ResolveArea(
+        const TileMap& map, const FieldOfView& fov, const LightMap& lights, const Rect& area
+    ) -> int {
+        auto view = Rect{m_origin, m_origin + Vec2{m_width, m_height}};
+        auto dirty = area.Intersect(view);
+        if (dirty.Empty()) { return 0; }
+        for (int y = dirty.min.Y(); y < dirty.max.Y(); ++y) {
+            for (int x = dirty.min.X(); x < dirty.max.X(); ++x) {
+                auto local = Vec2{x, y} - m_origin;
+                Resolve(map, fov, lights, Vec2{x, y}, m_cells[local.Y() * m_width + local.X()]);
+            }
+        }
+        return dirty.Width() * dirty.Height();
+    }
+
+    auto WorldViewCache::Update(
+        const TileMap& map, const FieldOfView& fov, const LightMap& lights, Vec2 origin,
+        int width, int height
+    ) -> int {
+        if (width <= 0 || height <= 0) {
+            m_width = 0;
+            m_height = 0;
+            m_cells.clear();
+            return 0;
+        }
+
+        bool rebuild = !m_valid || width != m_width || height != m_height ||
+                       map.Revision() != m_map_revision;
+        if (rebuild) {
+            m_origin = origin;
+            m_width = width;
+            m_height = height;
+            m_map_revision = map.Revision();
+            m_residency_revision = map.ResidencyRevision();
+            m_fov_revision = fov.Revision();
+            m_light_revision = lights.Revision();
+            m_valid = true;
+            m_cells.resize(static_cast<size_t>(width) * height);
+
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    Resolve(map, fov, lights, origin + Vec2{x, y}, m_cells[y * width + x]);
+                }
+            }
+            return width * height;
+        }
+
+        int resolved = 0;
+        Vec2 shift = origin - m_origin;
+        if (shift != Vec2::Zero()) {
+            // Scrolled: keep every cell that is still on screen, resolve only the exposed strip.
+            m_scratch.resize(m_cells.size());
+            m_origin = origin;
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    int old_x = x + shift.X();
+                    int old_y = y + shift.Y();
+                    auto& cell = m_scratch[y * width + x];
+                    if (old_x >= 0 && old_x < width && old_y >= 0 && old_y < height) {
+                        cell = std::move(m_cells[old_y * width + old_x]);
+                    } else {
+                        Resolve(map, fov, lights, origin + Vec2{x, y}, cell);
+                        ++resolved;
+                    }
+                }
+            }
+            std::swap(m_cells, m_scratch);
+        }
+
+        if (map.ResidencyRevision() != m_residency_revision) {
+            m_paged.clear();
+            if (!map.ResidencyChangesSince(m_residency_revision, m_paged)) {
+                m_paged.assign(1, Rect{origin, origin + Vec2{width, height}});
+            }
+            m_residency_revision = map.ResidencyRevision();
+            for (const auto& area : m_paged) { resolved += ResolveArea(map, fov, lights, area); }
+        }
+
+        if (fov.Revision() != m_fov_revision) {
+            // Only cells the field of view touched can have changed visibility. As with the
+            // lights, the dirty bounds only cover the latest update; several moves between frames
+            // leave cells lit at the middle positions outside them, so the whole window is redone.
+            auto area = fov.Revision() == m_fov_revision + 1
+                            ? fov.DirtyBounds()
+                            : Rect{origin, origin + Vec2{width, height}};
+            m_fov_revision = fov.Revision();
+            resolved += ResolveArea(map, fov, lights, area);
+        }
+
+        if (lights.Revision() != m_light_revision) {
+            // The dirty bounds only cover the latest update, so if several went by unseen the
+            // whole window is redone.
+            auto area = lights.Revision() == m_light_revision + 1
+                            ? lights.DirtyBounds()
+                            : Rect{origin, origin + Vec2{width, height}};
+            m_light_revision = lights.Revision();
+            resolved += ResolveArea(map, fov, lights, area);
+        }
+
+        return resolved;
+    }
+
+    void WorldViewCache::Blit(ftxui::Screen& screen, int x, int y) const {
+        for (int row = 0; row < m_height; ++row) {
+            const auto* src = &m_cells[row * m_width];
+            for (int col = 0; col < m_width; ++col) { screen.PixelAt(x + col, y + row) = src[col]; }
+        }
+    }
+} // namespace rglike::ui
@@ -0,0 +1,70 @@
+/**
+ * @file world_view_cache.hpp
+ * @author Alic Szecsei
+ * @date 6/14/2023
+ */
+
+#pragma once
+
+#include "../fov.hpp"
+#include "../light_map.hpp"
+#include "../math.hpp"
+#include "../tile_map.hpp"
+
+#include <ftxui/screen/screen.hpp>
+#include <vector>
+
+namespace rglike::ui {
+    /// @brief A persistent, already-resolved copy of the map cells inside the camera window.
+    ///
+    /// Resolving a tile (UTF-8 encoding its glyph, looking up its colors, visibility and light)
+    /// only happens for cells that changed: when the window scrolls, only the newly exposed strip
+    /// is resolved and the rest is shifted over; when the field of view or the light changes,
+    /// only its dirty bounds are resolved; chunks paged in or out only have their own tiles
+    /// resolved; a resize or map edit rebuilds everything. Every other
+    /// frame is a straight copy of the cached pixels into the screen.
+    class WorldViewCache {
+    private:
+        Vec2 m_origin{0, 0};
+        int m_width = 0;
+        int m_height = 0;
+        uint64_t m_map_revision = 0;
+        uint64_t m_residency_revision = 0;
+        uint64_t m_fov_revision = 0;
+        uint64_t m_light_revision = 0;
+        bool m_valid = false;
+        std::vector<ftxui::Pixel> m_cells;
+        std::vector<ftxui::Pixel> m_scratch;
+        std::vector<Rect> m_paged;
+
+        static void Resolve(
+            const TileMap& map, const FieldOfView& fov, const LightMap& lights, Vec2 pos,
+            ftxui::Pixel& cell
+        );
+
+        /// @brief Re-resolves the cells of `area` that are inside the window.
+        auto ResolveArea(
+            const TileMap& map, const FieldOfView& fov, const LightMap& lights, const Rect& area
+        ) -> int;
+
+    public:
+        /// @brief Brings the cache up to date with the given window onto the map.
+        /// @return The number of cells that had to be re-resolved.
+        auto Update(
+            const TileMap& map, const FieldOfView& fov, const LightMap& lights, Vec2 origin,
+            int width, int height
+        ) -> int;
+
+        /// @brief Paints the cached cells into `screen` with the window's top-left at (x, y).
+        void Blit(ftxui::Screen& screen, int x, int y) const;
+
+        /// @brief Forces a full rebuild on the next Update.
+        inline void Invalidate() { m_valid = false; }
+
+        [[nodiscard]] inline auto Origin() const -> Vec2 { return m_origin; }
+
+        [[nodiscard]] inline auto Width() const -> int { return m_width; }
+
+        [[nodiscard]] inline auto Height() const -> int { return m_height; }
+    };
+} // namespace rglike::ui
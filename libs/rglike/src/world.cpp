@@ -6,19 +6,313 @@
 
 #include "world.hpp"
 
+#include "components.hpp"
 #include "constants.hpp"
+#include "random.hpp"
+#include "state_hash.hpp"
+#include <chrono>
+#include <cstdlib>
 #include <spdlog/spdlog.h>
+#include <stdexcept>
 
 namespace rglike {
-    constexpr int DEFAULT_PLAYER_X_POS = 1;
-    constexpr int DEFAULT_PLAYER_Y_POS = 1;
+    namespace {
+        /// @brief One step from `from` towards `to`, along whichever axis is further apart.
+        auto StepTowards(Vec2 from, Vec2 to) -> Vec2 {
+            auto delta = to - from;
+            if (delta == Vec2::Zero()) { return Vec2::Zero(); }
+            if (std::abs(delta.X()) >= std::abs(delta.Y())) {
+                return Vec2{delta.X() > 0 ? 1 : -1, 0};
+            }
+            return Vec2{0, delta.Y() > 0 ? 1 : -1};
+        }
+    } // namespace
 
-    void World::Initialize() {
-        spdlog::info("Initializing world");
+    World::World() {
+        m_spatial.Connect(Registry);
+        m_turns.Connect(Registry);
+        m_faction_matrix.Connect(Registry);
+        m_lights.Connect(Registry);
+        DefineBaseParticles(m_particle_types);
 
-        m_player_pos.X() = DEFAULT_PLAYER_X_POS;
-        m_player_pos.Y() = DEFAULT_PLAYER_Y_POS;
+        m_systems.Add(
+            "fields", SystemAccess{}.ReadResource<TileMap>().WriteResource<GoalFields>(),
+            [this](entt::registry&, ThreadPool&) { UpdateFields(); }
+        );
+        m_systems.Add(
+            "perception",
+            SystemAccess{}
+                .Read<Position, FactionIndex>()
+                .ReadResource<SpatialIndex, FactionMatrix>()
+                .WriteResource<Perception>(),
+            [this](entt::registry&, ThreadPool&) { Perceive(); }
+        );
+        m_systems.Add(
+            "turns",
+            SystemAccess{}
+                .Write<Position, Actor>()
+                .ReadResource<TileMap, GoalFields, Perception>()
+                .WriteResource<TurnScheduler, SpatialIndex, LightMap>(),
+            [this](entt::registry&, ThreadPool&) { TakeTurns(); }
+        );
+        m_systems.Add(
+            "lighting",
+            SystemAccess{}
+                .Read<Position, LightSource>()
+                .ReadResource<TileMap>()
+                .WriteResource<LightMap>(),
+            [this](entt::registry&, ThreadPool&) { UpdateLights(); }
+        );
     }
 
-    void World::Update() { }
+    World::~World() {
+        m_lights.Disconnect(Registry);
+        m_faction_matrix.Disconnect(Registry);
+        m_turns.Disconnect(Registry);
+        m_spatial.Disconnect(Registry);
+    }
+
+    void World::Initialize(uint64_t seed) {
+        spdlog::info("Initializing world with seed {}", seed);
+
+        m_seed = seed;
+        m_level_size = Vec2{DEFAULT_MAP_WIDTH, DEFAULT_MAP_HEIGHT};
+        m_region_path.clear();
+        DefineBaseFactions(m_factions);
+        CompileFactions();
+        m_streamer.reset();
+        m_particles.Clear();
+        m_fields.resize(1);
+
+        DungeonSettings settings{};
+        settings.seed = seed;
+        settings.width = DEFAULT_MAP_WIDTH;
+        settings.height = DEFAULT_MAP_HEIGHT;
+        TeleportPlayer(GenerateDungeon(m_map, settings, &m_workers));
+        UpdateFields();
+        UpdateLights();
+    }
+
+    void World::InitializeStreamed(
+        const DungeonSettings& settings, const std::string& region_path
+    ) {
+        spdlog::info(
+            "Initializing streamed {}x{} world with seed {} in {}", settings.width, settings.height,
+            settings.seed, region_path
+        );
+
+        m_seed = settings.seed;
+        m_level_size = Vec2{settings.width, settings.height};
+        m_region_path = region_path;
+        DefineBaseFactions(m_factions);
+        CompileFactions();
+        m_streamer.reset();
+        m_particles.Clear();
+        m_fields.resize(1);
+        m_map.ResizeUnloaded(settings.width, settings.height);
+        m_streamer = std::make_unique<ChunkStreamer>(
+            m_map, region_path, DungeonFingerprint(settings),
+            [settings](int chunk_x, int chunk_y, TileChunk& chunk) {
+                GenerateDungeonChunk(settings, chunk_x, chunk_y, chunk);
+            },
+            STREAMING_RESIDENT_RADIUS, STREAMING_PREFETCH_MARGIN
+        );
+        TeleportPlayer(DungeonSpawn(settings));
+        UpdateFields();
+        UpdateLights();
+    }
+
+    void World::CompileFactions() {
+        m_faction_matrix.Compile(m_factions);
+        m_faction_matrix.Refresh(Registry);
+    }
+
+    auto World::MovePlayer(Vec2 dir) -> bool {
+        auto target = m_player_pos + dir;
+        if (!m_map.IsPassable(target)) { return false; }
+
+        m_player_pos = target;
+        if (m_streamer != nullptr) { m_streamer->Update(m_player_pos); }
+        m_fov.Update(m_map, m_player_pos, PLAYER_SIGHT_RADIUS);
+        return true;
+    }
+
+    void World::TeleportPlayer(Vec2 pos) {
+        m_player_pos = pos;
+        if (m_streamer != nullptr) { m_streamer->Prime(m_player_pos); }
+        m_fov.Recompute(m_map, m_player_pos, PLAYER_SIGHT_RADIUS);
+    }
+
+    auto World::AddGoal(Vec2 goal) -> size_t {
+        m_fields.emplace_back().goal = goal;
+        return m_fields.size() - 1;
+    }
+
+    void World::UpdateFields() {
+        m_fields.front().goal = m_player_pos;
+
+        // Each goal's flee field depends on its approach field, but separate goals are
+        // independent of each other.
+        m_workers.ParallelFor(m_fields.size(), 1, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; ++i) {
+                auto& fields = m_fields[i];
+                fields.approach.BuildApproach(m_map, fields.goal, DIJKSTRA_FIELD_RADIUS);
+                fields.flee.BuildFlee(m_map, fields.approach);
+            }
+        });
+    }
+
+    void World::Perceive() {
+        m_perception.Evaluate(
+            Registry, m_spatial, m_faction_matrix, m_player_pos, MONSTER_SIGHT_RADIUS, m_workers
+        );
+    }
+
+    void World::UpdateLights() { m_lights.Update(m_map, Registry, &m_workers); }
+
+    auto World::NextStep(entt::entity entity) const -> Vec2 {
+        const auto* position = Registry.try_get<Position>(entity);
+        if (position == nullptr) { return Vec2::Zero(); }
+
+        auto reaction = m_perception.ReactionOf(entity);
+        if (reaction.player) {
+            const auto& fields = PlayerFields();
+            switch (reaction.response) {
+            case Response::Attack:
+                return fields.approach.NextStep(position->pos);
+            case Response::Flee:
+                return fields.flee.NextStep(position->pos);
+            case Response::Ignore:
+                break;
+            }
+            return Vec2::Zero();
+        }
+
+        switch (reaction.response) {
+        case Response::Attack:
+            return StepTowards(position->pos, reaction.target);
+        case Response::Flee:
+            return -StepTowards(position->pos, reaction.target);
+        case Response::Ignore:
+            break;
+        }
+        return Vec2::Zero();
+    }
+
+    auto World::Save(const std::string& path, SaveCompression compression) -> bool {
+        if (m_streamer != nullptr && !m_streamer->StoreAll()) {
+            spdlog::error("Failed to store the level before saving to {}", path);
+            return false;
+        }
+
+        SaveState state{};
+        state.seed = m_seed;
+        state.region = m_region_path;
+        state.level_size = m_level_size;
+        state.player = m_player_pos;
+        state.clock = m_turns.Now();
+        state.turns_taken = m_turns_taken;
+        state.entities = Registry.alive();
+        m_turns.Settle(Registry);
+        CaptureRegistry(Registry, state.registry);
+        if (!WriteSaveFile(path, EncodeSave(state, compression))) {
+            spdlog::error("Failed to save to {}", path);
+            return false;
+        }
+        return true;
+    }
+
+    auto World::Load(const std::string& path) -> bool {
+        std::vector<uint8_t> bytes{};
+        if (!ReadSaveFile(path, bytes)) {
+            spdlog::error("Failed to read save {}", path);
+            return false;
+        }
+
+        entt::registry loaded{};
+        auto state = DecodeSave(bytes, loaded);
+        if (!state) {
+            spdlog::error("Save {} is corrupt or from an incompatible version", path);
+            return false;
+        }
+
+        if (state->region.empty()) {
+            Initialize(state->seed);
+        } else {
+            DungeonSettings settings{};
+            settings.seed = state->seed;
+            settings.width = state->level_size.X();
+            settings.height = state->level_size.Y();
+            if (settings.width <= 0 || settings.height <= 0) {
+                spdlog::error("Save {} has no level size", path);
+                return false;
+            }
+            try {
+                InitializeStreamed(settings, state->region);
+            } catch (const std::runtime_error& e) {
+                spdlog::error("Could not stream the level saved in {}: {}", path, e.what());
+                return false;
+            }
+        }
+        m_lights.Disconnect(Registry);
+        m_faction_matrix.Disconnect(Registry);
+        m_turns.Disconnect(Registry);
+        m_spatial.Disconnect(Registry);
+        Registry = std::move(loaded);
+        m_spatial.Connect(Registry);
+        m_turns.Clear(state->clock);
+        m_turns.Connect(Registry);
+        m_turns_taken = static_cast<size_t>(state->turns_taken);
+        m_faction_matrix.Connect(Registry);
+        m_lights.Connect(Registry);
+        TeleportPlayer(state->player);
+        UpdateFields();
+        UpdateLights();
+        spdlog::info("Loaded {} entities from {}", state->entities, path);
+        return true;
+    }
+
+    void World::Autosave(const std::string& path, SaveCompression compression) {
+        auto start = std::chrono::steady_clock::now();
+        auto state = std::make_unique<SaveState>();
+        state->seed = m_seed;
+        state->region = m_region_path;
+        state->level_size = m_level_size;
+        state->player = m_player_pos;
+        state->clock = m_turns.Now();
+        state->turns_taken = m_turns_taken;
+        state->entities = Registry.alive();
+        m_turns.Settle(Registry);
+        CaptureRegistry(Registry, state->registry);
+        std::chrono::duration<double, std::milli> capture =
+            std::chrono::steady_clock::now() - start;
+        m_autosaver.Save(path, std::move(state), compression, capture.count());
+    }
+
+    void World::TakeTurns() {
+        auto until = m_turns.Now() + TICKS_PER_TURN;
+        for (auto entity = m_turns.Pop(Registry, until); entity != entt::null;
+             entity = m_turns.Pop(Registry, until)) {
+            auto step = NextStep(entity);
+            if (step != Vec2::Zero()) {
+                auto target = Registry.get<Position>(entity).pos + step;
+                if (m_map.IsPassable(target)) {
+                    Registry.patch<Position>(entity, [&](Position& position) {
+                        position.pos = target;
+                    });
+                }
+            }
+            m_turns.Spend(Registry, entity);
+            ++m_turns_taken;
+        }
+    }
+
+    auto World::StateHash() const -> uint64_t {
+        auto hash = HashRegistry(Registry);
+        hash = Mix(hash ^ PackVec2(m_player_pos));
+        hash = Mix(hash ^ m_turns.Now());
+        return Mix(hash ^ m_turns_taken);
+    }
+
+    void World::Update() { m_systems.Run(Registry, m_workers); }
 } // namespace rglike
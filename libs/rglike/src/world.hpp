@@ -6,25 +6,219 @@
 
 #pragma once
 
+#include "chunk_streamer.hpp"
+#include "dijkstra_map.hpp"
+#include "dungeon.hpp"
+#include "factions.hpp"
+#include "fov.hpp"
+#include "light_map.hpp"
 #include "math.hpp"
+#include "particles.hpp"
+#include "pathfinding.hpp"
+#include "perception.hpp"
+#include "save_game.hpp"
+#include "spatial_index.hpp"
+#include "system_graph.hpp"
+#include "thread_pool.hpp"
+#include "tile_map.hpp"
+#include "turn_scheduler.hpp"
 
 #include "entt/entt.hpp"
 #include "ftxui/dom/elements.hpp"
 
+#include <deque>
+
 namespace rglike {
+    /// @brief The approach and flee fields around one goal.
+    struct GoalFields {
+        Vec2 goal{0, 0};
+        DijkstraMap approach;
+        DijkstraMap flee;
+    };
+
     class World {
     private:
+        uint64_t m_seed = 0;
+        Vec2 m_level_size{0, 0};
+        /// @brief Where a streamed level keeps its chunks; empty for levels generated whole.
+        std::string m_region_path;
         Vec2 m_player_pos{0, 0};
+        TileMap m_map;
+        /// @brief Set on streamed levels; declared after m_map so it is torn down first.
+        std::unique_ptr<ChunkStreamer> m_streamer;
+        FieldOfView m_fov;
+        ThreadPool m_workers;
+        Pathfinder m_pathfinder;
+        FactionTable m_factions;
+        FactionMatrix m_faction_matrix;
+        SpatialIndex m_spatial;
+        Perception m_perception;
+        LightMap m_lights;
+        ParticleLibrary m_particle_types;
+        ParticlePool m_particles;
+        TurnScheduler m_turns;
+        size_t m_turns_taken = 0;
+        /// @brief The systems Update() runs.
+        SystemGraph m_systems;
+        Autosaver m_autosaver;
+
+        /// @brief Fields for every goal entities can head towards or away from. The player's are
+        /// always first. A deque, so references to one goal's fields survive adding another.
+        std::deque<GoalFields> m_fields = std::deque<GoalFields>(1);
 
     public:
         entt::registry Registry;
 
+        World();
+        World(const World&) = delete;
+        auto operator=(const World&) -> World& = delete;
+        ~World();
+
         [[nodiscard]] inline auto PlayerPos() const -> Vec2 { return m_player_pos; }
 
-        inline void MovePlayer(Vec2 dir) { m_player_pos += dir; }
+        [[nodiscard]] inline auto Map() const -> const TileMap& { return m_map; }
+
+        [[nodiscard]] inline auto Map() -> TileMap& { return m_map; }
+
+        [[nodiscard]] inline auto Fov() const -> const FieldOfView& { return m_fov; }
+
+        [[nodiscard]] inline auto Factions() const -> const FactionTable& { return m_factions; }
+
+        /// @brief Call CompileFactions() after changing the table for monsters to notice.
+        [[nodiscard]] inline auto Factions() -> FactionTable& { return m_factions; }
+
+        /// @brief The faction table as monsters consult it.
+        [[nodiscard]] inline auto FactionResponses() const -> const FactionMatrix& {
+            return m_faction_matrix;
+        }
+
+        /// @brief Rebuilds the faction matrix from Factions() and re-interns every entity's
+        /// faction.
+        void CompileFactions();
+
+        /// @brief Every entity with a Position, bucketed by tile. Kept up to date as long as
+        /// positions are changed through `Registry.patch` or `Registry.replace`.
+        [[nodiscard]] inline auto Spatial() const -> const SpatialIndex& { return m_spatial; }
+
+        /// @brief The light cast by every entity with a LightSource, as of the last update.
+        [[nodiscard]] inline auto Lights() const -> const LightMap& { return m_lights; }
+
+        [[nodiscard]] inline auto ParticleTypes() const -> const ParticleLibrary& {
+            return m_particle_types;
+        }
+
+        /// @brief Spell effects on screen. Purely visual, so never saved or hashed.
+        [[nodiscard]] inline auto Particles() -> ParticlePool& { return m_particles; }
+
+        [[nodiscard]] inline auto Particles() const -> const ParticlePool& { return m_particles; }
+
+        /// @brief Whose turn it is among the entities with an Actor.
+        [[nodiscard]] inline auto Turns() const -> const TurnScheduler& { return m_turns; }
+
+        [[nodiscard]] inline auto PlayerFields() const -> const GoalFields& {
+            return m_fields.front();
+        }
+
+        /// @brief Adds a goal for entities to head towards or away from, whose fields are rebuilt
+        /// alongside the player's. Goals last until the level is reinitialized.
+        /// @return Its index for MoveGoal() and Fields(). The player is always goal 0.
+        auto AddGoal(Vec2 goal) -> size_t;
+
+        /// @brief Moves goal `index`; its fields catch up on the next UpdateFields().
+        inline void MoveGoal(size_t index, Vec2 goal) { m_fields.at(index).goal = goal; }
+
+        [[nodiscard]] inline auto GoalCount() const -> size_t { return m_fields.size(); }
+
+        [[nodiscard]] inline auto Fields(size_t index) const -> const GoalFields& {
+            return m_fields.at(index);
+        }
+
+        /// @brief How each monster reacted to what it could see at the start of the turn.
+        [[nodiscard]] inline auto Perceived() const -> const Perception& { return m_perception; }
+
+        /// @brief The step `entity` wants to take this turn, towards whatever it is attacking or
+        /// away from whatever it is fleeing. The player is approached and fled along the
+        /// player's fields; anyone else is stepped straight towards or away from. Zero if it
+        /// has no position, or saw nothing to react to.
+        [[nodiscard]] auto NextStep(entt::entity entity) const -> Vec2;
+
+        /// @brief Moves the player by `dir`, unless the destination tile is impassable.
+        /// @return Whether the player actually moved.
+        auto MovePlayer(Vec2 dir) -> bool;
+
+        /// @brief Places the player at `pos` regardless of what is in between.
+        void TeleportPlayer(Vec2 pos);
+
+        /// @brief Finds a path across the map. See PathSearch::Find.
+        inline auto FindPath(Vec2 from, Vec2 to, std::vector<Vec2>& steps) -> bool {
+            return m_pathfinder.FindPath(m_map, from, to, steps);
+        }
+
+        /// @brief Resolves a turn's worth of path queries across the worker threads.
+        inline void
+        FindPaths(const std::vector<PathQuery>& queries, std::vector<PathResult>& results) {
+            m_pathfinder.FindPaths(m_map, queries, results, &m_workers);
+        }
+
+        /// @brief Generates a fresh level from `seed` and places the player in it.
+        void Initialize(uint64_t seed);
+
+        /// @brief Starts a streamed level, for levels too big to keep in memory. Chunks are
+        /// generated from `settings` as the player nears them. Chunks further than
+        /// STREAMING_RESIDENT_RADIUS away are kept in the region file at `region_path`, which
+        /// carries the level over between runs.
+        /// @throws std::runtime_error if the region file can't be opened or holds another level.
+        void InitializeStreamed(const DungeonSettings& settings, const std::string& region_path);
+
+        /// @brief The streamer behind a streamed level, or null.
+        [[nodiscard]] inline auto Streaming() const -> const ChunkStreamer* {
+            return m_streamer.get();
+        }
+
+        /// @brief Saves the level seed, the player, the turn clock and the registry to `path`,
+        /// blocking until the file is written. A streamed level's chunks are written to its
+        /// region file first, and the save records where that file is.
+        auto Save(const std::string& path, SaveCompression compression = SaveCompression::Zstd)
+            -> bool;
+
+        /// @brief Regenerates the level saved in `path`, streaming it again if it was streamed,
+        /// and replaces the registry with its contents. The world is left untouched if the file
+        /// can't be read, but left without a level if a streamed level's region file can't be
+        /// opened. Streamed levels are restored with the default floor and wall tiles.
+        auto Load(const std::string& path) -> bool;
+
+        /// @brief Captures the registry and hands it to a background thread to encode and write
+        /// to `path`. Only the capture happens on the calling thread.
+        void Autosave(const std::string& path, SaveCompression compression = SaveCompression::Zstd);
+
+        /// @brief Blocks until any pending autosave has been written.
+        inline void WaitForAutosave() { m_autosaver.Wait(); }
+
+        /// @brief Rebuilds the approach and flee fields around every goal.
+        void UpdateFields();
+
+        /// @brief Decides how every monster reacts to what it can see. See Perception.
+        void Perceive();
+
+        /// @brief Recasts the lights that moved or changed, or that an edited tile is in reach of.
+        void UpdateLights();
+
+        /// @brief Lets every actor due within the next TICKS_PER_TURN ticks take its turn,
+        /// stepping as NextStep() suggests.
+        void TakeTurns();
+
+        /// @brief How many turns actors have taken in total.
+        [[nodiscard]] inline auto TurnsTaken() const -> size_t { return m_turns_taken; }
+
+        /// @brief A fingerprint of the world's state, for checking that two runs agree: the
+        /// registry, the player, and the turn clock. The level itself is implied by its seed.
+        [[nodiscard]] auto StateHash() const -> uint64_t;
 
-        void Initialize();
+        /// @brief The systems run by Update(), with how long each took last time.
+        [[nodiscard]] inline auto Systems() const -> const SystemGraph& { return m_systems; }
 
+        /// @brief Advances the world by one player turn, running every system on the worker
+        /// threads.
         void Update();
     };
 } // namespace rglike
@@ -0,0 +1,36 @@
+/**
+ * @file alloc_counter.cpp
+ * @author Alic Szecsei
+ * @date 7/24/2023
+ */
+
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<size_t> allocations{0};
+} // namespace
+
+// Kept out of the test sources so the compiler never sees these paired with an inlined caller.
+auto operator new(size_t size) -> void* {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+auto operator new[](size_t size) -> void* { return operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace rglike::test {
+    auto Allocations() -> size_t { return allocations.load(std::memory_order_relaxed); }
+} // namespace rglike::test
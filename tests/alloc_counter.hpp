@@ -0,0 +1,15 @@
+/**
+ * @file alloc_counter.hpp
+ * @author Alic Szecsei
+ * @date 7/24/2023
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace rglike::test {
+    /// @brief Heap allocations made through `operator new` since the program started, for tests
+    /// that check a path doesn't allocate.
+    auto Allocations() -> size_t;
+} // namespace rglike::test
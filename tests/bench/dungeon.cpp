@@ -0,0 +1,26 @@
+/**
+ * @file dungeon.cpp
+ * @author Alic Szecsei
+ * @date 6/29/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <dungeon.hpp>
+
+using namespace rglike;
+
+TEST_CASE("Dungeon generation", "[bench][dungeon]") {
+    DungeonSettings settings{};
+    settings.seed = 1234;
+
+    TileMap map{};
+    ThreadPool pool{};
+
+    settings.width = settings.height = 256;
+    BENCHMARK("256 x 256") { return GenerateDungeon(map, settings); };
+    BENCHMARK("256 x 256, thread pool") { return GenerateDungeon(map, settings, &pool); };
+
+    settings.width = settings.height = 2048;
+    BENCHMARK("2048 x 2048") { return GenerateDungeon(map, settings); };
+    BENCHMARK("2048 x 2048, thread pool") { return GenerateDungeon(map, settings, &pool); };
+}
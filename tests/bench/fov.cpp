@@ -0,0 +1,50 @@
+/**
+ * @file fov.cpp
+ * @author Alic Szecsei
+ * @date 6/17/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <fov.hpp>
+#include <random>
+#include <string>
+
+using namespace rglike;
+
+TEST_CASE("FieldOfView", "[bench][fov]") {
+    constexpr int size = 1024;
+    const Tile floor{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false};
+    const Tile wall{U'#', ftxui::Color::Default, ftxui::Color::Default, false, true};
+
+    // A large open level, and the same level with a light scattering of pillars.
+    TileMap open{size, size, floor};
+    TileMap pillars{size, size, floor};
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> coord{0, size - 1};
+    for (int i = 0; i < size * size / 50; ++i) { pillars.Set(Vec2{coord(rng), coord(rng)}, wall); }
+
+    const Vec2 start{size / 2, size / 2};
+    for (const auto* map : {&open, &pillars}) {
+        std::string level = map == &open ? "open" : "pillars";
+        for (int radius : {8, 16, 32, 64}) {
+            auto suffix = level + ", radius " + std::to_string(radius);
+            FieldOfView fov{};
+            fov.Recompute(*map, start, radius);
+
+            int step = 0;
+            BENCHMARK("step move, " + suffix) {
+                // Walk back and forth so every iteration is a one-tile step. A step recasts the
+                // whole radius, so the 100us per move budget is only promised at
+                // PLAYER_SIGHT_RADIUS (16); radius 64 goes over it.
+                Vec2 pos = start + Vec2{(step++ & 1), 0};
+                fov.Update(*map, pos, radius);
+                return fov.IsVisible(pos);
+            };
+
+            BENCHMARK("teleport, " + suffix) {
+                fov.Recompute(*map, start, radius);
+                return fov.IsVisible(start);
+            };
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * @file game_log.cpp
+ * @author Alic Szecsei
+ * @date 7/25/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <constants.hpp>
+#include <game_log.hpp>
+#include <ui/log_layout_cache.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rglike;
+
+TEST_CASE("Game log", "[bench][render]") {
+    constexpr int width = 80;
+    constexpr int height = LOG_HEIGHT;
+
+    auto& log = GameLog::GetInstance();
+    log.Clear();
+    for (int i = 0; i < MAX_LOG_LINES; ++i) {
+        log.Entry()
+            .Text("The goblin ")
+            .Color(ftxui::Color::Red)
+            .Text("hits")
+            .Color(ftxui::Color::Default)
+            .Text(" you for " + std::to_string(i) + " damage, and you feel a little less sure.")
+            .Log();
+        log.Drain();
+    }
+
+    BENCHMARK("enqueue a line") {
+        auto queued = log.Entry().Text("The goblin ").Color(ftxui::Color::Red).Text("misses").Log();
+        if (!queued) { log.Drain(); }
+        return queued;
+    };
+    log.Drain();
+
+    BENCHMARK("enqueue 16x1000 lines from 16 threads") {
+        std::atomic<int> finished{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < 16; ++p) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 1000; ++i) {
+                    auto entry = log.Entry().Text("The goblin ").Text("misses");
+                    while (!entry.Log()) { std::this_thread::yield(); }
+                }
+                finished.fetch_add(1);
+            });
+        }
+        size_t drained = 0;
+        while (finished.load() < 16) { drained += log.Drain(); }
+        for (auto& thread : threads) { thread.join(); }
+        return drained + log.Drain();
+    };
+
+    BENCHMARK("lay out every line") {
+        size_t rows = 0;
+        for (size_t i = 0; i < log.Size(); ++i) {
+            rows += ui::LogLayoutCache::Wrap(log, log.Line(i), width).size();
+        }
+        return rows;
+    };
+
+    ui::LogLayoutCache cache{};
+    for (int i = 0; i < height; ++i) { (void)cache.Rows(log, i, width); }
+
+    BENCHMARK("cached visible lines") {
+        size_t rows = 0;
+        for (int i = 0; i < height; ++i) { rows += cache.Rows(log, i, width).size(); }
+        return rows;
+    };
+
+    log.Clear();
+}
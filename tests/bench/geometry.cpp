@@ -0,0 +1,102 @@
+/**
+ * @file geometry.cpp
+ * @author Alic Szecsei
+ * @date 7/14/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <geometry.hpp>
+#include <random>
+
+using namespace rglike;
+
+TEST_CASE("Geometry kernels", "[bench][geometry]") {
+    constexpr size_t count = 1'000'000;
+
+    std::mt19937 rng{8642};
+    std::uniform_int_distribution<int> coord{-2048, 2047};
+    std::vector<Vec2> vecs{};
+    PositionBuffer positions{};
+    vecs.reserve(count);
+    positions.Reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        vecs.emplace_back(coord(rng), coord(rng));
+        positions.Push(vecs.back());
+    }
+
+    const Vec2 from{13, -7};
+    const Rect bounds{Vec2{-500, -300}, Vec2{700, 900}};
+    std::vector<int32_t> distances(count);
+    std::vector<uint64_t> keys(count);
+    std::vector<uint32_t> inside{};
+
+    BENCHMARK("1M Chebyshev, Vec2 operators") {
+        for (size_t i = 0; i < count; ++i) {
+            auto delta = vecs[i] - from;
+            distances[i] = std::max(std::abs(delta.X()), std::abs(delta.Y()));
+        }
+        return distances.back();
+    };
+
+    BENCHMARK("1M bounds cull, Vec2 operators") {
+        inside.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (bounds.Contains(vecs[i])) { inside.push_back(static_cast<uint32_t>(i)); }
+        }
+        return inside.size();
+    };
+
+    BENCHMARK("1M PackVec2, Vec2 operators") {
+        for (size_t i = 0; i < count; ++i) { keys[i] = PackVec2(vecs[i]); }
+        return keys.back();
+    };
+
+    for (auto level : {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2}) {
+        if (level > BestSimdLevel()) { continue; }
+        const auto label = [&](const char* what) {
+            return fmt::format("1M {}, {}", what, SimdLevelName(level));
+        };
+
+        BENCHMARK(label("Chebyshev")) {
+            ChebyshevDistances(positions, from, distances.data(), level);
+            return distances.back();
+        };
+
+        BENCHMARK(label("Manhattan")) {
+            ManhattanDistances(positions, from, distances.data(), level);
+            return distances.back();
+        };
+
+        BENCHMARK(label("bounds cull")) {
+            SelectInRect(positions, bounds, inside, level);
+            return inside.size();
+        };
+
+        BENCHMARK(label("PackVec2")) {
+            PackPositions(positions, keys.data(), level);
+            return keys.back();
+        };
+    }
+
+    PositionBuffer area{};
+    BENCHMARK("radius 16 circle") {
+        area.Clear();
+        RasterizeCircle(from, 16, area);
+        return area.Size();
+    };
+
+    BENCHMARK("radius 16, 30 degree cone") {
+        area.Clear();
+        RasterizeCone(from, Vec2{40, 3}, 16, 30.0, area);
+        return area.Size();
+    };
+
+    std::vector<Vec2> starts(1024, from);
+    std::vector<Vec2> ends{vecs.begin(), vecs.begin() + 1024};
+    std::vector<uint32_t> offsets{};
+    BENCHMARK("1024 supercover lines") {
+        area.Clear();
+        TraceLines(starts, ends, LineKind::Supercover, area, offsets);
+        return area.Size();
+    };
+}
@@ -0,0 +1,83 @@
+/**
+ * @file lighting.cpp
+ * @author Alic Szecsei
+ * @date 7/21/2023
+ */
+
+#include <array>
+#include <catch2/catch.hpp>
+#include <dungeon.hpp>
+#include <light_map.hpp>
+#include <random>
+
+using namespace rglike;
+
+TEST_CASE("LightMap", "[bench][lighting]") {
+    constexpr int torch_count = 200;
+
+    // About one screen's worth of level, with the torches crowded into it.
+    DungeonSettings settings{};
+    settings.seed = 99;
+    settings.width = 200;
+    settings.height = 60;
+    TileMap map{};
+    GenerateDungeon(map, settings);
+
+    ThreadPool pool{};
+    entt::registry registry{};
+    LightMap lights{};
+    lights.Connect(registry);
+
+    std::mt19937 rng{8642};
+    std::uniform_int_distribution<int> x{0, settings.width - 1};
+    std::uniform_int_distribution<int> y{0, settings.height - 1};
+    std::vector<entt::entity> torches{};
+    while (torches.size() < torch_count) {
+        Vec2 pos{x(rng), y(rng)};
+        if (!map.IsPassable(pos)) { continue; }
+        auto entity = registry.create();
+        registry.emplace<Position>(entity, pos);
+        registry.emplace<LightSource>(entity);
+        torches.push_back(entity);
+    }
+    lights.Update(map, registry, &pool);
+
+    const std::array<Vec2, 4> steps{Vec2::Up(), Vec2::Right(), Vec2::Down(), Vec2::Left()};
+    std::uniform_int_distribution<int> direction{0, 3};
+    const auto wander = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            auto target = registry.get<Position>(torches[i]).pos + steps[direction(rng)];
+            if (!map.IsPassable(target)) { continue; }
+            registry.patch<Position>(torches[i], [&](Position& position) {
+                position.pos = target;
+            });
+        }
+    };
+
+    BENCHMARK("200 torches, all moving") {
+        wander(torches.size());
+        return lights.Update(map, registry, &pool);
+    };
+
+    BENCHMARK("200 torches, 10 moving") {
+        wander(10);
+        return lights.Update(map, registry, &pool);
+    };
+
+    int toggle = 0;
+    BENCHMARK("200 torches, one wall toggled") {
+        Vec2 pos{settings.width / 2, settings.height / 2};
+        map.SetOpaque(pos, (++toggle & 1) != 0);
+        lights.InvalidateArea(Rect{pos, pos + Vec2::One()});
+        return lights.Update(map, registry, &pool);
+    };
+
+    BENCHMARK("200 torches, full recast") {
+        for (auto torch : torches) {
+            registry.patch<LightSource>(torch, [](LightSource&) {});
+        }
+        return lights.Update(map, registry, &pool);
+    };
+
+    lights.Disconnect(registry);
+}
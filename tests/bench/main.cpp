@@ -0,0 +1,63 @@
+/**
+ * @file main.cpp
+ * @author Alic Szecsei
+ * @date 6/12/2023
+ */
+
+#define CATCH_CONFIG_RUNNER
+#include "results.hpp"
+
+#include <catch2/catch.hpp>
+#include <iostream>
+
+auto main(int argc, char* argv[]) -> int {
+    Catch::Session session{};
+
+    std::string json_path{};
+    std::string baseline_path{};
+    double max_regression = 50.0;
+    auto cli = session.cli() |
+               Catch::clara::Opt(json_path, "file")["--json"]("write benchmark results as JSON") |
+               Catch::clara::Opt(baseline_path, "file")["--baseline"](
+                   "fail if a benchmark is slower than in these results"
+               ) |
+               Catch::clara::Opt(max_regression, "percent")["--max-regression"](
+                   "how much slower than the baseline counts as a regression (default 50)"
+               );
+    session.cli(cli);
+
+    auto status = session.applyCommandLine(argc, argv);
+    if (status != 0) { return status; }
+
+    auto failures = session.run();
+    const auto& results = rglike::bench::RecordedResults();
+
+    if (!json_path.empty() && !rglike::bench::WriteResults(json_path, results)) {
+        std::cerr << "Couldn't write benchmark results to " << json_path << '\n';
+        return 1;
+    }
+
+    if (!baseline_path.empty()) {
+        auto baseline = rglike::bench::LoadResults(baseline_path);
+        if (!baseline) {
+            std::cerr << "Couldn't read baseline results from " << baseline_path << '\n';
+            return 1;
+        }
+        if (baseline->empty()) {
+            // An empty baseline would pass every run, which is worse than having no gate at all.
+            std::cerr << "No baseline results in " << baseline_path
+                      << "; record them from a Release build with --json\n";
+            return 1;
+        }
+        std::cout << "Compared with " << baseline_path << " (max regression " << max_regression
+                  << "%):\n";
+        auto regressions =
+            rglike::bench::CompareResults(*baseline, results, max_regression, std::cout);
+        if (regressions > 0) {
+            std::cout << regressions << " benchmark(s) regressed or didn't run\n";
+            return 1;
+        }
+    }
+
+    return failures;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file math.cpp
+ * @author Alic Szecsei
+ * @date 7/27/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <math.hpp>
+#include <random>
+#include <vector>
+
+using namespace rglike;
+
+TEST_CASE("Vec2 arithmetic", "[bench][math]") {
+    constexpr size_t count = 100'000;
+
+    std::mt19937 rng{1357};
+    std::uniform_int_distribution<int> coord{-2048, 2047};
+    std::vector<Vec2> vecs{};
+    vecs.reserve(count);
+    for (size_t i = 0; i < count; ++i) { vecs.emplace_back(coord(rng), coord(rng)); }
+
+    const Vec2 origin{13, -7};
+
+    BENCHMARK("add and subtract 100k") {
+        auto total = Vec2::Zero();
+        for (const auto& vec : vecs) { total += vec - origin; }
+        return total;
+    };
+
+    BENCHMARK("scale and pack 100k") {
+        uint64_t keys = 0;
+        for (const auto& vec : vecs) { keys ^= PackVec2(vec * 3 / 2); }
+        return keys;
+    };
+
+    BENCHMARK("length squared 100k") {
+        double total = 0.0;
+        for (const auto& vec : vecs) { total += (vec - origin).LengthSquared(); }
+        return total;
+    };
+
+    BENCHMARK("compare 100k") {
+        size_t same = 0;
+        for (const auto& vec : vecs) { same += vec == origin ? 1 : 0; }
+        return same;
+    };
+}
@@ -0,0 +1,62 @@
+/**
+ * @file pathfinding.cpp
+ * @author Alic Szecsei
+ * @date 6/20/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <pathfinding.hpp>
+#include <random>
+
+using namespace rglike;
+
+TEST_CASE("Pathfinding", "[bench][pathfinding]") {
+    constexpr int size = 256;
+    constexpr int query_count = 500;
+    const Tile floor{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false};
+
+    TileMap map{size, size, floor};
+    std::mt19937 rng{99};
+    std::uniform_int_distribution<int> coord{0, size - 1};
+    for (int i = 0; i < size * size / 8; ++i) {
+        map.SetPassable(Vec2{coord(rng), coord(rng)}, false);
+    }
+
+    std::vector<PathQuery> queries{};
+    // Monsters chasing something a screen or so away, rather than across the whole map.
+    std::uniform_int_distribution<int> offset{-40, 40};
+    while (queries.size() < query_count) {
+        Vec2 from{coord(rng), coord(rng)};
+        Vec2 to = from + Vec2{offset(rng), offset(rng)};
+        if (map.IsPassable(from) && map.IsPassable(to)) { queries.push_back(PathQuery{from, to}); }
+    }
+
+    Pathfinder pathfinder{};
+    std::vector<PathResult> results{};
+
+    BENCHMARK("500 queries, jump point search") {
+        pathfinder.FindPaths(map, queries, results);
+        return results.front().found;
+    };
+
+    ThreadPool pool{};
+    BENCHMARK("500 queries, jump point search, thread pool") {
+        pathfinder.FindPaths(map, queries, results, &pool);
+        return results.front().found;
+    };
+
+    TileMap weighted = map;
+    for (int i = 0; i < size * size / 10; ++i) {
+        weighted.SetMoveCost(Vec2{coord(rng), coord(rng)}, 3);
+    }
+
+    BENCHMARK("500 queries, weighted A*") {
+        pathfinder.FindPaths(weighted, queries, results);
+        return results.front().found;
+    };
+
+    BENCHMARK("500 queries, weighted A*, thread pool") {
+        pathfinder.FindPaths(weighted, queries, results, &pool);
+        return results.front().found;
+    };
+}
@@ -0,0 +1,73 @@
+/**
+ * @file perception.cpp
+ * @author Alic Szecsei
+ * @date 7/19/2023
+ */
+
+#include <array>
+#include <catch2/catch.hpp>
+#include <perception.hpp>
+#include <random>
+
+using namespace rglike;
+
+TEST_CASE("Perception", "[bench][perception]") {
+    constexpr int npc_count = 10'000;
+    constexpr int size = 512;
+    constexpr int radius = 12;
+    // Ogres aren't defined, so they take the fallback path through both tables.
+    constexpr std::array<const char*, 4> faction_names{"mindless", "townsfolk", "bandits", "ogres"};
+
+    FactionTable table{};
+    DefineBaseFactions(table);
+    FactionMatrix matrix{};
+    matrix.Compile(table);
+
+    entt::registry registry{};
+    SpatialIndex spatial{};
+    spatial.Connect(registry);
+    matrix.Connect(registry);
+
+    std::mt19937 rng{2468};
+    std::uniform_int_distribution<int> coord{0, size - 1};
+    for (int i = 0; i < npc_count; ++i) {
+        auto entity = registry.create();
+        registry.emplace<Position>(entity, Vec2{coord(rng), coord(rng)});
+        registry.emplace<FactionMember>(
+            entity, FactionMember{faction_names[i % faction_names.size()]}
+        );
+    }
+    const Vec2 player{size / 2, size / 2};
+
+    ThreadPool serial{0};
+    ThreadPool parallel{};
+    Perception perception{};
+
+    BENCHMARK("10k NPCs, matrix, 1 thread") {
+        perception.Evaluate(registry, spatial, matrix, player, radius, serial);
+        return perception.Pairs();
+    };
+
+    BENCHMARK("10k NPCs, matrix, all threads") {
+        perception.Evaluate(registry, spatial, matrix, player, radius, parallel);
+        return perception.Pairs();
+    };
+
+    // The same spatial queries, with every pair resolved through the string-keyed table.
+    BENCHMARK("10k NPCs, string lookups, 1 thread") {
+        size_t hostile = 0;
+        for (auto entity : registry.view<Position, FactionMember>()) {
+            const auto& self = registry.get<FactionMember>(entity).faction;
+            auto pos = registry.get<Position>(entity).pos;
+            spatial.QueryRadius(pos, radius, [&](entt::entity other, Vec2) {
+                if (other == entity) { return; }
+                const auto& faction = registry.get<FactionMember>(other).faction;
+                if (table.ResponseTo(self, faction) != Response::Ignore) { ++hostile; }
+            });
+        }
+        return hostile;
+    };
+
+    matrix.Disconnect(registry);
+    spatial.Disconnect(registry);
+}
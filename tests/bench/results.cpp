@@ -0,0 +1,239 @@
+/**
+ * @file results.cpp
+ * @author Alic Szecsei
+ * @date 7/27/2023
+ */
+
+#include "results.hpp"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace rglike::bench {
+    namespace {
+        auto Results() -> std::vector<BenchmarkResult>& {
+            static std::vector<BenchmarkResult> results{};
+            return results;
+        }
+
+        auto Nanoseconds(std::chrono::duration<double, std::nano> duration) -> double {
+            return duration.count();
+        }
+
+        /// @brief Records every benchmark as it finishes, whichever reporter is printing them.
+        class BenchmarkRecorder : public Catch::TestEventListenerBase {
+        private:
+            std::string m_test_case;
+
+        public:
+            using TestEventListenerBase::TestEventListenerBase;
+
+            void testCaseStarting(const Catch::TestCaseInfo& info) override {
+                TestEventListenerBase::testCaseStarting(info);
+                m_test_case = info.name;
+            }
+
+            void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override {
+                Results().push_back(BenchmarkResult{
+                    m_test_case + " / " + stats.info.name,
+                    Nanoseconds(stats.mean.point),
+                    Nanoseconds(stats.mean.lower_bound),
+                    Nanoseconds(stats.mean.upper_bound),
+                    Nanoseconds(stats.standardDeviation.point),
+                    stats.samples.size(),
+                });
+            }
+        };
+
+        void WriteString(std::ostream& out, const std::string& text) {
+            out << '"';
+            for (auto c : text) {
+                if (c == '"' || c == '\\') {
+                    out << '\\' << c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                        << static_cast<int>(c) << std::dec << std::setfill(' ');
+                } else {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+
+        /// @brief Just enough JSON to read back what WriteResults writes.
+        class JsonReader {
+        private:
+            std::string m_text;
+            size_t m_pos = 0;
+
+            void SkipSpace() {
+                while (m_pos < m_text.size() &&
+                       std::isspace(static_cast<unsigned char>(m_text[m_pos]))) {
+                    ++m_pos;
+                }
+            }
+
+        public:
+            explicit JsonReader(std::string text)
+                : m_text(std::move(text)) { }
+
+            auto Consume(char c) -> bool {
+                SkipSpace();
+                if (m_pos < m_text.size() && m_text[m_pos] == c) {
+                    ++m_pos;
+                    return true;
+                }
+                return false;
+            }
+
+            auto String() -> std::optional<std::string> {
+                if (!Consume('"')) { return std::nullopt; }
+                std::string result{};
+                while (m_pos < m_text.size() && m_text[m_pos] != '"') {
+                    auto c = m_text[m_pos++];
+                    if (c == '\\' && m_pos < m_text.size()) {
+                        c = m_text[m_pos++];
+                        if (c == 'u' && m_pos + 4 <= m_text.size()) {
+                            auto code = m_text.substr(m_pos, 4);
+                            c = static_cast<char>(std::strtol(code.c_str(), nullptr, 16));
+                            m_pos += 4;
+                        }
+                    }
+                    result += c;
+                }
+                if (!Consume('"')) { return std::nullopt; }
+                return result;
+            }
+
+            auto Number() -> std::optional<double> {
+                SkipSpace();
+                const char* start = m_text.c_str() + m_pos;
+                char* end = nullptr;
+                auto value = std::strtod(start, &end);
+                if (end == start) { return std::nullopt; }
+                m_pos += static_cast<size_t>(end - start);
+                return value;
+            }
+        };
+
+        auto ParseResult(JsonReader& reader) -> std::optional<BenchmarkResult> {
+            if (!reader.Consume('{')) { return std::nullopt; }
+            BenchmarkResult result{};
+            std::map<std::string, double*> numbers{
+                {"mean_ns",    &result.mean_ns   },
+                {"low_ns",     &result.low_ns    },
+                {"high_ns",    &result.high_ns   },
+                {"std_dev_ns", &result.std_dev_ns},
+            };
+            do {
+                auto key = reader.String();
+                if (!key || !reader.Consume(':')) { return std::nullopt; }
+                if (*key == "name") {
+                    auto name = reader.String();
+                    if (!name) { return std::nullopt; }
+                    result.name = *name;
+                    continue;
+                }
+                auto value = reader.Number();
+                if (!value) { return std::nullopt; }
+                if (*key == "samples") { result.samples = static_cast<size_t>(*value); }
+                auto field = numbers.find(*key);
+                if (field != numbers.end()) { *field->second = *value; }
+            } while (reader.Consume(','));
+            if (!reader.Consume('}')) { return std::nullopt; }
+            return result;
+        }
+    } // namespace
+
+    CATCH_REGISTER_LISTENER(BenchmarkRecorder)
+
+    auto RecordedResults() -> const std::vector<BenchmarkResult>& { return Results(); }
+
+    auto WriteResults(const std::string& path, const std::vector<BenchmarkResult>& results)
+        -> bool {
+        std::ofstream out(path);
+        if (!out) { return false; }
+
+        out << std::setprecision(6) << std::fixed;
+        out << "{\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& result = results[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+            WriteString(out, result.name);
+            out << ", \"mean_ns\": " << result.mean_ns << ", \"low_ns\": " << result.low_ns
+                << ", \"high_ns\": " << result.high_ns << ", \"std_dev_ns\": " << result.std_dev_ns
+                << ", \"samples\": " << result.samples << "}";
+        }
+        out << "\n  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+    auto LoadResults(const std::string& path) -> std::optional<std::vector<BenchmarkResult>> {
+        std::ifstream in(path);
+        if (!in) { return std::nullopt; }
+        std::stringstream text{};
+        text << in.rdbuf();
+
+        JsonReader reader(text.str());
+        if (!reader.Consume('{')) { return std::nullopt; }
+        auto key = reader.String();
+        if (!key || *key != "benchmarks" || !reader.Consume(':') || !reader.Consume('[')) {
+            return std::nullopt;
+        }
+
+        std::vector<BenchmarkResult> results{};
+        if (!reader.Consume(']')) {
+            do {
+                auto result = ParseResult(reader);
+                if (!result) { return std::nullopt; }
+                results.push_back(std::move(*result));
+            } while (reader.Consume(','));
+            if (!reader.Consume(']')) { return std::nullopt; }
+        }
+        return results;
+    }
+
+    auto CompareResults(
+        const std::vector<BenchmarkResult>& baseline, const std::vector<BenchmarkResult>& current,
+        double max_regression, std::ostream& out
+    ) -> size_t {
+        std::map<std::string, const BenchmarkResult*> before{};
+        for (const auto& result : baseline) { before.emplace(result.name, &result); }
+
+        std::set<std::string> ran{};
+        for (const auto& result : current) { ran.insert(result.name); }
+
+        size_t failures = 0;
+        for (const auto& result : baseline) {
+            // A benchmark that stopped running, or was renamed, would otherwise quietly drop out
+            // of the gate.
+            if (ran.count(result.name) == 0) {
+                ++failures;
+                out << "  MISSING    " << result.name << '\n';
+            }
+        }
+
+        for (const auto& result : current) {
+            auto found = before.find(result.name);
+            if (found == before.end() || found->second->mean_ns <= 0.0) {
+                out << "  new        " << result.name << '\n';
+                continue;
+            }
+
+            auto change = (result.mean_ns / found->second->mean_ns - 1.0) * 100.0;
+            auto regressed = change > max_regression;
+            if (regressed) { ++failures; }
+            out << (regressed ? "  REGRESSED " : "  ok        ") << std::showpos << std::fixed
+                << std::setprecision(1) << std::setw(7) << change << "% " << std::noshowpos
+                << result.name << '\n';
+        }
+        return failures;
+    }
+} // namespace rglike::bench
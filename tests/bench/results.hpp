@@ -0,0 +1,44 @@
+/**
+ * @file results.hpp
+ * @author Alic Szecsei
+ * @date 7/27/2023
+ */
+
+#pragma once
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace rglike::bench {
+    /// @brief One benchmark's timings, in nanoseconds per run.
+    struct BenchmarkResult {
+        /// @brief The test case and benchmark names, joined by " / ".
+        std::string name;
+        double mean_ns = 0.0;
+        double low_ns = 0.0;
+        double high_ns = 0.0;
+        double std_dev_ns = 0.0;
+        size_t samples = 0;
+    };
+
+    /// @brief Every benchmark that has finished so far in this run.
+    auto RecordedResults() -> const std::vector<BenchmarkResult>&;
+
+    /// @brief Writes `results` as JSON.
+    auto WriteResults(const std::string& path, const std::vector<BenchmarkResult>& results)
+        -> bool;
+
+    /// @brief Reads results written by WriteResults.
+    auto LoadResults(const std::string& path) -> std::optional<std::vector<BenchmarkResult>>;
+
+    /// @brief Reports every benchmark in `current` whose mean is more than `max_regression`
+    /// percent slower than in `baseline`, and every benchmark in `baseline` that didn't run.
+    /// Benchmarks missing from the baseline are only noted.
+    /// @return How many regressed or went missing.
+    auto CompareResults(
+        const std::vector<BenchmarkResult>& baseline, const std::vector<BenchmarkResult>& current,
+        double max_regression, std::ostream& out
+    ) -> size_t;
+} // namespace rglike::bench
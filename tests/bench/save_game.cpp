@@ -0,0 +1,50 @@
+/**
+ * @file save_game.cpp
+ * @author Alic Szecsei
+ * @date 7/5/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <random>
+#include <save_game.hpp>
+
+using namespace rglike;
+
+TEST_CASE("Save game", "[bench][save_game]") {
+    constexpr int entity_count = 100'000;
+
+    entt::registry registry{};
+    std::mt19937 rng{2468};
+    std::uniform_int_distribution<int> coord{0, 2047};
+    const std::array<const char*, 3> factions{"goblins", "rats", "villagers"};
+    for (int i = 0; i < entity_count; ++i) {
+        auto entity = registry.create();
+        registry.emplace<Position>(entity, Vec2{coord(rng), coord(rng)});
+        registry.emplace<FactionMember>(entity, FactionMember{factions[i % factions.size()]});
+    }
+
+    SaveState state{};
+    state.seed = 99;
+    CaptureRegistry(registry, state.registry);
+
+    BENCHMARK("capture 100k entities") {
+        SnapshotTape tape{};
+        tape.ReserveLike(state.registry);
+        CaptureRegistry(registry, tape);
+        return tape;
+    };
+
+    BENCHMARK("encode 100k entities, uncompressed") {
+        return EncodeSave(state, SaveCompression::None).size();
+    };
+
+    BENCHMARK("encode 100k entities, zstd") {
+        return EncodeSave(state, SaveCompression::Zstd).size();
+    };
+
+    auto bytes = EncodeSave(state, SaveCompression::Zstd);
+    BENCHMARK("decode 100k entities") {
+        entt::registry loaded{};
+        return DecodeSave(bytes, loaded).has_value();
+    };
+}
@@ -0,0 +1,91 @@
+/**
+ * @file spatial_index.cpp
+ * @author Alic Szecsei
+ * @date 6/27/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <components.hpp>
+#include <random>
+#include <spatial_index.hpp>
+
+using namespace rglike;
+
+TEST_CASE("Spatial index queries", "[bench][spatial_index]") {
+    constexpr int size = 1024;
+    constexpr int radius = 8;
+    constexpr int query_count = 256;
+
+    auto entity_count = GENERATE(10'000, 100'000, 1'000'000);
+
+    entt::registry registry{};
+    SpatialIndex index{};
+    index.Connect(registry);
+
+    std::mt19937 rng{4321};
+    std::uniform_int_distribution<int> coord{0, size - 1};
+    for (int i = 0; i < entity_count; ++i) {
+        registry.emplace<Position>(registry.create(), Vec2{coord(rng), coord(rng)});
+    }
+
+    std::vector<Vec2> centers{};
+    for (int i = 0; i < query_count; ++i) { centers.emplace_back(coord(rng), coord(rng)); }
+
+    const auto label = [&](const char* what, int queries) {
+        return fmt::format("{}k entities, {} x{}", entity_count / 1000, what, queries);
+    };
+
+    BENCHMARK(label("point, index", query_count)) {
+        size_t found = 0;
+        for (const auto& center : centers) {
+            index.QueryPoint(center, [&](entt::entity, Vec2) { ++found; });
+        }
+        return found;
+    };
+
+    BENCHMARK(label("radius 8, index", query_count)) {
+        size_t found = 0;
+        for (const auto& center : centers) {
+            index.QueryRadius(center, radius, [&](entt::entity, Vec2) { ++found; });
+        }
+        return found;
+    };
+
+    // The naive scans are so slow at the top end that only a handful of queries are timed.
+    BENCHMARK(label("point, view scan", query_count / 16)) {
+        size_t found = 0;
+        for (int i = 0; i < query_count / 16; ++i) {
+            for (auto [entity, position] : registry.view<Position>().each()) {
+                if (position.pos == centers[i]) { ++found; }
+            }
+        }
+        return found;
+    };
+
+    BENCHMARK(label("radius 8, view scan", query_count / 16)) {
+        size_t found = 0;
+        for (int i = 0; i < query_count / 16; ++i) {
+            for (auto [entity, position] : registry.view<Position>().each()) {
+                if ((position.pos - centers[i]).LengthSquared() <= radius * radius) { ++found; }
+            }
+        }
+        return found;
+    };
+
+    std::vector<entt::entity> movers{};
+    for (auto entity : registry.view<Position>()) {
+        if (movers.size() == 4096) { break; }
+        movers.push_back(entity);
+    }
+
+    BENCHMARK(label("patch Position", 4096)) {
+        for (auto entity : movers) {
+            registry.patch<Position>(entity, [](Position& position) {
+                position.pos = Vec2{position.pos.X() ^ 1, position.pos.Y()};
+            });
+        }
+        return index.Size();
+    };
+
+    index.Disconnect(registry);
+}
@@ -0,0 +1,54 @@
+/**
+ * @file tile_map.cpp
+ * @author Alic Szecsei
+ * @date 6/12/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <random>
+#include <tile_map.hpp>
+
+using namespace rglike;
+
+TEST_CASE("TileMap access", "[bench][tile_map]") {
+    // 2048 x 2048 = ~4M tiles, far larger than any cache level.
+    constexpr int size = 2048;
+    constexpr int samples = 1 << 16;
+
+    TileMap map{size, size, Tile{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false}};
+
+    std::mt19937 rng{1234};
+    std::uniform_int_distribution<int> coord{0, size - 1};
+    std::vector<Vec2> positions{};
+    positions.reserve(samples);
+    for (int i = 0; i < samples; ++i) { positions.emplace_back(coord(rng), coord(rng)); }
+    for (int i = 0; i < samples; i += 7) { map.SetPassable(positions[i], false); }
+
+    BENCHMARK("random IsPassable (64k lookups)") {
+        int count = 0;
+        for (const auto& pos : positions) { count += map.IsPassable(pos) ? 1 : 0; }
+        return count;
+    };
+
+    BENCHMARK("random Glyph (64k lookups)") {
+        uint32_t acc = 0;
+        for (const auto& pos : positions) { acc += map.Glyph(pos); }
+        return acc;
+    };
+
+    BENCHMARK("row-major IsPassable (full map)") {
+        int count = 0;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) { count += map.IsPassable(Vec2{x, y}) ? 1 : 0; }
+        }
+        return count;
+    };
+
+    BENCHMARK("row-major Glyph (full map)") {
+        uint32_t acc = 0;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) { acc += map.Glyph(Vec2{x, y}); }
+        }
+        return acc;
+    };
+}
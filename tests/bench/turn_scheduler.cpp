@@ -0,0 +1,56 @@
+/**
+ * @file turn_scheduler.cpp
+ * @author Alic Szecsei
+ * @date 7/8/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <turn_scheduler.hpp>
+
+using namespace rglike;
+
+namespace {
+    constexpr int actor_count = 50'000;
+    constexpr size_t turn_count = 1'000'000;
+
+    void SpawnActors(entt::registry& registry) {
+        std::mt19937 rng{1357};
+        std::uniform_int_distribution<int> speed{1, 4 * NORMAL_SPEED};
+        for (int i = 0; i < actor_count; ++i) {
+            registry.emplace<Actor>(registry.create(), Actor{speed(rng), 0});
+        }
+    }
+
+    auto RunTurns(entt::registry& registry, TurnScheduler& turns, size_t count) -> size_t {
+        for (size_t taken = 0; taken < count; ++taken) {
+            auto entity = turns.Pop(registry, UINT64_MAX);
+            if (entity == entt::null) { return taken; }
+            turns.Spend(registry, entity);
+        }
+        return count;
+    }
+} // namespace
+
+TEST_CASE("Turn scheduler", "[bench][turn_scheduler]") {
+    entt::registry registry{};
+    TurnScheduler turns{};
+    turns.Connect(registry);
+    SpawnActors(registry);
+
+    BENCHMARK("1M turns, 50k actors") { return RunTurns(registry, turns, turn_count); };
+
+    // Once more outside Catch's sampling, to report throughput.
+    turns.Disconnect(registry);
+    turns.Connect(registry);
+    auto start = std::chrono::steady_clock::now();
+    auto taken = RunTurns(registry, turns, turn_count);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Simulated " << taken << " turns for " << actor_count << " actors at "
+              << static_cast<size_t>(static_cast<double>(taken) / elapsed.count())
+              << " turns per second\n";
+
+    turns.Disconnect(registry);
+}
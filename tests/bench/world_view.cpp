@@ -0,0 +1,73 @@
+/**
+ * @file world_view.cpp
+ * @author Alic Szecsei
+ * @date 6/14/2023
+ */
+
+#include <catch2/catch.hpp>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <game_log.hpp>
+#include <ui/world_component.hpp>
+#include <ui/world_view_cache.hpp>
+
+#include <array>
+#include <string>
+#include <utility>
+
+using namespace rglike;
+
+TEST_CASE("WorldViewCache", "[bench][render]") {
+    constexpr int width = 200;
+    constexpr int height = 60;
+
+    TileMap map{1024, 1024, Tile{U'.', ftxui::Color::GrayDark, ftxui::Color::Default, true, false}};
+    auto screen = ftxui::Screen(width, height);
+    FieldOfView fov{};
+    fov.Recompute(map, Vec2{110, 40}, 1000);
+    LightMap lights{};
+
+    BENCHMARK("full rebuild 200x60") {
+        ui::WorldViewCache cache{};
+        return cache.Update(map, fov, lights, Vec2{10, 10}, width, height);
+    };
+
+    ui::WorldViewCache cache{};
+    cache.Update(map, fov, lights, Vec2{10, 10}, width, height);
+
+    BENCHMARK("unchanged frame 200x60") {
+        return cache.Update(map, fov, lights, Vec2{10, 10}, width, height);
+    };
+
+    int step = 0;
+    BENCHMARK("scroll by one column 200x60") {
+        return cache.Update(map, fov, lights, Vec2{10 + (++step % 64), 10}, width, height);
+    };
+
+    BENCHMARK("blit 200x60") {
+        cache.Blit(screen, 0, 0);
+        return screen.PixelAt(0, 0).character.size();
+    };
+}
+
+TEST_CASE("World viewer", "[bench][render]") {
+    World world{};
+    world.Initialize(2023);
+    auto viewer = ui::WorldViewer(world);
+
+    constexpr std::array<std::pair<int, int>, 3> sizes{
+        {{80, 24}, {160, 48}, {240, 72}}
+    };
+    for (auto [width, height] : sizes) {
+        auto screen = ftxui::Screen(width, height);
+        auto name = "render " + std::to_string(width) + "x" + std::to_string(height);
+
+        BENCHMARK(std::move(name)) {
+            ftxui::Render(screen, viewer->Render());
+            return screen.PixelAt(width / 2, height / 2).character.size();
+        };
+    }
+
+    // The viewer logs each new size it's rendered at.
+    GameLog::GetInstance().Drain();
+}
@@ -1,6 +1,40 @@
 #define CATCH_CONFIG_MAIN
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sys/resource.h>
+#include <thread>
 #include <catch2/catch.hpp>
+#include "alloc_counter.hpp"
+#include <chunk_streamer.hpp>
+#include <rglike/format_cache.hpp>
 #include <rglike/formatting.hpp>
+#include <dijkstra_map.hpp>
+#include <dungeon.hpp>
+#include <factions.hpp>
+#include <fluency.hpp>
+#include <fov.hpp>
+#include <game_log.hpp>
+#include <geometry.hpp>
+#include <input.hpp>
+#include <light_map.hpp>
+#include <particles.hpp>
+#include <pathfinding.hpp>
+#include <perception.hpp>
+#include <region_file.hpp>
+#include <replay.hpp>
+#include <save_game.hpp>
+#include <spatial_index.hpp>
+#include <state_hash.hpp>
+#include <system_graph.hpp>
+#include <tile_map.hpp>
+#include <turn_scheduler.hpp>
+#include <ui/log_layout_cache.hpp>
+#include <ui/world_view_cache.hpp>
+#include <world.hpp>
 
 TEST_CASE("Quick check", "[main]") { REQUIRE(true == true); }
 
@@ -8,4 +42,1492 @@ TEST_CASE("Strip formatting", "[formatting]") {
     auto txt = rglike::format_text("Hell[b]o[/b], w[i][/i]orld!");
     auto stripped = txt.plain_text();
     REQUIRE(stripped == "Hello, world!");
-}
\ No newline at end of file
+}
+
+TEST_CASE("Markup parsing", "[formatting]") {
+    using rglike::formatting::MarkupError;
+
+    auto txt = rglike::format_text("a [color=r]red [b]bold[/b][/color] [[tag]] b");
+    REQUIRE(txt.plain_text() == "a red bold [tag] b");
+    std::vector<std::string> runs;
+    for (const auto& fragment : txt) { runs.push_back(fragment.text); }
+    REQUIRE(runs == std::vector<std::string>{"a ", "red ", "bold", " [tag] b"});
+    auto bold = std::next(txt.begin(), 2)->format;
+    REQUIRE(bold.bold);
+    REQUIRE(bold.color == ftxui::Color::Red);
+    REQUIRE(txt.begin()->format.color == ftxui::Color::Default);
+
+    REQUIRE(rglike::format_text("[ color = B ]x[/color]").begin()->format.color ==
+            ftxui::Color::BlueLight);
+    REQUIRE(rglike::format_text("").empty());
+
+    auto error = [](std::string_view text) {
+        return rglike::formatting::parse_markup(text, [](const auto&, auto) {}).error;
+    };
+    REQUIRE(error("[b]x[/b]") == MarkupError::None);
+    REQUIRE(error("x]") == MarkupError::StrayBracket);
+    REQUIRE(error("[1]x") == MarkupError::BadTagName);
+    REQUIRE(error("[b x") == MarkupError::UnterminatedTag);
+    REQUIRE(error("[b]x[/u]") == MarkupError::TagMismatch);
+    REQUIRE(error("[/b]") == MarkupError::TagMismatch);
+    REQUIRE(error("[b]x") == MarkupError::UnclosedTag);
+    std::string deep;
+    for (int i = 0; i < 17; ++i) { deep += "[b]"; }
+    REQUIRE(error(deep) == MarkupError::TooDeep);
+    REQUIRE(rglike::format_text("[b]x").empty());
+
+    // The parser runs at compile time too.
+    constexpr auto runs_in = [](std::string_view text) {
+        size_t count = 0;
+        auto result = rglike::formatting::parse_markup(text, [&](const auto&, auto) { ++count; });
+        return result ? count : 0;
+    };
+    static_assert(runs_in("a[b]b[/b]c") == 3);
+}
+
+TEST_CASE("Markup literals", "[formatting]") {
+    constexpr auto welcome = RGLIKE_MARKUP("Welcome to [color=r][blink]rglike[/blink][/color]!");
+    static_assert(welcome.size() == 3);
+    static_assert(welcome.plain_text() == "Welcome to rglike!");
+    static_assert(welcome.text(1) == "rglike");
+    static_assert(welcome.style(1).color == 1 && welcome.style(1).blinking);
+    static_assert(RGLIKE_MARKUP("[[not a tag]]").plain_text() == "[not a tag]");
+    static_assert(RGLIKE_MARKUP("").size() == 0);
+
+    // A literal turns into the same Text format_text would give.
+    rglike::formatting::Text text = welcome;
+    auto parsed = rglike::format_text("Welcome to [color=r][blink]rglike[/blink][/color]!");
+    REQUIRE(text.size() == parsed.size());
+    for (auto a = text.begin(), b = parsed.begin(); a != text.end(); ++a, ++b) {
+        REQUIRE(a->text == b->text);
+        REQUIRE(a->format.color == b->format.color);
+        REQUIRE(a->format.blinking == b->format.blinking);
+    }
+}
+
+TEST_CASE("Format cache", "[formatting]") {
+    rglike::formatting::FormatCache cache(2);
+    auto first = cache.format("You hit the [color=r]goblin[/color].");
+    REQUIRE(first->plain_text() == "You hit the goblin.");
+    REQUIRE(cache.format("You hit the [color=r]goblin[/color].") == first);
+    REQUIRE(cache.stats().hits == 1);
+    REQUIRE(cache.stats().misses == 1);
+
+    // The least recently used string goes first, and a shared Text outlives its entry.
+    auto second = cache.format("You miss.");
+    REQUIRE(cache.format("You hit the [color=r]goblin[/color].") == first);
+    (void)cache.format("The goblin flees.");
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.stats().evictions == 1);
+    REQUIRE(cache.format("You miss.") != second);
+    REQUIRE(second->plain_text() == "You miss.");
+    REQUIRE(cache.stats().hits == 2);
+    REQUIRE(cache.stats().misses == 4);
+    REQUIRE(cache.stats().hit_rate() == Approx(2.0 / 6.0));
+
+    cache.set_capacity(1);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.format("You miss.")->plain_text() == "You miss.");
+    REQUIRE(cache.stats().hits == 3);
+
+    cache.set_capacity(0);
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.format("You miss.") != cache.format("You miss."));
+    REQUIRE(cache.size() == 0);
+}
+
+TEST_CASE("Fluency string cache", "[formatting]") {
+    fluency::FluencyBundle bundle("en-US");
+    std::vector<std::string> errors{};
+    REQUIRE(bundle.add_resource(
+        "hello = Hello\n"
+        "count = { $n } goblins\n"
+        "broken = { $missing }\n"
+        "door = Door\n"
+        "    .title = A door\n",
+        errors
+    ));
+    REQUIRE(errors.empty());
+    bundle.set_use_isolating(false);
+
+    auto hello = bundle.get_string("hello", errors);
+    REQUIRE(*hello == "Hello");
+    REQUIRE(bundle.get_string("hello", errors) == hello);
+    REQUIRE(*bundle.get_attribute_string("door", "title", errors) == "A door");
+
+    // The same value as a different type is a different key.
+    fluency::FluencyArgs as_signed{};
+    as_signed.set("n", int32_t{3});
+    fluency::FluencyArgs as_unsigned{};
+    as_unsigned.set("n", uint32_t{3});
+    auto count = bundle.get_string("count", as_signed, errors);
+    REQUIRE(*count == "3 goblins");
+    REQUIRE(bundle.get_string("count", as_unsigned, errors) != count);
+    REQUIRE(bundle.get_string("count", as_signed, errors) == count);
+    REQUIRE(bundle.cache_size() == 4);
+
+    // Strings with errors are never cached, and a hit reports none.
+    auto broken = bundle.get_string("broken", errors);
+    REQUIRE_FALSE(errors.empty());
+    REQUIRE(bundle.cache_size() == 4);
+    REQUIRE(bundle.get_string("broken", errors) != broken);
+    REQUIRE_FALSE(errors.empty());
+    REQUIRE(bundle.get_string("hello", errors) == hello);
+    REQUIRE(errors.empty());
+
+    // Anything that could change what a message formats to empties the cache.
+    REQUIRE(bundle.add_resource_overriding("hello = Howdy\n", errors));
+    REQUIRE(bundle.cache_size() == 0);
+    REQUIRE(*bundle.get_string("hello", errors) == "Howdy");
+    REQUIRE(bundle.add_resource("farewell = Bye\n", errors));
+    REQUIRE(bundle.cache_size() == 0);
+    (void)bundle.get_string("hello", errors);
+    bundle.set_use_isolating(false);
+    REQUIRE(bundle.cache_size() == 0);
+
+    // The least recently used string goes first, and a shared string outlives its entry.
+    bundle.set_cache_capacity(2);
+    REQUIRE(bundle.cache_capacity() == 2);
+    hello = bundle.get_string("hello", errors);
+    count = bundle.get_string("count", as_signed, errors);
+    REQUIRE(bundle.get_string("hello", errors) == hello);
+    (void)bundle.get_string("farewell", errors);
+    REQUIRE(bundle.cache_size() == 2);
+    REQUIRE(bundle.get_string("hello", errors) == hello);
+    REQUIRE(bundle.get_string("count", as_signed, errors) != count);
+    REQUIRE(*count == "3 goblins");
+
+    bundle.set_cache_capacity(0);
+    REQUIRE(bundle.cache_size() == 0);
+    REQUIRE(bundle.get_string("hello", errors) != bundle.get_string("hello", errors));
+    REQUIRE(bundle.cache_size() == 0);
+}
+
+TEST_CASE("Tile map storage", "[world]") {
+    rglike::TileMap map{40, 70};
+    REQUIRE(map.ChunksWide() == 2);
+    REQUIRE(map.ChunksHigh() == 3);
+
+    // Default tiles are walls, as is everything outside the map.
+    REQUIRE_FALSE(map.IsPassable(rglike::Vec2{5, 5}));
+    REQUIRE(map.IsOpaque(rglike::Vec2{-1, 0}));
+    REQUIRE_FALSE(map.IsPassable(rglike::Vec2{40, 0}));
+
+    rglike::Vec2 pos{33, 65};
+    map.Set(pos, rglike::Tile{U'~', ftxui::Color::Blue, ftxui::Color::Default, true, false});
+    REQUIRE(map.Glyph(pos) == U'~');
+    REQUIRE(map.IsPassable(pos));
+    REQUIRE_FALSE(map.IsOpaque(pos));
+    REQUIRE_FALSE(map.IsPassable(rglike::Vec2{32, 65}));
+    REQUIRE(map.Get(pos).fg == ftxui::Color::Blue);
+
+    REQUIRE(rglike::GlyphToString(U'▓') == "▓");
+}
+
+TEST_CASE("Field of view", "[world]") {
+    using rglike::Vec2;
+    const rglike::Tile floor{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false};
+    const rglike::Tile wall{U'#', ftxui::Color::Default, ftxui::Color::Default, false, true};
+
+    rglike::TileMap map{64, 64, floor};
+    for (int y = 0; y < 64; ++y) { map.Set(Vec2{20, y}, wall); }
+
+    rglike::FieldOfView fov{};
+    fov.Recompute(map, Vec2{10, 10}, 16);
+    REQUIRE(fov.IsVisible(Vec2{10, 10}));
+    REQUIRE(fov.IsVisible(Vec2{19, 10}));
+    REQUIRE(fov.IsVisible(Vec2{20, 10}));
+    REQUIRE_FALSE(fov.IsVisible(Vec2{21, 10}));
+    REQUIRE_FALSE(fov.IsVisible(Vec2{10, 40}));
+
+    // Stepping away keeps what was seen as explored, but no longer visible.
+    REQUIRE(fov.IsVisible(Vec2{10, 26}));
+    fov.Update(map, Vec2{10, 9}, 16);
+    fov.Update(map, Vec2{10, 8}, 16);
+    REQUIRE_FALSE(fov.IsVisible(Vec2{10, 26}));
+    REQUIRE(fov.IsExplored(Vec2{10, 26}));
+    REQUIRE_FALSE(fov.IsExplored(Vec2{21, 10}));
+}
+
+TEST_CASE("World view cache", "[world]") {
+    using rglike::Vec2;
+    const rglike::Tile floor{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false};
+
+    rglike::TileMap map{64, 64, floor};
+    rglike::FieldOfView fov{};
+    rglike::LightMap lights{};
+    fov.Recompute(map, Vec2{10, 10}, 4);
+
+    rglike::ui::WorldViewCache cache{};
+    ftxui::Screen screen{40, 40};
+    cache.Update(map, fov, lights, Vec2::Zero(), 40, 40);
+    cache.Blit(screen, 0, 0);
+    REQUIRE_FALSE(screen.PixelAt(6, 10).dim);
+
+    // Several moves between frames: the tile is only outside the last move's dirty bounds.
+    for (int x = 11; x <= 13; ++x) { fov.Update(map, Vec2{x, 10}, 4); }
+    cache.Update(map, fov, lights, Vec2::Zero(), 40, 40);
+    cache.Blit(screen, 0, 0);
+    REQUIRE(screen.PixelAt(6, 10).dim);
+    REQUIRE_FALSE(screen.PixelAt(13, 10).dim);
+}
+
+TEST_CASE("Pathfinding", "[world]") {
+    using rglike::Vec2;
+    const rglike::Tile floor{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false};
+    const rglike::Tile wall{U'#', ftxui::Color::Default, ftxui::Color::Default, false, true};
+
+    // A wall down the middle with a single gap at the bottom.
+    rglike::TileMap map{32, 32, floor};
+    for (int y = 0; y < 30; ++y) { map.Set(Vec2{16, y}, wall); }
+
+    rglike::Pathfinder pathfinder{};
+    std::vector<Vec2> steps{};
+
+    SECTION("jump point search on uniform cost") {
+        REQUIRE(map.IsUniformCost());
+        REQUIRE(pathfinder.FindPath(map, Vec2{2, 2}, Vec2{30, 2}, steps));
+        REQUIRE(steps.back() == Vec2(30, 2));
+        REQUIRE(std::find(steps.begin(), steps.end(), Vec2(16, 30)) != steps.end());
+        // Every step is a single king's move onto open ground.
+        Vec2 prev{2, 2};
+        for (const auto& step : steps) {
+            auto delta = step - prev;
+            REQUIRE(std::max(std::abs(delta.X()), std::abs(delta.Y())) == 1);
+            REQUIRE(map.IsPassable(step));
+            prev = step;
+        }
+    }
+
+    SECTION("A* avoids expensive terrain") {
+        for (int x = 0; x < 32; ++x) { map.SetMoveCost(Vec2{x, 31}, 50); }
+        map.Set(Vec2{16, 30}, floor);
+        REQUIRE_FALSE(map.IsUniformCost());
+        REQUIRE(pathfinder.FindPath(map, Vec2{14, 30}, Vec2{18, 30}, steps));
+        REQUIRE(steps.size() == 4);
+        for (const auto& step : steps) { REQUIRE(step.Y() == 30); }
+    }
+
+    SECTION("unreachable goals") {
+        for (int y = 0; y < 32; ++y) { map.Set(Vec2{16, y}, wall); }
+        REQUIRE_FALSE(pathfinder.FindPath(map, Vec2{2, 2}, Vec2{30, 2}, steps));
+        REQUIRE(steps.empty());
+    }
+}
+
+TEST_CASE("Dijkstra maps", "[world]") {
+    using rglike::Vec2;
+    const rglike::Tile floor{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false};
+    rglike::TileMap map{64, 64, floor};
+
+    rglike::DijkstraMap approach{};
+    rglike::DijkstraMap flee{};
+    REQUIRE(approach.BuildApproach(map, Vec2{32, 32}, 16));
+    REQUIRE(flee.BuildFlee(map, approach));
+
+    REQUIRE(approach.Value(Vec2{32, 32}) == 0);
+    REQUIRE(approach.Value(Vec2{35, 30}) == 3 * rglike::DIJKSTRA_STEP);
+    REQUIRE(approach.NextStep(Vec2{40, 32}) == Vec2(-1, 0));
+    REQUIRE(approach.NextStep(Vec2{32, 32}) == Vec2::Zero());
+    REQUIRE(approach.Value(Vec2{0, 0}) == rglike::DijkstraMap::UNREACHABLE);
+
+    // Fleeing moves away from the goal.
+    auto step = flee.NextStep(Vec2{36, 32});
+    REQUIRE(step.X() > 0);
+
+    // Unchanged inputs are not rebuilt.
+    REQUIRE_FALSE(approach.BuildApproach(map, Vec2{32, 32}, 16));
+    REQUIRE_FALSE(flee.BuildFlee(map, approach));
+    REQUIRE(approach.BuildApproach(map, Vec2{33, 32}, 16));
+    REQUIRE(flee.BuildFlee(map, approach));
+
+    // A goal walking around a map with walls is updated in place, and ends up just as if it had
+    // been built from scratch where it stopped.
+    const rglike::Tile wall{U'#', ftxui::Color::Default, ftxui::Color::Default, false, true};
+    rglike::TileMap walled{40, 40, floor};
+    for (int y = 5; y < 35; ++y) { walled.Set(Vec2{20, y}, wall); }
+    for (int x = 8; x < 20; ++x) { walled.Set(Vec2{x, 12}, wall); }
+    rglike::DijkstraMap walking{};
+    REQUIRE(walking.BuildApproach(walled, Vec2{15, 20}, 48));
+    for (auto goal : {Vec2{16, 20}, Vec2{17, 19}, Vec2{17, 18}, Vec2{18, 17}, Vec2{19, 17}}) {
+        REQUIRE(walking.BuildApproach(walled, goal, 48));
+    }
+    rglike::DijkstraMap fresh{};
+    REQUIRE(fresh.BuildApproach(walled, Vec2{19, 17}, 48));
+    for (int y = 0; y < 40; ++y) {
+        for (int x = 0; x < 40; ++x) {
+            REQUIRE(walking.Value(Vec2{x, y}) == fresh.Value(Vec2{x, y}));
+            REQUIRE(walking.NextStep(Vec2{x, y}) == fresh.NextStep(Vec2{x, y}));
+        }
+    }
+}
+
+TEST_CASE("Goal fields", "[world]") {
+    using rglike::Vec2;
+    rglike::World world{};
+    world.Initialize(5);
+    REQUIRE(world.GoalCount() == 1);
+
+    auto shrine = world.AddGoal(world.PlayerPos());
+    REQUIRE(shrine == 1);
+    world.UpdateFields();
+    REQUIRE(world.Fields(shrine).approach.Value(world.PlayerPos()) == 0);
+    REQUIRE(world.PlayerFields().approach.Value(world.PlayerPos()) == 0);
+
+    // Reinitializing forgets every goal but the player's.
+    world.Initialize(5);
+    REQUIRE(world.GoalCount() == 1);
+}
+
+TEST_CASE("Faction responses", "[world]") {
+    rglike::FactionTable factions{};
+    rglike::DefineBaseFactions(factions);
+    using rglike::Response;
+    REQUIRE(factions.ResponseTo("mindless", "player") == Response::Attack);
+    REQUIRE(factions.ResponseTo("townsfolk", "player") == Response::Ignore);
+    REQUIRE(factions.ResponseTo("townsfolk", "bandits") == Response::Flee);
+    REQUIRE(factions.ResponseTo("bandits", "bandits") == Response::Ignore);
+    REQUIRE(factions.ResponseTo("player", "bandits") == Response::Ignore);
+}
+
+TEST_CASE("Faction matrix", "[world]") {
+    using rglike::FactionIndex;
+    using rglike::FactionMember;
+    using rglike::Position;
+    using rglike::Response;
+    using rglike::Vec2;
+    rglike::FactionTable table{};
+    rglike::DefineBaseFactions(table);
+    rglike::FactionMatrix matrix{};
+    matrix.Compile(table);
+
+    // Every defined pair agrees with the table, and undefined factions fall back the same way.
+    auto ids = table.Ids();
+    ids.emplace_back("goblins");
+    REQUIRE(matrix.Size() == ids.size());
+    for (const auto& from : ids) {
+        for (const auto& to : ids) {
+            auto response = matrix.ResponseTo(matrix.Id(from), matrix.Id(to));
+            REQUIRE(response == table.ResponseTo(from, to));
+        }
+    }
+
+    entt::registry registry{};
+    rglike::SpatialIndex spatial{};
+    spatial.Connect(registry);
+    matrix.Connect(registry);
+    const auto spawn = [&](const char* faction, Vec2 pos) {
+        auto entity = registry.create();
+        registry.emplace<Position>(entity, pos);
+        registry.emplace<FactionMember>(entity, FactionMember{faction});
+        return entity;
+    };
+    auto townsfolk = spawn("townsfolk", Vec2{10, 10});
+    auto bandit = spawn("bandits", Vec2{13, 10});
+    auto mindless = spawn("mindless", Vec2{10, 12});
+    auto far_bandit = spawn("bandits", Vec2{40, 40});
+    REQUIRE(registry.get<FactionIndex>(bandit).id == matrix.Id("bandits"));
+
+    rglike::ThreadPool pool{2};
+    rglike::Perception perception{};
+    perception.Evaluate(registry, spatial, matrix, Vec2{41, 40}, 8, pool);
+    REQUIRE(perception.Size() == 4);
+
+    // Townsfolk flee the nearest threat; the mindless attack whatever is closest.
+    auto fleeing = perception.ReactionOf(townsfolk);
+    REQUIRE(fleeing.response == Response::Flee);
+    REQUIRE(fleeing.target == Vec2{10, 12});
+    REQUIRE(perception.ReactionOf(mindless).target == Vec2{10, 10});
+    REQUIRE(perception.ReactionOf(bandit).target == Vec2{10, 10});
+    auto hunting = perception.ReactionOf(far_bandit);
+    REQUIRE(hunting.response == Response::Attack);
+    REQUIRE(hunting.player);
+
+    // Changing faction is picked up through the signals.
+    registry.patch<FactionMember>(bandit, [](FactionMember& member) {
+        member.faction = "townsfolk";
+    });
+    perception.Evaluate(registry, spatial, matrix, Vec2{41, 40}, 8, pool);
+    REQUIRE(perception.ReactionOf(bandit).response == Response::Flee);
+
+    matrix.Disconnect(registry);
+    spatial.Disconnect(registry);
+}
+
+TEST_CASE("Dungeon generation", "[world]") {
+    rglike::DungeonSettings settings{};
+    settings.seed = 7;
+    settings.width = 150;
+    settings.height = 100;
+
+    rglike::TileMap inline_map{};
+    auto spawn = rglike::GenerateDungeon(inline_map, settings);
+    REQUIRE(inline_map.IsPassable(spawn));
+
+    // Byte-identical no matter how many threads share the work.
+    rglike::ThreadPool pool{3};
+    rglike::TileMap parallel_map{};
+    REQUIRE(rglike::GenerateDungeon(parallel_map, settings, &pool) == spawn);
+    REQUIRE(rglike::LayoutChecksum(parallel_map) == rglike::LayoutChecksum(inline_map));
+
+    // Every floor tile can be walked to from the spawn point.
+    rglike::DijkstraMap reach{};
+    reach.BuildApproach(inline_map, spawn, settings.width + settings.height);
+    int stranded = 0;
+    for (int y = 0; y < settings.height; ++y) {
+        for (int x = 0; x < settings.width; ++x) {
+            rglike::Vec2 pos{x, y};
+            if (inline_map.IsPassable(pos) &&
+                reach.Value(pos) == rglike::DijkstraMap::UNREACHABLE) {
+                ++stranded;
+            }
+        }
+    }
+    REQUIRE(stranded == 0);
+
+    settings.seed = 8;
+    rglike::GenerateDungeon(parallel_map, settings, &pool);
+    REQUIRE(rglike::LayoutChecksum(parallel_map) != rglike::LayoutChecksum(inline_map));
+}
+
+TEST_CASE("Chunk streaming", "[world]") {
+    using rglike::Vec2;
+    rglike::DungeonSettings settings{};
+    settings.seed = 11;
+    settings.width = 1024;
+    settings.height = 128;
+
+    rglike::TileMap expected{};
+    rglike::GenerateDungeon(expected, settings);
+
+    auto path = (std::filesystem::temp_directory_path() / "rglike_streaming_test.region").string();
+    std::filesystem::remove(path);
+
+    rglike::TileMap map{};
+    map.ResizeUnloaded(settings.width, settings.height);
+    {
+        rglike::ChunkStreamer streamer{
+            map, path, rglike::DungeonFingerprint(settings),
+            [&](int chunk_x, int chunk_y, rglike::TileChunk& chunk) {
+                rglike::GenerateDungeonChunk(settings, chunk_x, chunk_y, chunk);
+            },
+            64, 32,
+        };
+
+        streamer.Prime(Vec2{16, 16});
+        REQUIRE(map.IsResident(0, 0));
+        REQUIRE_FALSE(map.IsResident(20, 0));
+        REQUIRE(map.Get(Vec2{16, 16}).passable == expected.Get(Vec2{16, 16}).passable);
+
+        // A change to a chunk survives it being evicted and read back.
+        map.SetGlyph(Vec2{3, 3}, U'X');
+
+        // Walk to the far end, one tile at a time, giving the I/O thread time to keep up.
+        for (int x = 16; x < 1000; ++x) {
+            streamer.Update(Vec2{x, 16});
+            if (x % 16 == 0) { streamer.WaitIdle(); }
+        }
+        streamer.WaitIdle();
+        REQUIRE_FALSE(map.IsResident(0, 0));
+        REQUIRE(map.IsResident(31, 0));
+        REQUIRE(map.Glyph(Vec2{3, 3}) == U' ');
+
+        streamer.Prime(Vec2{16, 16});
+        REQUIRE(map.Glyph(Vec2{3, 3}) == U'X');
+
+        auto stats = streamer.Stats();
+        REQUIRE(stats.resident_chunks == map.ResidentChunks());
+        REQUIRE(stats.page_outs > 0);
+        REQUIRE(stats.page_ins > stats.generated);
+        REQUIRE(stats.prefetch_misses == 0);
+        REQUIRE(stats.PrefetchHitRate() == 1.0);
+    }
+
+    // Everything was stored on shutdown, so a new streamer reads the same level back.
+    map.ResizeUnloaded(settings.width, settings.height);
+    auto fingerprint = rglike::DungeonFingerprint(settings);
+    rglike::ChunkStreamer reopened{map, path, fingerprint, nullptr, 64, 32};
+    reopened.Prime(Vec2{600, 64});
+    REQUIRE(reopened.Stats().generated == 0);
+    int mismatched = 0;
+    for (int y = 0; y < settings.height; ++y) {
+        for (int x = 500; x < 700; ++x) {
+            mismatched += map.IsPassable(Vec2{x, y}) != expected.IsPassable(Vec2{x, y}) ? 1 : 0;
+        }
+    }
+    REQUIRE(mismatched == 0);
+}
+
+TEST_CASE("Chunk streaming failures", "[world]") {
+    using rglike::Vec2;
+    rglike::DungeonSettings settings{};
+    settings.seed = 11;
+    settings.width = 1024;
+    settings.height = 128;
+    auto fingerprint = rglike::DungeonFingerprint(settings);
+    auto path = (std::filesystem::temp_directory_path() / "rglike_failure_test.region").string();
+    std::filesystem::remove(path);
+
+    rglike::TileMap map{};
+    map.ResizeUnloaded(settings.width, settings.height);
+    int broken_calls = 0;
+    rglike::ChunkStreamer streamer{
+        map, path, fingerprint,
+        [&](int chunk_x, int chunk_y, rglike::TileChunk& chunk) {
+            if (chunk_x == 2 && chunk_y == 0) {
+                ++broken_calls;
+                throw std::runtime_error("broken chunk");
+            }
+            rglike::GenerateDungeonChunk(settings, chunk_x, chunk_y, chunk);
+        },
+        64, 32,
+    };
+
+    // A chunk that fails to load is left alone until the next Prime, not asked for every move.
+    streamer.Prime(Vec2{16, 16});
+    REQUIRE(broken_calls == 1);
+    REQUIRE_FALSE(map.IsResident(2, 0));
+    for (int x = 17; x < 24; ++x) { streamer.Update(Vec2{x, 16}); }
+    streamer.WaitIdle();
+    REQUIRE(broken_calls == 1);
+    streamer.Prime(Vec2{16, 16});
+    REQUIRE(broken_calls == 2);
+
+    // Stop the region file growing past its first 64 slots, as a full disk would. Columns 0-15
+    // take nearly all of those, so nothing from column 17 on can be stored.
+    auto* previous_handler = std::signal(SIGXFSZ, SIG_IGN);
+    rlimit previous_limit{};
+    ::getrlimit(RLIMIT_FSIZE, &previous_limit);
+    rlimit limit = previous_limit;
+    limit.rlim_cur = static_cast<rlim_t>(std::filesystem::file_size(path));
+    ::setrlimit(RLIMIT_FSIZE, &limit);
+
+    for (int x = 24; x <= 704; ++x) {
+        if (x == 560) { map.SetGlyph(Vec2{560, 3}, U'X'); }
+        streamer.Update(Vec2{x, 16});
+        if (x % 16 == 0) { streamer.WaitIdle(); }
+    }
+    streamer.WaitIdle();
+
+    // The evicted chunk couldn't be written, so it went back in the map, edit and all.
+    REQUIRE(map.IsResident(17, 0));
+    REQUIRE(map.Glyph(Vec2{560, 3}) == U'X');
+    REQUIRE_FALSE(streamer.StoreAll());
+
+    ::setrlimit(RLIMIT_FSIZE, &previous_limit);
+    std::signal(SIGXFSZ, previous_handler);
+    REQUIRE(streamer.StoreAll());
+    streamer.Update(Vec2{705, 16});
+    streamer.WaitIdle();
+    REQUIRE_FALSE(map.IsResident(17, 0));
+    streamer.Prime(Vec2{560, 16});
+    REQUIRE(map.Glyph(Vec2{560, 3}) == U'X');
+}
+
+TEST_CASE("Region file", "[world]") {
+    auto path = (std::filesystem::temp_directory_path() / "rglike_region_test.region").string();
+    std::filesystem::remove(path);
+
+    rglike::TileChunk chunk{};
+    chunk.glyphs[0] = U'X';
+    rglike::RegionFile{path, 4, 4, 1}.Write(0, chunk);
+
+    // A file written for another level is refused rather than read back.
+    REQUIRE_THROWS(rglike::RegionFile{path, 4, 4, 2});
+    REQUIRE_THROWS(rglike::RegionFile{path, 8, 2, 1});
+
+    auto patch = [&](std::streamoff offset, uint32_t value) {
+        std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    constexpr std::streamoff SLOTS_CAPACITY = 28;
+    constexpr std::streamoff FIRST_SLOT = 40;
+
+    // An index entry past the slots in use reads as missing instead of outside the file.
+    patch(FIRST_SLOT, 1000);
+    {
+        rglike::RegionFile region{path, 4, 4, 1};
+        REQUIRE(region.Contains(0));
+        REQUIRE_FALSE(region.Read(0, chunk));
+    }
+
+    // A capacity the file is too short to hold is rejected outright.
+    patch(SLOTS_CAPACITY, 1U << 30U);
+    REQUIRE_THROWS(rglike::RegionFile{path, 4, 4, 1});
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Chunk residency", "[world]") {
+    using rglike::LightSource;
+    using rglike::Position;
+    using rglike::Rect;
+    using rglike::Vec2;
+    const rglike::Tile floor{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false};
+    rglike::TileMap map{256, 64, floor};
+
+    rglike::FieldOfView fov{};
+    fov.Recompute(map, Vec2{16, 16}, 8);
+    entt::registry registry{};
+    rglike::LightMap lights{};
+    lights.Connect(registry);
+    for (auto pos : {Vec2{16, 16}, Vec2{200, 16}}) {
+        auto torch = registry.create();
+        registry.emplace<Position>(torch, pos);
+        registry.emplace<LightSource>(torch);
+    }
+    REQUIRE(lights.Update(map, registry) == 2);
+
+    // Paging a chunk out leaves the level's revision alone, and says which tiles it covered.
+    auto revision = map.Revision();
+    auto since = map.ResidencyRevision();
+    auto chunk = map.ReleaseChunk(6, 0);
+    REQUIRE(map.Revision() == revision);
+    std::vector<Rect> paged{};
+    REQUIRE(map.ResidencyChangesSince(since, paged));
+    REQUIRE(paged.size() == 1);
+    REQUIRE(paged[0].min == Vec2{192, 0});
+    REQUIRE(map.ResidencyChangedIn(since, Rect::Around(Vec2{200, 16}, 2)));
+    REQUIRE_FALSE(map.ResidencyChangedIn(since, Rect::Around(Vec2{16, 16}, 8)));
+
+    // Only the light in that chunk is recast, and the field of view only clears around the viewer.
+    REQUIRE(lights.Update(map, registry) == 1);
+    fov.Update(map, Vec2{17, 16}, 8);
+    REQUIRE(fov.DirtyBounds().Width() < map.Width());
+
+    // Too much paging to remember means anything may have changed.
+    map.InstallChunk(6, 0, std::move(chunk));
+    for (int i = 0; i < 64; ++i) { map.InstallChunk(6, 0, map.ReleaseChunk(6, 0)); }
+    paged.clear();
+    REQUIRE_FALSE(map.ResidencyChangesSince(since, paged));
+    REQUIRE(map.ResidencyChangedIn(since, Rect::Around(Vec2{16, 16}, 8)));
+
+    lights.Disconnect(registry);
+}
+
+TEST_CASE("Light map", "[world]") {
+    using rglike::LightSource;
+    using rglike::Position;
+    using rglike::Vec2;
+    const rglike::Tile floor{U'.', ftxui::Color::Default, ftxui::Color::Default, true, false};
+    const rglike::Tile wall{U'#', ftxui::Color::Default, ftxui::Color::Default, false, true};
+    rglike::TileMap map{64, 64, floor};
+
+    entt::registry registry{};
+    rglike::LightMap lights{};
+    lights.Connect(registry);
+    auto torch = registry.create();
+    registry.emplace<Position>(torch, Vec2{20, 20});
+    registry.emplace<LightSource>(torch, LightSource{255, 0, 0, 4});
+    REQUIRE(lights.Update(map, registry) == 1);
+    REQUIRE(lights.Lights() == 1);
+    REQUIRE(lights.LightAt(Vec2{20, 20}).red == 255);
+    REQUIRE(lights.LightAt(Vec2{20, 20}).green == 0);
+    REQUIRE(lights.LightAt(Vec2{22, 20}).red < 255);
+    REQUIRE(lights.LightAt(Vec2{26, 20}).red == 0);
+
+    // Nothing changed, so nothing is recast.
+    REQUIRE(lights.Update(map, registry) == 0);
+
+    // Moving the light takes its old light back out exactly.
+    registry.patch<Position>(torch, [](Position& position) { position.pos = Vec2{40, 40}; });
+    REQUIRE(lights.Update(map, registry) == 1);
+    REQUIRE(lights.LightAt(Vec2{20, 20}).red == 0);
+    REQUIRE(lights.LightAt(Vec2{40, 40}).red == 255);
+    REQUIRE(lights.DirtyBounds().Contains(Vec2{20, 20}));
+
+    // Walls cast shadows, and only lights in reach of a reported edit are recast.
+    auto other = registry.create();
+    registry.emplace<Position>(other, Vec2{10, 10});
+    registry.emplace<LightSource>(other);
+    lights.Update(map, registry);
+    map.Set(Vec2{41, 40}, wall);
+    lights.InvalidateArea(rglike::Rect{Vec2{41, 40}, Vec2{42, 41}});
+    REQUIRE(lights.Update(map, registry) == 1);
+    REQUIRE(lights.LightAt(Vec2{41, 40}).red > 0);
+    REQUIRE(lights.LightAt(Vec2{43, 40}).red == 0);
+
+    registry.destroy(torch);
+    registry.destroy(other);
+    REQUIRE(lights.Update(map, registry) == 2);
+    REQUIRE(lights.Lights() == 0);
+    REQUIRE(lights.LightAt(Vec2{40, 40}).red == 0);
+    REQUIRE(lights.LightAt(Vec2{10, 10}).green == 0);
+
+    lights.Disconnect(registry);
+}
+
+TEST_CASE("Spatial index", "[world]") {
+    using rglike::Position;
+    using rglike::Vec2;
+    entt::registry registry{};
+    rglike::SpatialIndex index{};
+    index.Connect(registry);
+
+    const auto collect = [&](auto&& query) {
+        std::vector<entt::entity> found{};
+        query([&](entt::entity entity, Vec2) { found.push_back(entity); });
+        std::sort(found.begin(), found.end());
+        return found;
+    };
+
+    auto a = registry.create();
+    auto b = registry.create();
+    auto c = registry.create();
+    registry.emplace<Position>(a, Vec2{5, 5});
+    registry.emplace<Position>(b, Vec2{5, 5});
+    registry.emplace<Position>(c, Vec2{40, 5});
+    REQUIRE(index.Size() == 3);
+
+    auto at = [&](Vec2 pos) {
+        return collect([&](auto&& fn) { index.QueryPoint(pos, fn); });
+    };
+    REQUIRE(at(Vec2{5, 5}) == std::vector{a, b});
+    REQUIRE(at(Vec2{6, 5}).empty());
+
+    // Queries spanning chunk boundaries.
+    auto in_rect = collect([&](auto&& fn) {
+        index.QueryRect(rglike::Rect{Vec2{0, 0}, Vec2{41, 6}}, fn);
+    });
+    REQUIRE(in_rect == std::vector{a, b, c});
+    auto in_radius = collect([&](auto&& fn) { index.QueryRadius(Vec2{36, 5}, 4, fn); });
+    REQUIRE(in_radius == std::vector{c});
+
+    registry.patch<Position>(a, [](Position& position) { position.pos = Vec2{-3, 70}; });
+    REQUIRE(at(Vec2{5, 5}) == std::vector{b});
+    REQUIRE(at(Vec2{-3, 70}) == std::vector{a});
+
+    registry.destroy(b);
+    REQUIRE(at(Vec2{5, 5}).empty());
+    REQUIRE(index.Size() == 2);
+
+    index.Disconnect(registry);
+}
+
+TEST_CASE("Save round trip", "[world]") {
+    using rglike::Actor;
+    using rglike::FactionMember;
+    using rglike::LightSource;
+    using rglike::Position;
+    using rglike::Vec2;
+    entt::registry registry{};
+    for (int i = 0; i < 1000; ++i) {
+        auto entity = registry.create();
+        registry.emplace<Position>(entity, Vec2{i % 37 - 10, i / 37});
+        if (i % 3 == 0) { registry.emplace<FactionMember>(entity, FactionMember{"goblins"}); }
+        if (i % 4 == 0) { registry.emplace<Actor>(entity, Actor{50 + i % 100, i % 7 - 3}); }
+        if (i % 50 == 0) {
+            auto blue = static_cast<uint8_t>(i % 256);
+            registry.emplace<LightSource>(entity, LightSource{255, 32, blue, i % 9});
+        }
+    }
+    registry.destroy(entt::entity{7});
+
+    rglike::SaveState state{};
+    state.seed = 1234;
+    state.player = Vec2{-4, 9};
+    state.clock = 98765;
+    state.turns_taken = 4321;
+    rglike::CaptureRegistry(registry, state.registry);
+
+    auto compression = GENERATE(rglike::SaveCompression::None, rglike::SaveCompression::Zstd);
+    auto bytes = rglike::EncodeSave(state, compression);
+
+    entt::registry loaded{};
+    auto restored = rglike::DecodeSave(bytes, loaded);
+    REQUIRE(restored.has_value());
+    REQUIRE(restored->seed == 1234);
+    REQUIRE(restored->player == Vec2{-4, 9});
+    REQUIRE(restored->clock == 98765);
+    REQUIRE(restored->turns_taken == 4321);
+    REQUIRE(restored->entities == registry.alive());
+    REQUIRE(!loaded.valid(entt::entity{7}));
+    for (auto [entity, position] : registry.view<Position>().each()) {
+        REQUIRE(loaded.valid(entity));
+        REQUIRE(loaded.get<Position>(entity).pos == position.pos);
+        REQUIRE(loaded.all_of<FactionMember>(entity) == registry.all_of<FactionMember>(entity));
+    }
+    REQUIRE(loaded.view<Actor>().size() == registry.view<Actor>().size());
+    for (auto [entity, actor] : registry.view<Actor>().each()) {
+        REQUIRE(loaded.get<Actor>(entity).speed == actor.speed);
+        REQUIRE(loaded.get<Actor>(entity).energy == actor.energy);
+    }
+    REQUIRE(loaded.view<LightSource>().size() == registry.view<LightSource>().size());
+    for (auto [entity, light] : registry.view<LightSource>().each()) {
+        const auto& restored_light = loaded.get<LightSource>(entity);
+        REQUIRE(restored_light.red == light.red);
+        REQUIRE(restored_light.green == light.green);
+        REQUIRE(restored_light.blue == light.blue);
+        REQUIRE(restored_light.radius == light.radius);
+    }
+    REQUIRE(rglike::HashRegistry(loaded) == rglike::HashRegistry(registry));
+
+    // A truncated file is rejected rather than half-loaded.
+    bytes.resize(bytes.size() / 2);
+    entt::registry truncated{};
+    REQUIRE(!rglike::DecodeSave(bytes, truncated).has_value());
+    REQUIRE(truncated.alive() == 0);
+}
+
+TEST_CASE("Save sizes", "[world]") {
+    auto varint = [](std::vector<uint8_t>& out, uint64_t value) {
+        for (; value >= 0x80; value >>= 7) { out.push_back(static_cast<uint8_t>(value | 0x80)); }
+        out.push_back(static_cast<uint8_t>(value));
+    };
+    entt::registry registry{};
+    rglike::SaveState state{};
+    rglike::CaptureRegistry(registry, state.registry);
+    auto empty = rglike::EncodeSave(state, rglike::SaveCompression::None);
+    REQUIRE(rglike::DecodeSave(empty, registry).has_value());
+    // Magic, then single-byte version and size varints, then the compression flag.
+    constexpr size_t PAYLOAD = 11;
+    REQUIRE(empty.size() > PAYLOAD);
+    REQUIRE(empty[PAYLOAD - 2] == empty.size() - PAYLOAD);
+
+    // A compressed save claiming to be enormous is refused before anything is allocated.
+    std::vector<uint8_t> huge(empty.begin(), empty.begin() + PAYLOAD - 2);
+    varint(huge, uint64_t{1} << 50U);
+    huge.push_back(static_cast<uint8_t>(rglike::SaveCompression::Zstd));
+    huge.insert(huge.end(), 64, 0);
+    REQUIRE(!rglike::DecodeSave(huge, registry).has_value());
+
+    // So is an entity count larger than there are entities, even when the file is big enough
+    // to hold that many records. The empty save ends with five zero counts: entities, then one
+    // per component.
+    std::vector<uint8_t> raw(empty.begin() + PAYLOAD, empty.end() - 5);
+    constexpr size_t TOO_MANY = (size_t{1} << 20U) + 1;
+    varint(raw, TOO_MANY);
+    raw.insert(raw.end(), TOO_MANY + 4, 0);
+    std::vector<uint8_t> crowded(empty.begin(), empty.begin() + PAYLOAD - 2);
+    varint(crowded, raw.size());
+    crowded.push_back(static_cast<uint8_t>(rglike::SaveCompression::None));
+    crowded.insert(crowded.end(), raw.begin(), raw.end());
+    REQUIRE(!rglike::DecodeSave(crowded, registry).has_value());
+    REQUIRE(registry.alive() == 0);
+
+    // Components whose fields size allocations or feed the scheduler are range checked too.
+    auto refused = [](auto component) {
+        entt::registry source{};
+        source.emplace<decltype(component)>(source.create(), component);
+        rglike::SaveState saved{};
+        rglike::CaptureRegistry(source, saved.registry);
+        auto bytes = rglike::EncodeSave(saved, rglike::SaveCompression::None);
+        entt::registry target{};
+        return !rglike::DecodeSave(bytes, target).has_value();
+    };
+    REQUIRE(!refused(rglike::LightSource{}));
+    REQUIRE(refused(rglike::LightSource{255, 255, 255, 1 << 20}));
+    REQUIRE(refused(rglike::LightSource{255, 255, 255, -1}));
+    REQUIRE(!refused(rglike::Actor{}));
+    REQUIRE(refused(rglike::Actor{1 << 30, 0}));
+    REQUIRE(refused(rglike::Actor{-5, 0}));
+    REQUIRE(refused(rglike::Actor{rglike::NORMAL_SPEED, -(1 << 30)}));
+}
+
+TEST_CASE("World save round trip", "[world]") {
+    using rglike::Actor;
+    using rglike::FactionMember;
+    using rglike::LightSource;
+    using rglike::Position;
+    auto directory = std::filesystem::temp_directory_path();
+    auto path = (directory / "rglike_world_test.save").string();
+    auto autosave = (directory / "rglike_world_test.autosave").string();
+
+    rglike::World world{};
+    world.Initialize(17);
+    for (int i = 0; i < 20; ++i) {
+        auto entity = world.Registry.create();
+        world.Registry.emplace<Position>(entity, world.PlayerPos());
+        world.Registry.emplace<FactionMember>(entity, FactionMember{"bandits"});
+        world.Registry.emplace<Actor>(entity, Actor{50 + i * 10, 0});
+        if (i % 5 == 0) { world.Registry.emplace<LightSource>(entity); }
+    }
+    for (int turn = 0; turn < 10; ++turn) {
+        world.Perceive();
+        world.UpdateFields();
+        world.TakeTurns();
+    }
+    REQUIRE(world.TurnsTaken() > 0);
+
+    REQUIRE(world.Save(path, rglike::SaveCompression::None));
+    rglike::World loaded{};
+    REQUIRE(loaded.Load(path));
+    REQUIRE(loaded.PlayerPos() == world.PlayerPos());
+    REQUIRE(loaded.TurnsTaken() == world.TurnsTaken());
+    REQUIRE(loaded.Turns().Scheduled() == world.Turns().Scheduled());
+    REQUIRE(loaded.StateHash() == world.StateHash());
+
+    // Both carry on taking the same turns, with the energy built up before the save intact.
+    for (int turn = 0; turn < 20; ++turn) {
+        world.Perceive();
+        world.UpdateFields();
+        world.TakeTurns();
+        loaded.Perceive();
+        loaded.UpdateFields();
+        loaded.TakeTurns();
+        REQUIRE(loaded.StateHash() == world.StateHash());
+    }
+
+    // The autosave is on disk as soon as the wait returns.
+    std::filesystem::remove(autosave);
+    world.Autosave(autosave);
+    world.WaitForAutosave();
+    rglike::World autoloaded{};
+    REQUIRE(autoloaded.Load(autosave));
+    REQUIRE(autoloaded.StateHash() == world.StateHash());
+
+    // Requests that pile up while one is being written collapse into the newest.
+    rglike::Autosaver saver{};
+    entt::registry registry{};
+    for (uint64_t seed = 1; seed <= 5; ++seed) {
+        auto state = std::make_unique<rglike::SaveState>();
+        state->seed = seed;
+        rglike::CaptureRegistry(registry, state->registry);
+        saver.Save(autosave, std::move(state), rglike::SaveCompression::None, 0.0);
+    }
+    saver.Wait();
+    std::vector<uint8_t> bytes{};
+    REQUIRE(rglike::ReadSaveFile(autosave, bytes));
+    auto newest = rglike::DecodeSave(bytes, registry);
+    REQUIRE(newest.has_value());
+    REQUIRE(newest->seed == 5);
+    std::filesystem::remove(path);
+    std::filesystem::remove(autosave);
+}
+
+TEST_CASE("Streamed world save", "[world]") {
+    using rglike::Vec2;
+    auto directory = std::filesystem::temp_directory_path();
+    auto region = (directory / "rglike_streamed_world.region").string();
+    auto save = (directory / "rglike_streamed_world.save").string();
+    std::filesystem::remove(region);
+
+    rglike::DungeonSettings settings{};
+    settings.seed = 21;
+    settings.width = 2048;
+    settings.height = 128;
+    Vec2 player{0, 0};
+    {
+        rglike::World world{};
+        world.InitializeStreamed(settings, region);
+        REQUIRE(world.Streaming() != nullptr);
+        REQUIRE_FALSE(world.Map().IsResident(world.Map().ChunksWide() - 1, 0));
+        player = world.PlayerPos();
+        world.Map().SetGlyph(player, U'X');
+        REQUIRE(world.Save(save));
+    }
+
+    // The save points back at the region file, so the level streams again with the edit intact.
+    rglike::World loaded{};
+    REQUIRE(loaded.Load(save));
+    REQUIRE(loaded.Streaming() != nullptr);
+    REQUIRE(loaded.Map().Width() == settings.width);
+    REQUIRE(loaded.PlayerPos() == player);
+    REQUIRE(loaded.Map().Glyph(player) == U'X');
+    REQUIRE(loaded.Streaming()->Stats().generated == 0);
+
+    // Loading an ordinary save afterwards stops streaming.
+    loaded.Initialize(3);
+    REQUIRE(loaded.Save(save));
+    REQUIRE(loaded.Load(save));
+    REQUIRE(loaded.Streaming() == nullptr);
+    std::filesystem::remove(save);
+    std::filesystem::remove(region);
+}
+
+TEST_CASE("Turn scheduler", "[world]") {
+    using rglike::Actor;
+    entt::registry registry{};
+    rglike::TurnScheduler turns{};
+    turns.Connect(registry);
+
+    auto slow = registry.create();
+    auto normal = registry.create();
+    auto fast = registry.create();
+    registry.emplace<Actor>(slow, Actor{5, 0});
+    registry.emplace<Actor>(normal, Actor{10, 0});
+    registry.emplace<Actor>(fast, Actor{20, 0});
+    REQUIRE(turns.Scheduled() == 3);
+
+    std::map<entt::entity, int> taken{};
+    const auto run = [&](uint64_t until) {
+        for (auto entity = turns.Pop(registry, until); entity != entt::null;
+             entity = turns.Pop(registry, until)) {
+            REQUIRE(registry.get<Actor>(entity).energy >= rglike::ACTION_COST);
+            ++taken[entity];
+            turns.Spend(registry, entity);
+        }
+    };
+    run(200);
+    REQUIRE(turns.Now() == 200);
+    REQUIRE(taken[slow] == 9);
+    REQUIRE(taken[normal] == 19);
+    REQUIRE(taken[fast] == 39);
+
+    // A very expensive action sends the actor past the end of the wheel.
+    taken.clear();
+    registry.destroy(normal);
+    registry.destroy(fast);
+    REQUIRE(turns.Pop(registry, 1000) == slow);
+    turns.Spend(registry, slow, 100'000);
+    run(1000);
+    REQUIRE(taken.empty());
+    REQUIRE(turns.Scheduled() == 1);
+    run(20'201);
+    REQUIRE(taken[slow] == 1);
+
+    turns.Disconnect(registry);
+}
+
+TEST_CASE("Thread pool", "[world]") {
+    rglike::ThreadPool pool{3};
+
+    // A throwing task still finishes its group, and the waiter gets the exception.
+    rglike::ThreadPool::TaskGroup group{};
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 64; ++i) {
+        pool.Submit(group, [&, i](size_t) {
+            ++ran;
+            if (i % 16 == 0) { throw std::runtime_error("task failed"); }
+        });
+    }
+    REQUIRE_THROWS_AS(pool.Wait(group), std::runtime_error);
+    REQUIRE(ran == 64);
+    REQUIRE_NOTHROW(pool.Wait(group));
+
+    // Likewise for ParallelFor, whichever thread's range throws.
+    for (size_t failing : {size_t{0}, size_t{900}}) {
+        REQUIRE_THROWS_AS(
+            pool.ParallelFor(
+                1000, 10,
+                [&](size_t begin, size_t, size_t) {
+                    if (begin == failing) { throw std::runtime_error("range failed"); }
+                }
+            ),
+            std::runtime_error
+        );
+    }
+
+    // The pool is still usable afterwards.
+    std::atomic<size_t> total{0};
+    pool.ParallelFor(1000, 10, [&](size_t begin, size_t end, size_t) { total += end - begin; });
+    REQUIRE(total == 1000);
+}
+
+TEST_CASE("System graph", "[world]") {
+    using rglike::Actor;
+    using rglike::FactionMember;
+    using rglike::Position;
+    using rglike::SystemAccess;
+    using rglike::ThreadPool;
+    using rglike::Vec2;
+
+    struct FactionTotals {
+        std::map<std::string, int64_t> x;
+    };
+
+    const auto simulate = [](size_t threads) {
+        entt::registry registry{};
+        for (int i = 0; i < 5000; ++i) {
+            auto entity = registry.create();
+            registry.emplace<Position>(entity, Vec2{i % 97, i / 97});
+            registry.emplace<Actor>(entity, Actor{i % 17 + 1, 0});
+            if (i % 4 != 0) {
+                registry.emplace<FactionMember>(entity, FactionMember{i % 2 ? "bandits" : "rats"});
+            }
+        }
+
+        FactionTotals totals{};
+        rglike::SystemGraph graph{};
+        graph.Add("regen", SystemAccess{}.Write<Actor>(), [](entt::registry& r, ThreadPool& pool) {
+            rglike::ParallelEach<Actor>(r, pool, 256, [](entt::entity, Actor& actor) {
+                actor.energy += actor.speed;
+            });
+        });
+        graph.Add(
+            "drift", SystemAccess{}.Read<Actor>().Write<Position>(),
+            [](entt::registry& r, ThreadPool& pool) {
+                rglike::ParallelEach<Position, Actor>(
+                    r, pool, 256,
+                    [](entt::entity, Position& position, const Actor& actor) {
+                        position.pos = position.pos + Vec2{actor.energy % 3 - 1, 0};
+                    }
+                );
+            }
+        );
+        graph.Add(
+            "totals", SystemAccess{}.Read<Position, FactionMember>().WriteResource<FactionTotals>(),
+            [&](entt::registry& r, ThreadPool&) {
+                for (auto entity : r.view<FactionMember>()) {
+                    auto x = r.get<Position>(entity).pos.X();
+                    totals.x[r.get<FactionMember>(entity).faction] += x;
+                }
+            }
+        );
+        graph.Add(
+            "defect", SystemAccess{}.Read<Position>().Write<FactionMember>(),
+            [](entt::registry& r, ThreadPool& pool) {
+                rglike::ParallelEach<Position, FactionMember>(
+                    r, pool, 256,
+                    [](entt::entity, const Position& position, FactionMember& member) {
+                        if (position.pos.X() % 50 == 0) { member.faction = "deserters"; }
+                    }
+                );
+            }
+        );
+        graph.Add("tire", SystemAccess{}.Write<Actor>(), [](entt::registry& r, ThreadPool&) {
+            for (auto entity : r.view<Actor>()) { r.get<Actor>(entity).energy /= 2; }
+        });
+
+        REQUIRE(graph.Dependencies(0) == 0);
+        REQUIRE(graph.Dependencies(1) == 1);
+        REQUIRE(graph.Dependencies(2) == 1);
+        REQUIRE(graph.Dependencies(3) == 2);
+        REQUIRE(graph.Dependencies(4) == 2);
+
+        ThreadPool pool{threads};
+        for (int turn = 0; turn < 20; ++turn) { graph.Run(registry, pool); }
+        return std::make_pair(rglike::HashRegistry(registry), totals.x);
+    };
+
+    auto serial = simulate(0);
+    auto parallel = simulate(4);
+    REQUIRE(serial.first == parallel.first);
+    REQUIRE(serial.second == parallel.second);
+    REQUIRE(simulate(2).first == serial.first);
+}
+
+TEST_CASE("Geometry kernels", "[world]") {
+    using rglike::LineKind;
+    using rglike::PositionBuffer;
+    using rglike::SimdLevel;
+    using rglike::Vec2;
+
+    SECTION("Lines") {
+        PositionBuffer line{};
+        rglike::TraceLine(Vec2{0, 0}, Vec2{7, -3}, LineKind::Bresenham, line);
+        REQUIRE(line.Size() == 8);
+        REQUIRE(line.At(0) == Vec2{0, 0});
+        REQUIRE(line.At(7) == Vec2{7, -3});
+
+        PositionBuffer cover{};
+        rglike::TraceLine(Vec2{0, 0}, Vec2{7, -3}, LineKind::Supercover, cover);
+        REQUIRE(cover.At(cover.Size() - 1) == Vec2{7, -3});
+        for (size_t i = 1; i < cover.Size(); ++i) {
+            auto step = cover.At(i) - cover.At(i - 1);
+            REQUIRE(std::abs(step.X()) + std::abs(step.Y()) <= 2);
+        }
+
+        // A perfect diagonal passes through corners, so the supercover takes both neighbours.
+        cover.Clear();
+        rglike::TraceLine(Vec2{0, 0}, Vec2{2, 2}, LineKind::Supercover, cover);
+        REQUIRE(cover.Size() == 7);
+
+        std::vector<uint32_t> offsets{};
+        PositionBuffer batch{};
+        rglike::TraceLines(
+            {Vec2{0, 0}, Vec2{5, 5}}, {Vec2{3, 0}, Vec2{5, 5}}, LineKind::Bresenham, batch, offsets
+        );
+        REQUIRE(offsets == std::vector<uint32_t>{0, 4, 5});
+    }
+
+    SECTION("Areas") {
+        PositionBuffer circle{};
+        rglike::RasterizeCircle(Vec2{10, 10}, 0, circle);
+        REQUIRE(circle.Size() == 1);
+        circle.Clear();
+        rglike::RasterizeCircle(Vec2{10, 10}, 3, circle);
+        REQUIRE(circle.Size() == 37);
+
+        PositionBuffer cone{};
+        rglike::RasterizeCone(Vec2{0, 0}, Vec2{5, 0}, 3, 45.0, cone);
+        REQUIRE(cone.Size() > 0);
+        for (size_t i = 0; i < cone.Size(); ++i) {
+            auto pos = cone.At(i);
+            REQUIRE(pos.X() > 0);
+            REQUIRE(std::abs(pos.Y()) <= pos.X());
+        }
+    }
+
+    SECTION("Batched kernels match at every SIMD level") {
+        PositionBuffer positions{};
+        for (int i = 0; i < 1003; ++i) {
+            positions.Push(Vec2{(i * 37) % 211 - 100, (i * 53) % 197 - 90});
+        }
+        const rglike::Rect bounds{Vec2{-20, -30}, Vec2{40, 25}};
+        const Vec2 from{7, -4};
+
+        const auto run = [&](SimdLevel level) {
+            std::vector<int32_t> chebyshev(positions.Size());
+            std::vector<int32_t> manhattan(positions.Size());
+            std::vector<uint64_t> keys(positions.Size());
+            std::vector<uint32_t> inside{};
+            rglike::ChebyshevDistances(positions, from, chebyshev.data(), level);
+            rglike::ManhattanDistances(positions, from, manhattan.data(), level);
+            rglike::PackPositions(positions, keys.data(), level);
+            rglike::SelectInRect(positions, bounds, inside, level);
+            return std::make_tuple(chebyshev, manhattan, keys, inside);
+        };
+
+        auto expected = run(SimdLevel::Scalar);
+        const auto& [chebyshev, manhattan, keys, inside] = expected;
+        for (size_t i = 0; i < positions.Size(); ++i) {
+            auto delta = positions.At(i) - from;
+            REQUIRE(chebyshev[i] == std::max(std::abs(delta.X()), std::abs(delta.Y())));
+            REQUIRE(manhattan[i] == std::abs(delta.X()) + std::abs(delta.Y()));
+            REQUIRE(rglike::UnpackVec2(keys[i]) == positions.At(i));
+        }
+        size_t contained = 0;
+        for (size_t i = 0; i < positions.Size(); ++i) {
+            contained += bounds.Contains(positions.At(i)) ? 1 : 0;
+        }
+        REQUIRE(inside.size() == contained);
+        for (auto index : inside) { REQUIRE(bounds.Contains(positions.At(index))); }
+
+        REQUIRE(run(SimdLevel::Sse2) == expected);
+        REQUIRE(run(SimdLevel::Avx2) == expected);
+    }
+}
+
+TEST_CASE("Replay round trip", "[world]") {
+    auto path = (std::filesystem::temp_directory_path() / "rglike_test.replay").string();
+    const std::vector<ftxui::Event> moves{
+        ftxui::Event::ArrowUp,
+        ftxui::Event::ArrowRight,
+        ftxui::Event::ArrowDown,
+        ftxui::Event::ArrowLeft,
+    };
+
+    rglike::World world{};
+    world.Initialize(99);
+    rglike::ReplayRecorder recorder{};
+    REQUIRE(recorder.Start(path, 99));
+    for (size_t i = 0; i < 200; ++i) {
+        auto event = moves[(i * 7 + i / 3) % moves.size()];
+        if (rglike::ApplyInput(world, event)) { recorder.Record(event); }
+    }
+    recorder.Finish(world.StateHash());
+
+    auto replay = rglike::LoadReplay(path);
+    REQUIRE(replay.has_value());
+    REQUIRE(replay->seed == 99);
+    REQUIRE(replay->events.size() == 200);
+    REQUIRE(replay->inputs.size() == moves.size());
+    REQUIRE(replay->final_hash == world.StateHash());
+
+    rglike::World replayed{};
+    replayed.Initialize(replay->seed);
+    rglike::PlayReplay(replayed, *replay);
+    REQUIRE(replayed.PlayerPos() == world.PlayerPos());
+    REQUIRE(replayed.StateHash() == world.StateHash());
+
+    // A session that was cut off still replays, just without a hash to check against.
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 9);
+    auto cut = rglike::LoadReplay(path);
+    REQUIRE(cut.has_value());
+    REQUIRE(!cut->final_hash.has_value());
+    REQUIRE(cut->events.size() == 200);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Particles", "[world]") {
+    using namespace std::chrono_literals;
+    using rglike::ParticleClock;
+
+    auto spec = rglike::ParseParticleSpec("▓;#00FFFF;400.0");
+    REQUIRE(spec.has_value());
+    REQUIRE(spec->glyph == U'▓');
+    REQUIRE(spec->color == ftxui::Color::RGB(0, 255, 255));
+    REQUIRE(spec->lifetime == 400ms);
+    REQUIRE(rglike::ParseParticleSpec("*;#ff8000;12.5")->lifetime == 12500us);
+    REQUIRE(!rglike::ParseParticleSpec("▓▓;#00FFFF;400"));
+    REQUIRE(!rglike::ParseParticleSpec("▓;00FFFF;400"));
+    REQUIRE(!rglike::ParseParticleSpec("▓;#00FFFF"));
+    REQUIRE(!rglike::ParseParticleSpec("▓;#00FFFF;-4"));
+
+    rglike::ParticleLibrary library;
+    rglike::DefineBaseParticles(library);
+    auto missile = library.Find("mmissile");
+    REQUIRE(missile.has_value());
+    REQUIRE(library.Glyph(*missile) == "▓");
+    REQUIRE(!library.Define("broken", "nope"));
+    REQUIRE(!library.Find("broken"));
+
+    auto now = ParticleClock::time_point{};
+    rglike::ParticlePool pool(4);
+    REQUIRE(pool.Capacity() == 4);
+    for (int i = 0; i < 4; ++i) { REQUIRE(pool.Spawn(library, *missile, rglike::Vec2{i, 0}, now)); }
+    REQUIRE(!pool.Spawn(library, *missile, rglike::Vec2{9, 9}, now));
+    REQUIRE(pool.Size() == 4);
+    REQUIRE(pool.Capacity() == 4);
+
+    pool.Update(now + 399ms);
+    REQUIRE(pool.Size() == 4);
+    pool.Update(now + 400ms);
+    REQUIRE(pool.Empty());
+
+    rglike::ParticlePool line;
+    REQUIRE(line.SpawnLine(library, *missile, rglike::Vec2{0, 0}, rglike::Vec2{4, 2}, now) == 5);
+    auto visible = [&](ParticleClock::time_point at) {
+        size_t count = 0;
+        line.ForEachVisible(at, [&](const rglike::Particle&, float remaining) {
+            REQUIRE(remaining > 0.0F);
+            REQUIRE(remaining <= 1.0F);
+            ++count;
+        });
+        return count;
+    };
+    REQUIRE(visible(now) == 1);
+    REQUIRE(visible(now + 2 * std::chrono::milliseconds(rglike::PARTICLE_LINE_STEP_MS)) == 3);
+    REQUIRE(visible(now + 1s) == 0);
+    line.Update(now + 400ms);
+    REQUIRE(line.Size() == 4);
+    line.Update(now + 1s);
+    REQUIRE(line.Empty());
+}
+
+TEST_CASE("Game log ring buffer", "[world]") {
+    auto& log = rglike::GameLog::GetInstance();
+    log.Clear();
+    REQUIRE(log.Capacity() == rglike::MAX_LOG_LINES);
+
+    log.Entry()
+        .Text("Welcome to ")
+        .Color(ftxui::Color::Red)
+        .Bold(true)
+        .Text("rglike")
+        .Color(ftxui::Color::Default)
+        .Bold(false)
+        .Text("!")
+        .Log();
+    REQUIRE(log.Size() == 0);
+    REQUIRE(log.Drain() == 1);
+    REQUIRE(log.Size() == 1);
+    const auto& welcome = log.Line(0);
+    REQUIRE(welcome.Text() == "Welcome to rglike!");
+    REQUIRE(welcome.Fragments().size() == 3);
+    const auto& name = welcome.Fragments()[1];
+    REQUIRE(welcome.Text(name) == "rglike");
+    REQUIRE(log.Color(name.style.color) == ftxui::Color::Red);
+    REQUIRE(name.style.Has(rglike::LogStyle::BOLD));
+    REQUIRE(!welcome.Fragments()[2].style.Has(rglike::LogStyle::BOLD));
+    REQUIRE(welcome.Fragments()[2].style.color == 0);
+
+    // A stale entry can't write into, or commit, the one built after it.
+    auto stale = log.Entry().Text("lost");
+    log.Log("kept");
+    stale.Text("more").Log();
+    REQUIRE(log.Drain() == 1);
+    REQUIRE(log.Size() == 2);
+    REQUIRE(log.Line(0).Text() == "kept");
+
+    std::vector<std::string> lines;
+    for (int i = 0; i < rglike::MAX_LOG_LINES * 2; ++i) {
+        lines.push_back("The goblin hits you for " + std::to_string(100 + i) + " damage.");
+    }
+    for (const auto& line : lines) {
+        REQUIRE(log.Entry().Color(ftxui::Color::Red).Text(line).Log());
+        log.Drain();
+    }
+    REQUIRE(log.Size() == log.Capacity());
+    REQUIRE(log.Line(0).Text() == lines.back());
+    REQUIRE(log.Line(log.Size() - 1).Text() == lines[lines.size() - log.Size()]);
+
+    // Once every buffer has held a line this long, logging another never allocates.
+    auto before = rglike::test::Allocations();
+    for (const auto& line : lines) {
+        log.Entry().Color(ftxui::Color::Red).Text(line).Color(ftxui::Color::Default).Log();
+        log.Drain();
+    }
+    REQUIRE(rglike::test::Allocations() == before);
+
+    // A full queue turns entries away until the UI thread catches up.
+    for (int i = 0; i < rglike::LOG_QUEUE_CAPACITY; ++i) { REQUIRE(log.Log(lines[0])); }
+    auto overflow = log.Entry().Text("overflow");
+    REQUIRE(!overflow.Log());
+    REQUIRE(log.Drain() == rglike::LOG_QUEUE_CAPACITY);
+    REQUIRE(overflow.Log());
+    REQUIRE(log.Drain() == 1);
+    REQUIRE(log.Line(0).Text() == "overflow");
+    log.Clear();
+}
+
+TEST_CASE("Log layout cache", "[world]") {
+    auto& log = rglike::GameLog::GetInstance();
+    log.Clear();
+    log.Entry().Text("The goblin ").Color(ftxui::Color::Red).Text("hits").Text(" you.").Log();
+    log.Log("Welcome!");
+    log.Drain();
+
+    // ":: " and "Welcome!" fit on one row; the goblin wraps before "hits you." at 16 columns.
+    REQUIRE(rglike::ui::LogLayoutCache::Wrap(log, log.Line(0), 0).size() == 1);
+    REQUIRE(rglike::ui::LogLayoutCache::Wrap(log, log.Line(1), 0).size() == 1);
+    REQUIRE(rglike::ui::LogLayoutCache::Wrap(log, log.Line(1), 16).size() == 2);
+    REQUIRE(rglike::ui::LogLayoutCache::Wrap(log, log.Line(1), 4).size() == 5);
+
+    rglike::ui::LogLayoutCache cache;
+    REQUIRE(cache.Rows(log, 1, 16).size() == 2);
+    REQUIRE(cache.Rows(log, 0, 16).size() == 1);
+    REQUIRE(cache.Misses() == 2);
+
+    // Logging more shifts the indices, but lines already laid out keep their layout.
+    log.Log("Another line.");
+    log.Drain();
+    REQUIRE(cache.Rows(log, 2, 16).size() == 2);
+    REQUIRE(cache.Rows(log, 1, 16).size() == 1);
+    REQUIRE(cache.Misses() == 2);
+    REQUIRE(cache.Rows(log, 0, 16).size() == 1);
+    REQUIRE(cache.Misses() == 3);
+
+    // Only a change of width lays a line out again.
+    REQUIRE(cache.Rows(log, 2, 40).size() == 1);
+    REQUIRE(cache.Misses() == 4);
+    log.Clear();
+}
+
+TEST_CASE("Game log from many threads", "[world]") {
+    constexpr int producers = 16;
+    constexpr int lines_each = 2000;
+
+    auto& log = rglike::GameLog::GetInstance();
+    log.Clear();
+
+    // Lines read back from the log, newest first within each drain, so reversed per drain.
+    std::vector<std::string> received;
+    std::atomic<int> finished{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            auto color = p % 2 == 0 ? ftxui::Color::Red : ftxui::Color::Blue;
+            for (int i = 0; i < lines_each; ++i) {
+                auto entry = log.Entry().Color(color).Text(std::to_string(p)).Text(":");
+                auto queued = entry.Text(std::to_string(i));
+                while (!queued.Log()) { std::this_thread::yield(); }
+            }
+            finished.fetch_add(1);
+        });
+    }
+
+    auto drain = [&] {
+        auto count = log.Drain();
+        for (size_t i = count; i-- > 0;) { received.emplace_back(log.Line(i).Text()); }
+    };
+    while (finished.load() < producers) {
+        drain();
+        std::this_thread::yield();
+    }
+    for (auto& thread : threads) { thread.join(); }
+    drain();
+
+    REQUIRE(received.size() == static_cast<size_t>(producers * lines_each));
+    std::vector<int> next(producers, 0);
+    for (const auto& line : received) {
+        auto colon = line.find(':');
+        REQUIRE(colon != std::string::npos);
+        auto p = std::stoi(line.substr(0, colon));
+        auto i = std::stoi(line.substr(colon + 1));
+        REQUIRE(i == next[p]);
+        ++next[p];
+    }
+    log.Clear();
+}